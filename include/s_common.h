@@ -96,6 +96,40 @@ struct work_queue_data {
 	UserRequest *ur;
 };
 
+#define UTIL_CME_ERROR_MAX      265     // +CME ERROR: <err>, 3GPP TS 27.007 9.2
+#define UTIL_CMS_ERROR_MAX      501     // +CMS ERROR: <err>, 3GPP TS 27.005 3.2.5
+
+enum util_at_error_class {
+	UTIL_AT_ERROR_PERMANENT,    // Fails again until something else changes
+	UTIL_AT_ERROR_RETRYABLE,    // Modem, SIM or network busy, may succeed later
+	UTIL_AT_ERROR_LOCKED,       // Needs a PIN, PUK or personalisation key first
+};
+
+// Decoded final response of a failed AT command
+struct util_at_error {
+	gboolean cms;               // +CMS ERROR, otherwise +CME ERROR or plain ERROR
+	int code;                   // -1 if the modem gave none
+	enum util_at_error_class error_class;
+	TReturn result;             // For call, SS and modem responses
+	int sms_result;             // enum telephony_sms_Response for SMS responses
+};
+
+enum util_sim_file_structure {
+	UTIL_SIM_FILE_UNKNOWN,
+	UTIL_SIM_FILE_TRANSPARENT,
+	UTIL_SIM_FILE_LINEAR_FIXED,
+	UTIL_SIM_FILE_CYCLIC,
+};
+
+// File control parameters of an EF, from an AT+CRSM GET RESPONSE
+struct util_sim_fcp {
+	unsigned short file_id;
+	enum util_sim_file_structure structure;
+	int file_size;              // Body size, record_len * record_count for record EFs
+	int record_len;             // 0 for transparent EFs
+	int record_count;
+};
+
 #define UTIL_ID(hdr)        ((hdr).main_cmd << 8 | (hdr).sub_cmd)
 #define UTIL_IDP(hdr)       ((hdr)->main_cmd << 8 | (hdr)->sub_cmd)
 
@@ -107,5 +141,9 @@ void util_hex_dump(char *pad, int size, const void *data);
 unsigned char util_hexCharToInt(char c);
 char* util_hexStringToBytes(char *s);
 char* util_removeQuotes(void *data);
+void util_at_error_decode(const char *final_response, struct util_at_error *error);
+TReturn util_at_error_result(const char *final_response);
+int util_at_error_sms_result(const char *final_response);
+gboolean util_sim_fcp_decode(const char *hex, gboolean usim, struct util_sim_fcp *fcp);
 
 #endif
@@ -23,5 +23,6 @@
 
 gboolean s_sim_init(TcorePlugin *p, TcoreHal *h);
 void s_sim_exit(TcorePlugin *p);
+void s_sim_ef_cache_invalidate(CoreObject *o);
 
 #endif
@@ -30,6 +30,7 @@
 #include <plugin.h>
 #include <queue.h>
 #include <co_call.h>
+#include <co_sim.h>
 #include <user_request.h>
 #include <server.h>
 #include <at.h>
@@ -38,13 +39,22 @@
 #include "s_call.h"
 
 
+#define STATUS_DIALING     2
 #define STATUS_INCOMING    4
 #define STATUS_WAITING     5
+#define STATUS_DISCONNECTED    6
 #define STATUS_CONNECTED   7
 #define COMMA              0X2c
 
-static gboolean setsoundpath = FALSE;
-static gboolean soundvolume = FALSE;
+#define CALL_CLIP_WAIT_MS          500  // +CLIP follows RING, fall back to AT+CLCC after this
+#define CALL_CLIP_NUMBER_LEN       90
+#define CALL_DTMF_TONE_DURATION    3    // +VTD=<n>, n * 1/10 secs, ~300 mili secs
+#define CALL_AUDIO_VALUE_LEN       32
+#define CALL_ID_MAX                7    // Modem call ids are 1..7
+#define CALL_CLCC_TIMEOUT_SEC      10   // AT+CLCC unanswered after this is given up
+#define CALL_STATUS_BIT(status)    (1 << (status))
+#define CALL_TRACE_EVENTS_MAX      32   // Per call, later events are only counted
+#define CALL_TRACE_BUCKETS         8    // 100 ms, doubling, last one open ended
 
 // End Cause field  - Call state end cause
 
@@ -186,10 +196,129 @@ struct clcc_call_t {
 	char number[90];
 };
 
-typedef struct {
-	int network_cause;
-	int tapi_cause;
-} call_end_cause_info;
+#define CALL_END_NETWORK_CAUSE_MAX    128  // GSM 04.08 cause values are 7 bits
+
+struct call_clip_info {
+	gboolean valid;
+	enum tcore_call_cli_mode mode;
+	char number[CALL_CLIP_NUMBER_LEN];
+};
+
+// Plugin side call state, linked as "CALLPROPERTY"
+// Audio driver settings written with AT+XDRV=40,<function_id>,<type>,<values>
+enum call_audio_setting {
+	CALL_AUDIO_SOURCE_PATH,
+	CALL_AUDIO_DESTINATION_PATH,
+	CALL_AUDIO_SOURCE_VOLUME,
+	CALL_AUDIO_SOURCE_VOLUME_0,
+	CALL_AUDIO_DESTINATION_VOLUME_0,    // Mute and unmute use it too
+	CALL_AUDIO_DESTINATION_VOLUME,
+	CALL_AUDIO_SETTING_MAX
+};
+
+static const char *call_audio_xdrv_cmd[CALL_AUDIO_SETTING_MAX] = {
+	[CALL_AUDIO_SOURCE_PATH] = "AT+XDRV=40,4,3",
+	[CALL_AUDIO_DESTINATION_PATH] = "AT+XDRV=40,5,2",
+	[CALL_AUDIO_SOURCE_VOLUME] = "AT+XDRV=40,7,3",
+	[CALL_AUDIO_SOURCE_VOLUME_0] = "AT+XDRV=40,7,0",
+	[CALL_AUDIO_DESTINATION_VOLUME_0] = "AT+XDRV=40,8,0",
+	[CALL_AUDIO_DESTINATION_VOLUME] = "AT+XDRV=40,8,2",
+};
+
+struct call_audio_write {
+	enum call_audio_setting setting;
+	const char *value;
+};
+
+// AT+XDRV commands of one audio request, queued back to back
+struct call_audio_batch {
+	enum tcore_response_command command;
+	struct call_audio_write writes[CALL_AUDIO_SETTING_MAX];
+	unsigned int count;
+	unsigned int done;
+	gboolean queued;                // Every command is queued, the last one carries the user request
+	int err;
+};
+
+// AT+CHLD operations whose outcome is predicted, see _call_chld_done()
+enum call_chld_op {
+	CALL_CHLD_SWAP,             // AT+CHLD=2: hold, active and swap
+	CALL_CHLD_JOIN,             // AT+CHLD=3
+	CALL_CHLD_SPLIT,            // AT+CHLD=2x
+};
+
+// Call setup/release timeline, see _call_trace_add()
+enum call_trace_stage {
+	CALL_TRACE_DIAL,            // s_call_outgoing
+	CALL_TRACE_XCALLSTAT,       // detail: +XCALLSTAT <stat>
+	CALL_TRACE_CLCC_REQUEST,
+	CALL_TRACE_CLCC_RESPONSE,
+	CALL_TRACE_NOTI,            // detail: notified enum tcore_call_status
+	CALL_TRACE_XCEER,           // detail: TAPI end cause
+};
+
+static const char *call_trace_stage_name[] = {
+	[CALL_TRACE_DIAL] = "DIAL",
+	[CALL_TRACE_XCALLSTAT] = "XCALLSTAT",
+	[CALL_TRACE_CLCC_REQUEST] = "CLCC_REQ",
+	[CALL_TRACE_CLCC_RESPONSE] = "CLCC_RESP",
+	[CALL_TRACE_NOTI] = "NOTI",
+	[CALL_TRACE_XCEER] = "XCEER",
+};
+
+// Numbers treated as emergency besides the SIM EF-ECC (3GPP TS 22.101)
+static const char *call_ecc_default[] = { "112", "911" };
+static const char *call_ecc_no_sim[] = { "000", "08", "110", "118", "119", "999" };
+
+struct call_trace_event {
+	guint32 offset_ms;          // Since the first event of the call
+	guint8 stage;
+	gint8 detail;
+};
+
+struct call_trace {
+	gboolean open;
+	gint64 start;               // g_get_monotonic_time() of the first event
+	gint64 release_at;          // +XCALLSTAT disconnected, 0 if not yet
+	gboolean is_mo;
+	gboolean setup_done;        // MO setup or MT alerting already accounted
+	unsigned int count;
+	unsigned int dropped;
+	struct call_trace_event events[CALL_TRACE_EVENTS_MAX];
+};
+
+struct call_trace_dist {
+	unsigned int count;
+	gint64 total_ms;
+	gint64 max_ms;
+	unsigned int buckets[CALL_TRACE_BUCKETS];
+};
+
+struct call_property {
+	struct call_clip_info clip;     // +CLIP received before the call object was created
+	int mt_pending_id;              // MT call waiting for +CLIP to be notified, 0 if none
+	guint mt_fallback_timer;
+	gboolean clcc_in_flight;        // Only one AT+CLCC at a time
+	gboolean clcc_followup;         // Triggers arrived meanwhile, one more AT+CLCC is due
+	gboolean clcc_followup_notify;  // ... and at least one of them wants status notifications
+	gboolean dtmf_duration_valid;   // dtmf_duration is what the modem currently uses
+	int dtmf_duration;
+	char audio[CALL_AUDIO_SETTING_MAX][CALL_AUDIO_VALUE_LEN];  // Last value written per setting, "" if unknown
+	gint64 trace_dial_at;           // MO dial requested, call id not known yet
+	struct call_trace traces[CALL_ID_MAX + 1];
+	struct call_trace_dist mo_setup;    // Dial request to ACTIVE notified
+	struct call_trace_dist mt_alert;    // First +XCALLSTAT to INCOMING notified
+	struct call_trace_dist release;     // +XCALLSTAT disconnected to IDLE notified
+	gint64 ecc_dial_at;                 // Emergency dial queued, until its ATD is written
+	struct call_trace_dist ecc_dial;    // Emergency dial request to ATD written
+	int chld_in_flight;                 // AT+CHLD sent, confirmation pending
+	gboolean chld_overlap;              // AT+CHLD sent while another was pending
+	enum tcore_call_status chld_before[CALL_ID_MAX + 1];    // Call table when AT+CHLD was sent
+	enum tcore_call_status chld_seen[CALL_ID_MAX + 1];      // +XCALLSTAT received ahead of the OK
+	enum tcore_call_status chld_expect[CALL_ID_MAX + 1];    // Predicted, +XCALLSTAT not received yet
+	CallObject *slots[CALL_ID_MAX + 1];         // Call objects by modem call id
+	struct clcc_call_t clcc[CALL_ID_MAX];       // Parse buffers reused by every +CLCC response
+};
 
 /**************************************************************************
   *							Local Function Prototypes
@@ -202,7 +331,9 @@ static void _call_status_alert(TcorePlugin *p, CallObject *co);
 static void _call_status_incoming(TcorePlugin *p, CallObject *co);
 static void _call_status_waiting(TcorePlugin *p, CallObject *co);
 static TReturn _call_list_get(CoreObject *o, gboolean *event_flag);
-static TReturn _set_dtmf_tone_duration(CoreObject *o, UserRequest *ur);
+static TReturn _call_audio_apply(CoreObject *o, UserRequest *ur, enum tcore_response_command command,
+								const struct call_audio_write *writes, unsigned int count);
+static TReturn _set_dtmf_tone_duration(CoreObject *o, int duration);
 
 /*************************		CONFIRMATION		***************************/
 static void on_confirmation_call_message_send(TcorePending *p, gboolean result, void *user_data);     // from Kernel
@@ -218,6 +349,7 @@ static void _on_confirmation_call_end_cause(TcorePending *p, int data_len, const
 
 /*************************		RESPONSES		***************************/
 static void on_response_call_list_get(TcorePending *p, int data_len, const void *data, void *user_data);
+static void on_timeout_call_list_get(TcorePending *p, void *user_data);
 
 /*************************		NOTIIFICATIONS		***************************/
 static void on_notification_call_waiting(CoreObject *o, const void *data, void *user_data);
@@ -231,6 +363,8 @@ static gboolean on_notification_call_clip_info(CoreObject *o, const void *data,
   *							Local Utility Function Prototypes
   **************************************************************************/
 static gboolean _call_request_message(TcorePending *pending, CoreObject *o, UserRequest *ur, void *on_resp, void *user_data);
+static gboolean _call_request_message_with_priority(TcorePending *pending, CoreObject *o, UserRequest *ur,
+													void *on_resp, void *user_data, enum tcore_pending_priority priority);
 static void _call_branch_by_status(TcorePlugin *p, CallObject *co, unsigned int status);
 static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call);
 
@@ -238,34 +372,272 @@ static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call);
   *							Local Function Definitions
   **************************************************************************/
 
-const call_end_cause_info call_end_cause_table[] =   // call end cause table to convert Netwotk cause to TAPI cause
-{
-	{ 1, CC_CAUSE_UNASSIGNED_NUMBER}, { 3, CC_CAUSE_NO_ROUTE_TO_DEST},
-	{ 6, CC_CAUSE_CHANNEL_UNACCEPTABLE}, { 8, CC_CAUSE_OPERATOR_DETERMINED_BARRING},
-	{ 16, CC_CAUSE_NORMAL_CALL_CLEARING}, { 17, CC_CAUSE_USER_BUSY},
-	{ 18, CC_CAUSE_NO_USER_RESPONDING}, { 19, CC_CAUSE_USER_ALERTING_NO_ANSWER},
-	{ 21, CC_CAUSE_CALL_REJECTED}, { 22, CC_CAUSE_NUMBER_CHANGED},
-	{ 26, CC_CAUSE_NON_SELECTED_USER_CLEARING}, { 27, CC_CAUSE_DESTINATION_OUT_OF_ORDER},
-	{ 28, CC_CAUSE_INVALID_NUMBER_FORMAT}, { 29, CC_CAUSE_FACILITY_REJECTED},
-	{ 30, CC_CAUSE_RESPONSE_TO_STATUS_ENQUIRY}, { 31, CC_CAUSE_NORMAL_UNSPECIFIED},
-	{ 34, CC_CAUSE_NO_CIRCUIT_CHANNEL_AVAILABLE}, { 38, CC_CAUSE_NETWORK_OUT_OF_ORDER},
-	{ 41, CC_CAUSE_TEMPORARY_FAILURE}, { 42, CC_CAUSE_SWITCHING_EQUIPMENT_CONGESTION},
-	{ 43, CC_CAUSE_ACCESS_INFORMATION_DISCARDED}, { 44, CC_CAUSE_REQUESTED_CIRCUIT_CHANNEL_NOT_AVAILABLE},
-	{ 47, CC_CAUSE_RESOURCES_UNAVAILABLE_UNSPECIFIED}, { 49, CC_CAUSE_QUALITY_OF_SERVICE_UNAVAILABLE},
-	{ 50, CC_CAUSE_REQUESTED_FACILITY_NOT_SUBSCRIBED}, { 55, CC_CAUSE_INCOMING_CALL_BARRED_WITHIN_CUG},
-	{ 57, CC_CAUSE_BEARER_CAPABILITY_NOT_AUTHORISED}, { 58, CC_CAUSE_BEARER_CAPABILITY_NOT_PRESENTLY_AVAILABLE},
-	{ 63, CC_CAUSE_SERVICE_OR_OPTION_NOT_AVAILABLE}, { 65, CC_CAUSE_BEARER_SERVICE_NOT_IMPLEMENTED},
-	{ 68, CC_CAUSE_ACM_GEQ_ACMMAX}, { 69, CC_CAUSE_REQUESTED_FACILITY_NOT_IMPLEMENTED},
-	{ 70, CC_CAUSE_ONLY_RESTRICTED_DIGITAL_INFO_BC_AVAILABLE}, { 79, CC_CAUSE_SERVICE_OR_OPTION_NOT_IMPLEMENTED},
-	{ 81, CC_CAUSE_INVALID_TRANSACTION_ID_VALUE}, { 87, CC_CAUSE_USER_NOT_MEMBER_OF_CUG},
-	{ 88, CC_CAUSE_INCOMPATIBLE_DESTINATION}, { 91, CC_CAUSE_INVALID_TRANSIT_NETWORK_SELECTION},
-	{ 95, CC_CAUSE_SEMANTICALLY_INCORRECT_MESSAGE}, { 96, CC_CAUSE_INVALID_MANDATORY_INFORMATION},
-	{ 97, CC_CAUSE_MESSAGE_TYPE_NON_EXISTENT}, { 98, CC_CAUSE_MESSAGE_TYPE_NOT_COMPATIBLE_WITH_PROT_STATE},
-	{ 99, CC_CAUSE_IE_NON_EXISTENT_OR_NOT_IMPLEMENTED}, { 100, CC_CAUSE_CONDITIONAL_IE_ERROR},
-	{ 101, CC_CAUSE_MESSAGE_NOT_COMPATIBLE_WITH_PROTOCOL_STATE}, { 102, CC_CAUSE_RECOVERY_ON_TIMER_EXPIRY},
-	{ 111, CC_CAUSE_PROTOCOL_ERROR_UNSPECIFIED}, {127, CC_CAUSE_INTERWORKING_UNSPECIFIED},
+// Network cause to TAPI cause, indexed by the network cause
+static const struct {
+	gboolean valid;
+	int tapi_cause;
+} call_end_cause_table[CALL_END_NETWORK_CAUSE_MAX] = {
+	[1] = {TRUE, CC_CAUSE_UNASSIGNED_NUMBER}, [3] = {TRUE, CC_CAUSE_NO_ROUTE_TO_DEST},
+	[6] = {TRUE, CC_CAUSE_CHANNEL_UNACCEPTABLE}, [8] = {TRUE, CC_CAUSE_OPERATOR_DETERMINED_BARRING},
+	[16] = {TRUE, CC_CAUSE_NORMAL_CALL_CLEARING}, [17] = {TRUE, CC_CAUSE_USER_BUSY},
+	[18] = {TRUE, CC_CAUSE_NO_USER_RESPONDING}, [19] = {TRUE, CC_CAUSE_USER_ALERTING_NO_ANSWER},
+	[21] = {TRUE, CC_CAUSE_CALL_REJECTED}, [22] = {TRUE, CC_CAUSE_NUMBER_CHANGED},
+	[26] = {TRUE, CC_CAUSE_NON_SELECTED_USER_CLEARING}, [27] = {TRUE, CC_CAUSE_DESTINATION_OUT_OF_ORDER},
+	[28] = {TRUE, CC_CAUSE_INVALID_NUMBER_FORMAT}, [29] = {TRUE, CC_CAUSE_FACILITY_REJECTED},
+	[30] = {TRUE, CC_CAUSE_RESPONSE_TO_STATUS_ENQUIRY}, [31] = {TRUE, CC_CAUSE_NORMAL_UNSPECIFIED},
+	[34] = {TRUE, CC_CAUSE_NO_CIRCUIT_CHANNEL_AVAILABLE}, [38] = {TRUE, CC_CAUSE_NETWORK_OUT_OF_ORDER},
+	[41] = {TRUE, CC_CAUSE_TEMPORARY_FAILURE}, [42] = {TRUE, CC_CAUSE_SWITCHING_EQUIPMENT_CONGESTION},
+	[43] = {TRUE, CC_CAUSE_ACCESS_INFORMATION_DISCARDED}, [44] = {TRUE, CC_CAUSE_REQUESTED_CIRCUIT_CHANNEL_NOT_AVAILABLE},
+	[47] = {TRUE, CC_CAUSE_RESOURCES_UNAVAILABLE_UNSPECIFIED}, [49] = {TRUE, CC_CAUSE_QUALITY_OF_SERVICE_UNAVAILABLE},
+	[50] = {TRUE, CC_CAUSE_REQUESTED_FACILITY_NOT_SUBSCRIBED}, [55] = {TRUE, CC_CAUSE_INCOMING_CALL_BARRED_WITHIN_CUG},
+	[57] = {TRUE, CC_CAUSE_BEARER_CAPABILITY_NOT_AUTHORISED}, [58] = {TRUE, CC_CAUSE_BEARER_CAPABILITY_NOT_PRESENTLY_AVAILABLE},
+	[63] = {TRUE, CC_CAUSE_SERVICE_OR_OPTION_NOT_AVAILABLE}, [65] = {TRUE, CC_CAUSE_BEARER_SERVICE_NOT_IMPLEMENTED},
+	[68] = {TRUE, CC_CAUSE_ACM_GEQ_ACMMAX}, [69] = {TRUE, CC_CAUSE_REQUESTED_FACILITY_NOT_IMPLEMENTED},
+	[70] = {TRUE, CC_CAUSE_ONLY_RESTRICTED_DIGITAL_INFO_BC_AVAILABLE}, [79] = {TRUE, CC_CAUSE_SERVICE_OR_OPTION_NOT_IMPLEMENTED},
+	[81] = {TRUE, CC_CAUSE_INVALID_TRANSACTION_ID_VALUE}, [87] = {TRUE, CC_CAUSE_USER_NOT_MEMBER_OF_CUG},
+	[88] = {TRUE, CC_CAUSE_INCOMPATIBLE_DESTINATION}, [91] = {TRUE, CC_CAUSE_INVALID_TRANSIT_NETWORK_SELECTION},
+	[95] = {TRUE, CC_CAUSE_SEMANTICALLY_INCORRECT_MESSAGE}, [96] = {TRUE, CC_CAUSE_INVALID_MANDATORY_INFORMATION},
+	[97] = {TRUE, CC_CAUSE_MESSAGE_TYPE_NON_EXISTENT}, [98] = {TRUE, CC_CAUSE_MESSAGE_TYPE_NOT_COMPATIBLE_WITH_PROT_STATE},
+	[99] = {TRUE, CC_CAUSE_IE_NON_EXISTENT_OR_NOT_IMPLEMENTED}, [100] = {TRUE, CC_CAUSE_CONDITIONAL_IE_ERROR},
+	[101] = {TRUE, CC_CAUSE_MESSAGE_NOT_COMPATIBLE_WITH_PROTOCOL_STATE}, [102] = {TRUE, CC_CAUSE_RECOVERY_ON_TIMER_EXPIRY},
+	[111] = {TRUE, CC_CAUSE_PROTOCOL_ERROR_UNSPECIFIED}, [127] = {TRUE, CC_CAUSE_INTERWORKING_UNSPECIFIED},
 };
 
+static struct call_property *_call_ref_property(CoreObject *o)
+{
+	return tcore_plugin_ref_property(tcore_object_ref_plugin(o), "CALLPROPERTY");
+}
+
+static CallObject *_call_slot_find(CoreObject *o, int id)
+{
+	struct call_property *prop = NULL;
+
+	prop = _call_ref_property(o);
+	if (!prop)
+		return tcore_call_object_find_by_id(o, id);
+
+	if (id < 1 || id > CALL_ID_MAX)
+		return NULL;
+
+	return prop->slots[id];
+}
+
+static CallObject *_call_slot_new(CoreObject *o, int id)
+{
+	struct call_property *prop = NULL;
+	CallObject *co = NULL;
+
+	co = tcore_call_object_new(o, id);
+	if (!co)
+		return NULL;
+
+	prop = _call_ref_property(o);
+	if (prop && id >= 1 && id <= CALL_ID_MAX) {
+		if (prop->slots[id])
+			err("call(%d) slot already taken, replacing", id);
+		prop->slots[id] = co;
+	}
+
+	return co;
+}
+
+static void _call_slot_free(CoreObject *o, CallObject *co)
+{
+	struct call_property *prop = NULL;
+	int id;
+
+	id = tcore_call_object_get_id(co);
+	prop = _call_ref_property(o);
+	if (prop && id >= 1 && id <= CALL_ID_MAX && prop->slots[id] == co)
+		prop->slots[id] = NULL;
+
+	tcore_call_object_free(o, co);
+}
+
+// First call, by id, whose status is in 'status_mask' (CALL_STATUS_BIT() of enum tcore_call_status)
+static CallObject *_call_slot_find_by_status(CoreObject *o, unsigned int status_mask)
+{
+	CallObject *co = NULL;
+	int id;
+
+	for (id = 1; id <= CALL_ID_MAX; id++) {
+		co = _call_slot_find(o, id);
+		if (co && (status_mask & CALL_STATUS_BIT(tcore_call_object_get_status(co))))
+			return co;
+	}
+
+	return NULL;
+}
+
+static void _call_trace_dist_add(struct call_trace_dist *dist, const char *name, gint64 ms)
+{
+	gint64 bound = 100;
+	int bucket = 0;
+
+	while (ms >= bound && bucket < CALL_TRACE_BUCKETS - 1) {
+		bound <<= 1;
+		bucket++;
+	}
+
+	dist->count++;
+	dist->total_ms += ms;
+	if (ms > dist->max_ms)
+		dist->max_ms = ms;
+	dist->buckets[bucket]++;
+
+	dbg("%s: %" G_GINT64_FORMAT " ms (avg %" G_GINT64_FORMAT ", max %" G_GINT64_FORMAT ", n %d)"
+		" [<100:%d <200:%d <400:%d <800:%d <1600:%d <3200:%d <6400:%d >=6400:%d]",
+		name, ms, dist->total_ms / dist->count, dist->max_ms, dist->count,
+		dist->buckets[0], dist->buckets[1], dist->buckets[2], dist->buckets[3],
+		dist->buckets[4], dist->buckets[5], dist->buckets[6], dist->buckets[7]);
+}
+
+static void _call_trace_dump(CoreObject *o, int id)
+{
+	struct call_property *prop = NULL;
+	struct call_trace *trace = NULL;
+	unsigned int i;
+
+	prop = _call_ref_property(o);
+	if (!prop || id < 1 || id > CALL_ID_MAX)
+		return;
+
+	trace = &prop->traces[id];
+	dbg("call(%d) timeline: %d events, %d dropped", id, trace->count, trace->dropped);
+	for (i = 0; i < trace->count; i++)
+		dbg("call(%d) +%u ms %s(%d)", id, trace->events[i].offset_ms,
+			call_trace_stage_name[trace->events[i].stage], trace->events[i].detail);
+}
+
+static void _call_trace_close(CoreObject *o, int id)
+{
+	struct call_property *prop = NULL;
+
+	prop = _call_ref_property(o);
+	if (!prop || id < 1 || id > CALL_ID_MAX)
+		return;
+
+	prop->traces[id].open = FALSE;
+}
+
+// Adds a timeline event for call 'id' and feeds the latency distributions
+static void _call_trace_add(CoreObject *o, int id, enum call_trace_stage stage, int detail)
+{
+	struct call_property *prop = NULL;
+	struct call_trace *trace = NULL;
+	struct call_trace_event *event = NULL;
+	gint64 now = g_get_monotonic_time();
+	gboolean starts_call;
+
+	prop = _call_ref_property(o);
+	if (!prop || id < 1 || id > CALL_ID_MAX)
+		return;
+
+	trace = &prop->traces[id];
+
+	// Dialing, incoming or waiting on a released id is a new call
+	starts_call = (stage == CALL_TRACE_XCALLSTAT && (detail == STATUS_DIALING || detail == STATUS_INCOMING || detail == STATUS_WAITING));
+	if (!trace->open || (starts_call && trace->release_at)) {
+		memset(trace, 0, sizeof(struct call_trace));
+		trace->open = TRUE;
+		trace->start = now;
+
+		if (starts_call && detail == STATUS_DIALING && prop->trace_dial_at) {
+			trace->start = prop->trace_dial_at;
+			trace->is_mo = TRUE;
+			trace->events[trace->count].stage = CALL_TRACE_DIAL;
+			trace->count++;
+			prop->trace_dial_at = 0;
+		}
+	}
+
+	if (trace->count < CALL_TRACE_EVENTS_MAX) {
+		event = &trace->events[trace->count++];
+		event->offset_ms = (now - trace->start) / 1000;
+		event->stage = stage;
+		event->detail = detail;
+	} else {
+		trace->dropped++;
+	}
+
+	if (stage == CALL_TRACE_XCALLSTAT && detail == STATUS_DISCONNECTED && !trace->release_at)
+		trace->release_at = now;
+
+	if (stage != CALL_TRACE_NOTI)
+		return;
+
+	if (detail == TCORE_CALL_STATUS_ACTIVE && trace->is_mo && !trace->setup_done) {
+		trace->setup_done = TRUE;
+		_call_trace_dist_add(&prop->mo_setup, "MO setup", (now - trace->start) / 1000);
+	} else if (detail == TCORE_CALL_STATUS_INCOMING && !trace->is_mo && !trace->setup_done) {
+		trace->setup_done = TRUE;
+		_call_trace_dist_add(&prop->mt_alert, "MT alerting", (now - trace->start) / 1000);
+	} else if (detail == TCORE_CALL_STATUS_IDLE && trace->release_at) {
+		_call_trace_dist_add(&prop->release, "Release", (now - trace->release_at) / 1000);
+	}
+}
+
+// AT+CLCC covers every call, record it on all open timelines
+static void _call_trace_add_all(CoreObject *o, enum call_trace_stage stage)
+{
+	struct call_property *prop = NULL;
+	int id;
+
+	prop = _call_ref_property(o);
+	if (!prop)
+		return;
+
+	for (id = 1; id <= CALL_ID_MAX; id++) {
+		if (prop->traces[id].open && !prop->traces[id].release_at)
+			_call_trace_add(o, id, stage, 0);
+	}
+}
+
+static void _call_mt_pending_clear(struct call_property *prop)
+{
+	if (prop->mt_fallback_timer) {
+		g_source_remove(prop->mt_fallback_timer);
+		prop->mt_fallback_timer = 0;
+	}
+	prop->mt_pending_id = 0;
+}
+
+// Notifies an incoming/waiting call once its CLI is known, without AT+CLCC
+static void _call_mt_notify(CoreObject *o, CallObject *co, const struct call_clip_info *clip)
+{
+	gboolean *eflag;
+
+	dbg("Entry");
+
+	tcore_call_object_set_cli_info(co, clip->mode, (char *) clip->number);
+	_call_status_incoming(tcore_object_ref_plugin(o), co);
+
+	// Type, number type and multiparty state are reconciled lazily
+	eflag = g_new0(gboolean, 1);
+	*eflag = FALSE;
+	_call_list_get(o, eflag);
+
+	dbg("Exit");
+}
+
+static gboolean _call_mt_fallback(gpointer user_data)
+{
+	CoreObject *o = user_data;
+	struct call_property *prop = _call_ref_property(o);
+	gboolean *eflag;
+
+	dbg("No +CLIP for call(%d), using AT+CLCC", prop->mt_pending_id);
+
+	prop->mt_fallback_timer = 0;
+	prop->mt_pending_id = 0;
+
+	eflag = g_new0(gboolean, 1);
+	*eflag = TRUE;
+	_call_list_get(o, eflag);
+
+	return FALSE;
+}
+
 static enum tcore_call_cli_mode _get_clir_status(char *num)
 {
 	enum tcore_call_cli_mode clir = CALL_CLI_MODE_DEFAULT;
@@ -352,21 +724,94 @@ static enum tcore_call_type call_type(int type)
 
 static int _compare_call_end_cause(int networkcause)
 {
-	unsigned int count;
-	for (count = 0; count < sizeof(call_end_cause_table) / sizeof(call_end_cause_info); count++) {
-		if (call_end_cause_table[count].network_cause == networkcause)
-			return (call_end_cause_table[count].tapi_cause);
-	}
-	return CC_CAUSE_NORMAL_CALL_CLEARING;
-	dbg("Exit");
+	if (networkcause <= 0 || networkcause >= CALL_END_NETWORK_CAUSE_MAX
+		|| !call_end_cause_table[networkcause].valid)
+		return CC_CAUSE_NORMAL_CALL_CLEARING;
+
+	return call_end_cause_table[networkcause].tapi_cause;
 }
 
 static gboolean on_notification_call_clip_info(CoreObject *o, const void *data, void *user_data)
 {
+	// +CLIP: <number>,<type>[,<subaddr>,<satype>[,<alpha>[,<CLI validity>]]]
+	struct call_property *prop = NULL;
+	struct call_clip_info clip;
+	CallObject *co = NULL;
+	GSList *tokens = NULL;
+	GSList *lines = NULL;
+	const char *line = NULL;
+	char *resp = NULL;
+	char *num = NULL;
+	int num_type = 0;
+
 	dbg("Entry");
 
-	// TODO
+	prop = _call_ref_property(o);
+	lines = (GSList *) data;
+	if (!prop || !lines || !lines->data) {
+		err("Invalid +CLIP indication");
+		return TRUE;
+	}
+
+	line = (char *) (lines->data);
+	tokens = tcore_at_tok_new(line);
+
+	memset(&clip, 0x00, sizeof(struct call_clip_info));
+	clip.valid = TRUE;
+	clip.mode = TCORE_CALL_CLI_MODE_PRESENT;
+
+	resp = g_slist_nth_data(tokens, 5);
+	if (resp) {
+		switch (atoi(resp)) {
+		case 0:
+			clip.mode = TCORE_CALL_CLI_MODE_PRESENT;
+			break;
+
+		case 1:         // withheld by the calling party
+			clip.mode = TCORE_CALL_CLI_MODE_RESTRICT;
+			break;
+
+		default:        // not available
+			clip.mode = CALL_CLI_MODE_DEFAULT;
+			break;
+		}
+	}
+
+	resp = g_slist_nth_data(tokens, 1);
+	if (resp)
+		num_type = atoi(resp);
+
+	resp = g_slist_nth_data(tokens, 0);
+	if (resp) {
+		num = util_removeQuotes(resp);
+		if (num) {
+			// international number
+			if (((num_type >> 4) & 0x07) == 1 && num[0] != '+')
+				snprintf(clip.number, sizeof(clip.number), "+%s", num);
+			else
+				snprintf(clip.number, sizeof(clip.number), "%s", num);
+			g_free(num);
+		}
+	}
+	dbg("CLI mode : [%d], number : [%s]", clip.mode, clip.number);
+
+	tcore_at_tok_free(tokens);
+
+	// +XCALLSTAT came first, the call is only waiting for its number
+	if (prop->mt_pending_id) {
+		co = _call_slot_find(o, prop->mt_pending_id);
+		_call_mt_pending_clear(prop);
+		if (co) {
+			_call_mt_notify(o, co, &clip);
+			return TRUE;
+		}
+	}
 
+	// +CLIP repeats with every RING, keep it only for a call not yet known
+	if (tcore_call_object_current_on_mt_processing(o) == NULL)
+		memcpy(&prop->clip, &clip, sizeof(struct call_clip_info));
+
+	dbg("Exit");
 	return TRUE;
 }
 
@@ -395,6 +840,9 @@ static gboolean on_notification_call_info(CoreObject *o, const void *data, void
 	} else {
 		status = atoi(stat);
 
+		if (g_slist_nth_data(tokens, 0))
+			_call_trace_add(o, atoi(g_slist_nth_data(tokens, 0)), CALL_TRACE_XCALLSTAT, status);
+
 		switch (status) {
 		case STATUS_INCOMING:
 			dbg("calling on_notification_call_incoming");
@@ -430,17 +878,31 @@ static gboolean _call_request_message(TcorePending *pending,
 									  UserRequest *ur,
 									  void *on_resp,
 									  void *user_data)
+{
+	return _call_request_message_with_priority(pending, o, ur, on_resp, user_data, TCORE_PENDING_PRIORITY_DEFAULT);
+}
+
+static gboolean _call_request_message_with_priority(TcorePending *pending,
+													CoreObject *o,
+													UserRequest *ur,
+													void *on_resp,
+													void *user_data,
+													enum tcore_pending_priority priority)
 {
 	TcoreHal *hal = NULL;
 	TReturn ret;
 	dbg("Entry");
 
-	tcore_pending_set_priority(pending, TCORE_PENDING_PRIORITY_DEFAULT);
+	tcore_pending_set_priority(pending, priority);
 
 	if (on_resp) {
 		tcore_pending_set_response_callback(pending, on_resp, user_data);
 	}
-	tcore_pending_set_send_callback(pending, on_confirmation_call_message_send, NULL);
+
+	if (priority == TCORE_PENDING_PRIORITY_IMMEDIATE)
+		tcore_pending_set_send_callback(pending, on_confirmation_call_message_send, o);
+	else
+		tcore_pending_set_send_callback(pending, on_confirmation_call_message_send, NULL);
 
 	if (ur) {
 		tcore_pending_link_user_request(pending, ur);
@@ -461,90 +923,333 @@ static gboolean _call_request_message(TcorePending *pending,
 	return TRUE;
 }
 
-static void _call_status_idle(TcorePlugin *p, CallObject *co)
+// Emergency if the dial asks for it, the SIM lists the number or it is a well known one
+static gboolean _call_is_emergency(CoreObject *o, const struct treq_call_dial *dial)
 {
-	CoreObject *core_obj = NULL;
-	char *cmd_str = NULL;
-	TcorePending *pending = NULL;
-	TcoreATRequest *req = NULL;
-	gboolean ret = FALSE;
-	UserRequest *ur;
-
-	dbg("Entry");
-	core_obj = tcore_plugin_ref_core_object(p, "call");
-	dbg("Call ID [%d], Call Status [%d]", tcore_call_object_get_id(co), tcore_call_object_get_status(co));
+	struct tel_sim_ecc_list *ecc = NULL;
+	CoreObject *co_sim = NULL;
+	enum tel_sim_status sim_status = SIM_STATUS_CARD_NOT_PRESENT;
+	unsigned int i;
 
-	if (tcore_call_object_get_status(co) != TCORE_CALL_STATUS_IDLE) {
-		// get call end cause.
-		cmd_str = g_strdup_printf("%s", "AT+XCEER");
-		dbg("Request command string: %s", cmd_str);
-
-		// Create new Pending request
-		pending = tcore_pending_new(core_obj, 0);
+	if (dial->type == CALL_TYPE_E)
+		return TRUE;
 
-		// Create new AT-Command request
-		req = tcore_at_request_new(cmd_str, "+XCEER", TCORE_AT_SINGLELINE);
-		dbg("Command: %s, prefix(if any): %s, Command length: %d", req->cmd, req->prefix, strlen(req->cmd));
-		// Free command string
-		g_free(cmd_str);
+	ecc = tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMECC");
+	if (ecc) {
+		for (i = 0; i < (unsigned int) ecc->ecc_count && i < SIM_ECC_RECORD_CNT_MAX; i++) {
+			if (ecc->ecc[i].ecc_num[0] && g_strcmp0(ecc->ecc[i].ecc_num, dial->number) == 0)
+				return TRUE;
+		}
+	}
 
-		// Set request data (AT command) to Pending request
-		tcore_pending_set_request_data(pending, 0, req);
+	for (i = 0; i < G_N_ELEMENTS(call_ecc_default); i++) {
+		if (g_strcmp0(call_ecc_default[i], dial->number) == 0)
+			return TRUE;
+	}
 
-		ur = tcore_user_request_new(NULL, NULL);
-		// Send request
-		ret = _call_request_message(pending, core_obj, ur, _on_confirmation_call_end_cause, co);
+	// Without a card these are emergency numbers as well
+	co_sim = tcore_plugin_ref_core_object(tcore_object_ref_plugin(o), "sim");
+	if (co_sim)
+		sim_status = tcore_sim_get_status(co_sim);
+	if (sim_status != SIM_STATUS_CARD_NOT_PRESENT && sim_status != SIM_STATUS_CARD_REMOVED)
+		return FALSE;
 
-		if (!ret) {
-			err("Failed to send AT-Command request");
-			return;
-		}
-	} else {
-		err("Call object was not free");
-		tcore_call_object_free(core_obj, co);
+	for (i = 0; i < G_N_ELEMENTS(call_ecc_no_sim); i++) {
+		if (g_strcmp0(call_ecc_no_sim[i], dial->number) == 0)
+			return TRUE;
 	}
-	dbg("Exit");
-	return;
+
+	return FALSE;
 }
 
-static void _call_status_dialing(TcorePlugin *p, CallObject *co)
+static void _call_chld_reconcile(CoreObject *o)
 {
-	struct tnoti_call_status_dialing data;
-	dbg("Entry");
+	struct call_property *prop = NULL;
+	gboolean *eflag = NULL;
 
-	if (tcore_call_object_get_status(co) != TCORE_CALL_STATUS_DIALING) {
-		data.type = tcore_call_object_get_type(co);
-		dbg("data.type : [%d]", data.type);
+	prop = _call_ref_property(o);
+	if (prop)
+		memset(prop->chld_expect, 0, sizeof(prop->chld_expect));
 
-		data.id = tcore_call_object_get_id(co);
-		dbg("data.id : [%d]", data.id);
+	eflag = g_new0(gboolean, 1);
+	*eflag = TRUE;
 
-		// Set Status
-		tcore_call_object_set_status(co, TCORE_CALL_STATUS_DIALING);
+	dbg("calling _call_list_get");
+	_call_list_get(o, eflag);
+}
 
-		// Send notification to TAPI
-		tcore_server_send_notification(tcore_plugin_ref_server(p),
-									   tcore_plugin_ref_core_object(p, "call"),
-									   TNOTI_CALL_STATUS_DIALING,
-									   sizeof(struct tnoti_call_status_dialing),
-									   (void *) &data);
+// Snapshots the call table the AT+CHLD about to be sent applies to
+static void _call_chld_begin(CoreObject *o)
+{
+	struct call_property *prop = NULL;
+	CallObject *co = NULL;
+	int id;
+
+	prop = _call_ref_property(o);
+	if (!prop)
+		return;
+
+	if (prop->chld_in_flight++) {
+		dbg("AT+CHLD already pending, no prediction");
+		prop->chld_overlap = TRUE;
+		return;
 	}
 
-	dbg("Exit");
-	return;
+	memset(prop->chld_seen, 0, sizeof(prop->chld_seen));
+	memset(prop->chld_expect, 0, sizeof(prop->chld_expect));
+	for (id = 1; id <= CALL_ID_MAX; id++) {
+		co = _call_slot_find(o, id);
+		prop->chld_before[id] = co ? tcore_call_object_get_status(co) : TCORE_CALL_STATUS_IDLE;
+	}
 }
 
-static void _call_status_alert(TcorePlugin *p, CallObject *co)
+// Applies the AT+CHLD outcome (3GPP TS 22.030 6.5.5) to the snapshot, AT+CLCC only when it can't be trusted
+static void _call_chld_done(CoreObject *o, gboolean success, enum call_chld_op op, int split_id)
 {
-	struct tnoti_call_status_alert data;
-	dbg("Entry");
+	struct call_property *prop = NULL;
+	CallObject *co = NULL;
+	enum tcore_call_status status[CALL_ID_MAX + 1] = {0, };
+	gboolean mpty[CALL_ID_MAX + 1] = {0, };
+	gboolean overlap;
+	int members = 0;
+	int id;
+
+	prop = _call_ref_property(o);
+	if (!prop)
+		return;
 
-	// Alerting has just 1 data 'CALL ID'
-	if (tcore_call_object_get_status(co) != TCORE_CALL_STATUS_ALERT) {
-		data.type = tcore_call_object_get_type(co);
-		dbg("data.type : [%d]", data.type);
+	if (prop->chld_in_flight > 0)
+		prop->chld_in_flight--;
 
-		data.id = tcore_call_object_get_id(co);
+	overlap = prop->chld_overlap;
+	if (prop->chld_in_flight == 0)
+		prop->chld_overlap = FALSE;
+
+	if (!success)
+		return;
+
+	if (overlap) {
+		_call_chld_reconcile(o);
+		return;
+	}
+
+	for (id = 1; id <= CALL_ID_MAX; id++) {
+		co = _call_slot_find(o, id);
+		if (!co)
+			continue;
+
+		// A call being set up changes what AT+CHLD does to it
+		if (prop->chld_before[id] != TCORE_CALL_STATUS_ACTIVE && prop->chld_before[id] != TCORE_CALL_STATUS_HELD) {
+			dbg("call(%d) in status (%d), no prediction", id, prop->chld_before[id]);
+			_call_chld_reconcile(o);
+			return;
+		}
+
+		mpty[id] = tcore_call_object_get_multiparty_state(co);
+
+		switch (op) {
+		case CALL_CHLD_SWAP:
+			if (prop->chld_before[id] == TCORE_CALL_STATUS_ACTIVE)
+				status[id] = TCORE_CALL_STATUS_HELD;
+			else
+				status[id] = TCORE_CALL_STATUS_ACTIVE;
+			break;
+
+		case CALL_CHLD_JOIN:
+			status[id] = TCORE_CALL_STATUS_ACTIVE;
+			mpty[id] = TRUE;
+			break;
+
+		case CALL_CHLD_SPLIT:
+			status[id] = prop->chld_before[id];
+			if (id == split_id) {
+				status[id] = TCORE_CALL_STATUS_ACTIVE;
+				mpty[id] = FALSE;
+			} else if (mpty[id]) {
+				status[id] = TCORE_CALL_STATUS_HELD;
+				members++;
+			}
+			break;
+		}
+
+		if (prop->chld_seen[id] && prop->chld_seen[id] != status[id]) {
+			dbg("call(%d) reported (%d), predicted (%d)", id, prop->chld_seen[id], status[id]);
+			_call_chld_reconcile(o);
+			return;
+		}
+	}
+
+	for (id = 1; id <= CALL_ID_MAX; id++) {
+		co = _call_slot_find(o, id);
+		if (!co)
+			continue;
+
+		// The one party left of a split conference is a plain call again
+		if (op == CALL_CHLD_SPLIT && members == 1)
+			mpty[id] = FALSE;
+
+		if (tcore_call_object_get_multiparty_state(co) != mpty[id]) {
+			dbg("Call id : (%d) mpty -> (%d)", id, mpty[id]);
+			tcore_call_object_set_multiparty_state(co, mpty[id]);
+		}
+
+		if (!prop->chld_seen[id])
+			prop->chld_expect[id] = status[id];
+
+		_call_branch_by_status(tcore_object_ref_plugin(o), co, status[id]);
+	}
+}
+
+// Checks a +XCALLSTAT against the predicted call table
+static void _call_chld_observe(CoreObject *o, int id, enum tcore_call_status status)
+{
+	struct call_property *prop = NULL;
+
+	prop = _call_ref_property(o);
+	if (!prop || id < 1 || id > CALL_ID_MAX)
+		return;
+
+	if (!prop->chld_expect[id]) {
+		if (prop->chld_in_flight)
+			prop->chld_seen[id] = status;
+		return;
+	}
+
+	if (prop->chld_expect[id] == status) {
+		prop->chld_expect[id] = 0;
+		return;
+	}
+
+	dbg("call(%d) reported (%d), predicted (%d)", id, status, prop->chld_expect[id]);
+	_call_chld_reconcile(o);
+}
+
+static void _call_status_idle(TcorePlugin *p, CallObject *co)
+{
+	CoreObject *core_obj = NULL;
+	char *cmd_str = NULL;
+	TcorePending *pending = NULL;
+	TcoreATRequest *req = NULL;
+	gboolean ret = FALSE;
+	UserRequest *ur;
+	struct tnoti_call_status_idle call_status;
+	struct call_property *prop = NULL;
+
+	dbg("Entry");
+	core_obj = tcore_plugin_ref_core_object(p, "call");
+	dbg("Call ID [%d], Call Status [%d]", tcore_call_object_get_id(co), tcore_call_object_get_status(co));
+
+	prop = _call_ref_property(core_obj);
+	if (prop) {
+		if (prop->mt_pending_id == tcore_call_object_get_id(co))
+			_call_mt_pending_clear(prop);
+		prop->clip.valid = FALSE;
+	}
+
+	if (tcore_call_object_get_status(co) != TCORE_CALL_STATUS_IDLE) {
+		memset(&call_status, 0, sizeof(struct tnoti_call_status_idle));
+
+		call_status.type = tcore_call_object_get_type(co);
+		dbg("data.type : [%d]", call_status.type);
+
+		call_status.id = tcore_call_object_get_id(co);
+		dbg("data.id : [%d]", call_status.id);
+
+		// Notify release right away, +XCEER below is only logged
+		call_status.cause = CC_CAUSE_NORMAL_CALL_CLEARING;
+
+		// Set Status
+		tcore_call_object_set_status(co, TCORE_CALL_STATUS_IDLE);
+
+		// Send Notification to TAPI
+		tcore_server_send_notification(tcore_plugin_ref_server(p),
+									   core_obj,
+									   TNOTI_CALL_STATUS_IDLE,
+									   sizeof(struct tnoti_call_status_idle),
+									   (void *) &call_status);
+
+		_call_trace_add(core_obj, call_status.id, CALL_TRACE_NOTI, TCORE_CALL_STATUS_IDLE);
+
+		// Free Call object
+		_call_slot_free(core_obj, co);
+
+		// The modem may rebuild the audio route for the next call, do not trust the cache past this one
+		if (prop && !_call_slot_find_by_status(core_obj,
+					CALL_STATUS_BIT(TCORE_CALL_STATUS_ACTIVE) | CALL_STATUS_BIT(TCORE_CALL_STATUS_HELD)))
+			memset(prop->audio, 0, sizeof(prop->audio));
+
+		// get call end cause.
+		cmd_str = g_strdup_printf("%s", "AT+XCEER");
+		dbg("Request command string: %s", cmd_str);
+
+		// Create new Pending request
+		pending = tcore_pending_new(core_obj, 0);
+
+		// Create new AT-Command request
+		req = tcore_at_request_new(cmd_str, "+XCEER", TCORE_AT_SINGLELINE);
+		dbg("Command: %s, prefix(if any): %s, Command length: %d", req->cmd, req->prefix, strlen(req->cmd));
+		// Free command string
+		g_free(cmd_str);
+
+		// Set request data (AT command) to Pending request
+		tcore_pending_set_request_data(pending, 0, req);
+
+		ur = tcore_user_request_new(NULL, NULL);
+		// Send request
+		ret = _call_request_message(pending, core_obj, ur, _on_confirmation_call_end_cause, GINT_TO_POINTER(call_status.id));
+
+		if (!ret) {
+			err("Failed to send AT-Command request");
+			return;
+		}
+	} else {
+		err("Call object was not free");
+		_call_slot_free(core_obj, co);
+	}
+	dbg("Exit");
+	return;
+}
+
+static void _call_status_dialing(TcorePlugin *p, CallObject *co)
+{
+	struct tnoti_call_status_dialing data;
+	dbg("Entry");
+
+	if (tcore_call_object_get_status(co) != TCORE_CALL_STATUS_DIALING) {
+		data.type = tcore_call_object_get_type(co);
+		dbg("data.type : [%d]", data.type);
+
+		data.id = tcore_call_object_get_id(co);
+		dbg("data.id : [%d]", data.id);
+
+		// Set Status
+		tcore_call_object_set_status(co, TCORE_CALL_STATUS_DIALING);
+
+		// Send notification to TAPI
+		tcore_server_send_notification(tcore_plugin_ref_server(p),
+									   tcore_plugin_ref_core_object(p, "call"),
+									   TNOTI_CALL_STATUS_DIALING,
+									   sizeof(struct tnoti_call_status_dialing),
+									   (void *) &data);
+
+		_call_trace_add(tcore_plugin_ref_core_object(p, "call"), data.id, CALL_TRACE_NOTI, TCORE_CALL_STATUS_DIALING);
+	}
+
+	dbg("Exit");
+	return;
+}
+
+static void _call_status_alert(TcorePlugin *p, CallObject *co)
+{
+	struct tnoti_call_status_alert data;
+	dbg("Entry");
+
+	// Alerting has just 1 data 'CALL ID'
+	if (tcore_call_object_get_status(co) != TCORE_CALL_STATUS_ALERT) {
+		data.type = tcore_call_object_get_type(co);
+		dbg("data.type : [%d]", data.type);
+
+		data.id = tcore_call_object_get_id(co);
 		dbg("data.id : [%d]", data.id);
 
 		// Set Status
@@ -556,6 +1261,8 @@ static void _call_status_alert(TcorePlugin *p, CallObject *co)
 									   TNOTI_CALL_STATUS_ALERT,
 									   sizeof(struct tnoti_call_status_alert),
 									   (void *) &data);
+
+		_call_trace_add(tcore_plugin_ref_core_object(p, "call"), data.id, CALL_TRACE_NOTI, TCORE_CALL_STATUS_ALERT);
 	}
 
 	dbg("Exit");
@@ -583,6 +1290,8 @@ static void _call_status_active(TcorePlugin *p, CallObject *co)
 									   TNOTI_CALL_STATUS_ACTIVE,
 									   sizeof(struct tnoti_call_status_active),
 									   (void *) &data);
+
+		_call_trace_add(tcore_plugin_ref_core_object(p, "call"), data.id, CALL_TRACE_NOTI, TCORE_CALL_STATUS_ACTIVE);
 	}
 
 	dbg("Exit");
@@ -610,6 +1319,8 @@ static void _call_status_held(TcorePlugin *p, CallObject *co)
 									   TNOTI_CALL_STATUS_HELD,
 									   sizeof(struct tnoti_call_status_held),
 									   (void *) &data);
+
+		_call_trace_add(tcore_plugin_ref_core_object(p, "call"), data.id, CALL_TRACE_NOTI, TCORE_CALL_STATUS_HELD);
 	}
 
 	dbg("Exit");
@@ -653,6 +1364,8 @@ static void _call_status_incoming(TcorePlugin *p, CallObject *co)
 									   TNOTI_CALL_STATUS_INCOMING,
 									   sizeof(struct tnoti_call_status_incoming),
 									   (void *) &data);
+
+		_call_trace_add(tcore_plugin_ref_core_object(p, "call"), data.id, CALL_TRACE_NOTI, TCORE_CALL_STATUS_INCOMING);
 	}
 
 	dbg("Exit");
@@ -714,6 +1427,7 @@ static TReturn _call_list_get(CoreObject *o, gboolean *event_flag)
 	char *cmd_str = NULL;
 	TcoreATRequest *req = NULL;
 	gboolean ret = FALSE;
+	struct call_property *prop = NULL;
 
 	dbg("Entry");
 	if (!o) {
@@ -721,6 +1435,17 @@ static TReturn _call_list_get(CoreObject *o, gboolean *event_flag)
 		return TCORE_RETURN_FAILURE;
 	}
 
+	prop = _call_ref_property(o);
+	if (prop && prop->clcc_in_flight) {
+		// The answer in flight may predate the trigger, so one follow-up covers all of them
+		dbg("AT+CLCC in flight, coalescing");
+		prop->clcc_followup = TRUE;
+		if (event_flag && *event_flag)
+			prop->clcc_followup_notify = TRUE;
+		g_free(event_flag);
+		return TCORE_RETURN_SUCCESS;
+	}
+
 	// Create new User Request
 	ur = tcore_user_request_new(NULL, NULL);
 
@@ -736,6 +1461,8 @@ static TReturn _call_list_get(CoreObject *o, gboolean *event_flag)
 	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
 
 	tcore_pending_set_request_data(pending, 0, req);
+	tcore_pending_set_timeout(pending, CALL_CLCC_TIMEOUT_SEC);
+	tcore_pending_set_timeout_callback(pending, on_timeout_call_list_get, event_flag);
 
 	ret = _call_request_message(pending, o, ur, on_response_call_list_get, event_flag);
 	if (!ret) {
@@ -743,6 +1470,11 @@ static TReturn _call_list_get(CoreObject *o, gboolean *event_flag)
 		return TCORE_RETURN_FAILURE;
 	}
 
+	if (prop)
+		prop->clcc_in_flight = TRUE;
+
+	_call_trace_add_all(o, CALL_TRACE_CLCC_REQUEST);
+
 	dbg("AT request sent success");
 	return TCORE_RETURN_SUCCESS;
 }
@@ -750,6 +1482,8 @@ static TReturn _call_list_get(CoreObject *o, gboolean *event_flag)
 // CONFIRMATION
 static void on_confirmation_call_message_send(TcorePending *p, gboolean result, void *user_data)
 {
+	struct call_property *prop = NULL;
+
 	dbg("Entry");
 
 	if (result == FALSE) {  // Fail
@@ -758,6 +1492,15 @@ static void on_confirmation_call_message_send(TcorePending *p, gboolean result,
 		dbg("SEND OK");
 	}
 
+	// Immediate requests carry their core object to account the time spent queued
+	if (user_data) {
+		prop = _call_ref_property((CoreObject *) user_data);
+		if (prop && prop->ecc_dial_at) {
+			_call_trace_dist_add(&prop->ecc_dial, "Emergency ATD", (g_get_monotonic_time() - prop->ecc_dial_at) / 1000);
+			prop->ecc_dial_at = 0;
+		}
+	}
+
 	dbg("Exit");
 	return;
 }
@@ -769,7 +1512,6 @@ static void on_confirmation_call_outgoing(TcorePending *p, int data_len, const v
 	const char *line = NULL;
 	const TcoreATResponse *response = data;
 	struct tresp_call_dial resp;
-	int error;
 	dbg("Entry");
 
 	ur = tcore_pending_ref_user_request(p);
@@ -787,10 +1529,7 @@ static void on_confirmation_call_outgoing(TcorePending *p, int data_len, const v
 				err("Unspecified error cause OR string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 
 			// Free tokens
@@ -814,7 +1553,6 @@ static void on_confirmation_call_accept(TcorePending *p, int data_len, const voi
 	const char *line = NULL;
 	const TcoreATResponse *response = data;
 	struct tresp_call_answer resp;
-	int error;
 	dbg("Entry");
 
 	ur = tcore_pending_ref_user_request(p);
@@ -832,10 +1570,7 @@ static void on_confirmation_call_accept(TcorePending *p, int data_len, const voi
 				err("Unspecified error cause OR string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 
 			// Free tokens
@@ -862,7 +1597,6 @@ static void on_confirmation_call_reject(TcorePending *p, int data_len, const voi
 	const char *line = NULL;
 	const TcoreATResponse *response = data;
 	struct tresp_call_answer resp;
-	int error;
 
 	dbg("Entry");
 
@@ -880,9 +1614,7 @@ static void on_confirmation_call_reject(TcorePending *p, int data_len, const voi
 				err("Unspecified error cause OR string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 
 			// Free tokens
@@ -908,7 +1640,6 @@ static void on_confirmation_call_replace(TcorePending *p, int data_len, const vo
 	const char *line = NULL;
 	const TcoreATResponse *response = data;
 	struct tresp_call_answer resp;
-	int error;
 
 	dbg("Entry");
 	ur = tcore_pending_ref_user_request(p);
@@ -925,9 +1656,7 @@ static void on_confirmation_call_replace(TcorePending *p, int data_len, const vo
 				err("Unspecified error cause OR string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 
 			// Free tokens
@@ -953,7 +1682,6 @@ static void on_confirmation_call_hold_and_accept(TcorePending *p, int data_len,
 	const char *line = NULL;
 	const TcoreATResponse *response = data;
 	struct tresp_call_answer resp;
-	int error;
 
 	dbg("Entry");
 
@@ -974,10 +1702,7 @@ static void on_confirmation_call_hold_and_accept(TcorePending *p, int data_len,
 				err("Unspecified error cause OR string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 
 			// Free tokens
@@ -987,19 +1712,12 @@ static void on_confirmation_call_hold_and_accept(TcorePending *p, int data_len,
 		// Send response to TAPI
 		tcore_user_request_send_response(ur, TRESP_CALL_ANSWER, sizeof(struct tresp_call_answer), &resp);
 		if (!resp.err) {
-			GSList *list = 0;
 			CallObject *co = NULL;
 
 			// Active Call
-			list = tcore_call_object_find_by_status(o, TCORE_CALL_STATUS_ACTIVE);
-			if (!list) {
-				err("Can't find active Call");
-				return;
-			}
-
-			co = (CallObject *) list->data;
+			co = _call_slot_find_by_status(o, CALL_STATUS_BIT(TCORE_CALL_STATUS_ACTIVE));
 			if (!co) {
-				err("Can't get active Call object");
+				err("Can't find active Call");
 				return;
 			}
 
@@ -1021,7 +1739,6 @@ static void _on_confirmation_call_release(TcorePending *p, int data_len, const v
 	struct tresp_call_end resp;
 	GSList *tokens = NULL;
 	const char *line = NULL;
-	int error;
 	const TcoreATResponse *response = data;
 
 	dbg("Entry");
@@ -1040,10 +1757,7 @@ static void _on_confirmation_call_release(TcorePending *p, int data_len, const v
 				err("Unspecified error cause OR string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 			tcore_at_tok_free(tokens);
 		}
@@ -1137,10 +1851,7 @@ static void _on_confirmation_call(TcorePending *p, int data_len, const void *dat
 			err("Unspecified error cause OR string corrupted");
 			error = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			error = atoi(g_slist_nth_data(tokens, 0));
-
-			// TODO: CMEE error mapping is required.
-			error = TCORE_RETURN_3GPP_ERROR;
+			error = util_at_error_result(line);
 		}
 
 		// Free tokens
@@ -1223,17 +1934,6 @@ static void _on_confirmation_call(TcorePending *p, int data_len, const void *dat
 	}
 	break;
 
-	case TRESP_CALL_SEND_DTMF:
-	{
-		struct tresp_call_dtmf resp;
-
-		resp.err = error;
-		dbg("call dtmf response");
-		// Send reponse to TAPI
-		tcore_user_request_send_response(ur, TRESP_CALL_SEND_DTMF, sizeof(struct tresp_call_dtmf), &resp);
-	}
-	break;
-
 	default:
 	{
 		dbg("type not supported");
@@ -1241,18 +1941,13 @@ static void _on_confirmation_call(TcorePending *p, int data_len, const void *dat
 	}
 	}
 
-	if ((type == TRESP_CALL_HOLD) || (type == TRESP_CALL_ACTIVE) || (type == TRESP_CALL_JOIN)
-		|| (type == TRESP_CALL_SPLIT)) {
-		if (!error) {
-			CoreObject *core_obj = NULL;
-			gboolean *eflag = g_new0(gboolean, 1);
-
-			core_obj = tcore_pending_ref_core_object(p);
-			*eflag = FALSE;
-
-			dbg("Calling _call_list_get");
-			_call_list_get(core_obj, eflag);
-		}
+	if ((type == TRESP_CALL_HOLD) || (type == TRESP_CALL_ACTIVE)) {
+		_call_chld_done(tcore_pending_ref_core_object(p), !error, CALL_CHLD_SWAP, 0);
+	} else if (type == TRESP_CALL_JOIN) {
+		_call_chld_done(tcore_pending_ref_core_object(p), !error, CALL_CHLD_JOIN, 0);
+	} else if (type == TRESP_CALL_SPLIT) {
+		_call_chld_done(tcore_pending_ref_core_object(p), !error, CALL_CHLD_SPLIT,
+						user_data ? tcore_call_object_get_id((CallObject *) user_data) : 0);
 	}
 
 	dbg("Exit");
@@ -1309,9 +2004,23 @@ static void on_confirmation_call_transfer(TcorePending *p, int data_len, const v
 
 static void on_confirmation_call_dtmf(TcorePending *p, int data_len, const void *data, void *user_data)
 {
+	const TcoreATResponse *response = data;
+	struct tresp_call_dtmf resp;
+
 	dbg("Entry");
-	_on_confirmation_call(p, data_len, data, user_data, TRESP_CALL_SEND_DTMF);
 
+	if (response->success > 0) {
+		dbg("RESPONSE OK");
+		resp.err = TCORE_RETURN_SUCCESS;
+	} else {
+		err("RESPONSE NOT OK");
+		resp.err = util_at_error_result(response->final_response);
+	}
+
+	dbg("call dtmf response");
+	// Send reponse to TAPI
+	tcore_user_request_send_response(tcore_pending_ref_user_request(p),
+									TRESP_CALL_SEND_DTMF, sizeof(struct tresp_call_dtmf), &resp);
 	return;
 }
 
@@ -1320,6 +2029,7 @@ static void _on_confirmation_dtmf_tone_duration(TcorePending *p, int data_len, c
 	GSList *tokens = NULL;
 	const char *line = NULL;
 	const TcoreATResponse *response = data;
+	struct call_property *prop = NULL;
 	int error;
 
 	dbg("Entry");
@@ -1335,12 +2045,16 @@ static void _on_confirmation_dtmf_tone_duration(TcorePending *p, int data_len, c
 			err("err cause not specified or string corrupted");
 			error = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			error = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
+			error = util_at_error_result(line);
 		}
 
 		// Free tokens
 		tcore_at_tok_free(tokens);
+
+		// Modem duration is unknown now, resend it with the next DTMF request
+		prop = _call_ref_property(tcore_pending_ref_core_object(p));
+		if (prop)
+			prop->dtmf_duration_valid = FALSE;
 	}
 
 	dbg("Set dtmf tone duration response - %d", error);
@@ -1372,10 +2086,7 @@ static void on_confirmation_call_swap(TcorePending *p, int data_len, const void
 				err("err cause not specified or string corrupted");
 				resp.err = TCORE_RETURN_3GPP_ERROR;
 			} else {
-				resp.err = atoi(g_slist_nth_data(tokens, 0));
-
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
+				resp.err = util_at_error_result(line);
 			}
 
 			// Free tokens
@@ -1389,599 +2100,285 @@ static void on_confirmation_call_swap(TcorePending *p, int data_len, const void
 		tcore_user_request_send_response(ur, TRESP_CALL_SWAP, sizeof(struct tresp_call_swap), &resp);
 
 		if (!resp.err) {
-			GSList *active = NULL;
-			GSList *held = NULL;
 			CallObject *co = NULL;
-			gboolean *eflag = NULL;
+			int id;
 
-			held = tcore_call_object_find_by_status(core_obj, TCORE_CALL_STATUS_HELD);
-			if (!held) {
+			if (!_call_slot_find_by_status(core_obj, CALL_STATUS_BIT(TCORE_CALL_STATUS_HELD))) {
 				err("Can't find held Call");
+				_call_chld_done(core_obj, TRUE, CALL_CHLD_SWAP, 0);
 				return;
 			}
 
-			active = tcore_call_object_find_by_status(core_obj, TCORE_CALL_STATUS_ACTIVE);
-			if (!active) {
+			if (!_call_slot_find_by_status(core_obj, CALL_STATUS_BIT(TCORE_CALL_STATUS_ACTIVE))) {
 				dbg("Can't find active Call");
+				_call_chld_done(core_obj, TRUE, CALL_CHLD_SWAP, 0);
 				return;
 			}
 
-			while (held) {
-				co = (CallObject *) held->data;
-				if (!co) {
-					err("Can't get held Call object");
-					return;
-				}
+			for (id = 1; id <= CALL_ID_MAX; id++) {
+				co = _call_slot_find(core_obj, id);
+				if (!co || tcore_call_object_get_status(co) != TCORE_CALL_STATUS_HELD)
+					continue;
 
-				resp.id = tcore_call_object_get_id(co);
+				resp.id = id;
 
 				// Send response to TAPI
 				tcore_user_request_send_response(ur, TRESP_CALL_ACTIVE, sizeof(struct tresp_call_active), &resp);
-
-				held = g_slist_next(held);
 			}
 
-			while (active) {
-				co = (CallObject *) active->data;
-				if (!co) {
-					err("[ error ] can't get active call object");
-					return;
-				}
+			for (id = 1; id <= CALL_ID_MAX; id++) {
+				co = _call_slot_find(core_obj, id);
+				if (!co || tcore_call_object_get_status(co) != TCORE_CALL_STATUS_ACTIVE)
+					continue;
 
-				resp.id = tcore_call_object_get_id(co);
+				resp.id = id;
 
 				// Send response to TAPI
 				tcore_user_request_send_response(ur, TRESP_CALL_HOLD, sizeof(struct tresp_call_hold), &resp);
-				active = g_slist_next(active);
 			}
-
-			eflag = g_new0(gboolean, 1);
-			*eflag = FALSE;
-
-			dbg("calling _call_list_get");
-			_call_list_get(core_obj, eflag);
 		}
 	} else {
 		err("User Request is NULL");
 	}
 
+	_call_chld_done(core_obj, response->success > 0, CALL_CHLD_SWAP, 0);
+
 	dbg("Exit");
 	return;
 }
 
-static void on_confirmation_call_set_source_sound_path(TcorePending *p, int data_len, const void *data, void *user_data)
+static void _call_audio_send_response(UserRequest *ur, enum tcore_response_command command, int error)
 {
-	UserRequest *ur = NULL;
+	dbg("Audio response [0x%x] - %d", command, error);
+
+	switch (command) {
+	case TRESP_CALL_SET_SOUND_PATH:
+	{
+		struct tresp_call_sound_set_path resp;
+
+		resp.err = error;
+		tcore_user_request_send_response(ur, TRESP_CALL_SET_SOUND_PATH, sizeof(struct tresp_call_sound_set_path), &resp);
+	}
+	break;
+
+	case TRESP_CALL_SET_SOUND_VOLUME_LEVEL:
+	{
+		struct tresp_call_sound_set_volume_level resp;
+
+		resp.err = error;
+		tcore_user_request_send_response(ur, TRESP_CALL_SET_SOUND_VOLUME_LEVEL, sizeof(struct tresp_call_sound_set_volume_level), &resp);
+	}
+	break;
+
+	case TRESP_CALL_MUTE:
+	{
+		struct tresp_call_mute resp;
+
+		resp.err = error;
+		tcore_user_request_send_response(ur, TRESP_CALL_MUTE, sizeof(struct tresp_call_mute), &resp);
+	}
+	break;
+
+	case TRESP_CALL_UNMUTE:
+	{
+		struct tresp_call_unmute resp;
+
+		resp.err = error;
+		tcore_user_request_send_response(ur, TRESP_CALL_UNMUTE, sizeof(struct tresp_call_unmute), &resp);
+	}
+	break;
+
+	default:
+		dbg("type not supported");
+		break;
+	}
+}
+
+static void on_confirmation_call_audio(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	struct call_audio_batch *batch = user_data;
+	const TcoreATResponse *response = data;
+	struct call_property *prop = NULL;
+	enum call_audio_setting setting;
 	GSList *tokens = NULL;
 	const char *line = NULL;
-	const TcoreATResponse *response = data;
 	char *resp_str = NULL;
-	struct tresp_call_sound_set_path resp;
-	int error;
+	int error = TCORE_RETURN_3GPP_ERROR;
 
 	dbg("Entry");
-	ur = tcore_pending_ref_user_request(p);
 
-	// +XDRV: <group_id>,<function_id>,<xdrv_result>[,<response_n>]
-	if (!response) {
-		err("Input data is NULL");
-		return;
-	}
+	// Responses come back in queueing order
+	setting = batch->writes[batch->done].setting;
+	batch->done++;
 
-	if (response->success > 0) {
+	// +XDRV: <group_id>,<function_id>,<xdrv_result>[,<response_n>]
+	if (response && response->success > 0 && response->lines) {
 		dbg("RESPONSE OK");
 
 		line = (const char *) (((GSList *) response->lines)->data);
 		tokens = tcore_at_tok_new(line);
 
-		resp_str = g_slist_nth_data(tokens, 0);
-		if (!g_slist_nth_data(tokens, 0)) {
-			err("group_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
+		resp_str = g_slist_nth_data(tokens, 2);
+		if (!resp_str) {
+			err("xdrv_result is missing");
+		} else if (0 == atoi(resp_str)) {
+			dbg("Response is Success");
+			error = TCORE_RETURN_SUCCESS;
 		}
 
-		if (!g_slist_nth_data(tokens, 1)) {
-			err(" function_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
+		// Free tokens
+		tcore_at_tok_free(tokens);
+	} else if (response) {
+		err("RESPONSE NOT OK");
+		error = util_at_error_result(response->final_response);
+	}
 
-		resp_str = g_slist_nth_data(tokens, 2);
+	if (error != TCORE_RETURN_SUCCESS) {
+		err("%s failed", call_audio_xdrv_cmd[setting]);
+		if (batch->err == TCORE_RETURN_SUCCESS)
+			batch->err = error;
 
-		if (resp_str) {
-			error = atoi(resp_str);
-			if (0 == error) {
-				dbg("Response is Success");
-				resp.err = TCORE_RETURN_SUCCESS;
-			} else {
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			}
-		}
-OUT:
-		// Free tokens
-		tcore_at_tok_free(tokens);
-	} else {
-		dbg("RESPONSE NOT OK");
-
-		line = (const char *) response->final_response;
-		tokens = tcore_at_tok_new(line);
-
-		if (g_slist_length(tokens) < 1) {
-			err("err cause not specified or string corrupted");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		} else {
-			error = atoi(g_slist_nth_data(tokens, 0));
-
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		}
-
-		// Free tokens
-		tcore_at_tok_free(tokens);
+		// Modem side value is unknown now, write it again next time
+		prop = _call_ref_property(tcore_pending_ref_core_object(p));
+		if (prop)
+			prop->audio[setting][0] = '\0';
 	}
 
-	if (ur) {
-		if (resp.err != TCORE_RETURN_SUCCESS) {  // Send only failed notification . success notification send when destination device is set.
-			// Send notification to TAPI
-			tcore_user_request_send_response(ur, TRESP_CALL_SET_SOUND_PATH, sizeof(struct tresp_call_sound_set_path), &resp);
-			setsoundpath = TRUE;
-		}
-	} else {
-		err("User Request is NULL");
-	}
-
-	dbg("Exit");
-	return;
-}
-
-static void on_confirmation_call_set_destination_sound_path(TcorePending *p, int data_len, const void *data, void *user_data)
-{
-	UserRequest *ur = NULL;
-	GSList *tokens = NULL;
-	const char *line = NULL;
-	char *resp_str = NULL;
-	struct tresp_call_sound_set_path resp;
-	const TcoreATResponse *response = data;
-	int error;
-
-	dbg("Entry");
-
-	ur = tcore_pending_ref_user_request(p);
-	// +XDRV: <group_id>,<function_id>,<xdrv_result>[,<response_n>]
-
-	if (!response) {
-		err("Input data is NULL");
+	if (batch->done < batch->count)
 		return;
-	}
 
-	if (ur) {
-		if (response->success > 0) {
-			dbg("RESPONSE OK");
+	// When queueing stopped halfway the request has already failed
+	if (batch->queued)
+		_call_audio_send_response(tcore_pending_ref_user_request(p), batch->command, batch->err);
 
-			line = (const char *) (((GSList *) response->lines)->data);
-			tokens = tcore_at_tok_new(line);
-
-			resp_str = g_slist_nth_data(tokens, 0);
-			if (!g_slist_nth_data(tokens, 0)) {
-				dbg("group_id is missing");
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-				goto OUT;
-			}
-
-			if (!g_slist_nth_data(tokens, 1)) {
-				dbg("function_id is missing");
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-				goto OUT;
-			}
-
-			resp_str = g_slist_nth_data(tokens, 2);
-			if (resp_str) {
-				error = atoi(resp_str);
-				if (0 == error) {
-					dbg("Response is Success");
-					resp.err = TCORE_RETURN_SUCCESS;
-				} else {
-					resp.err = TCORE_RETURN_3GPP_ERROR;
-				}
-			}
-
-OUT:
-			// Free tokens
-			tcore_at_tok_free(tokens);
-		} else {
-			dbg("RESPONSE NOT OK");
-
-			line = (const char *) response->final_response;
-			tokens = tcore_at_tok_new(line);
-
-			if (g_slist_length(tokens) < 1) {
-				err("err cause not specified or string corrupted");
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			}
-
-			// Free tokens
-			tcore_at_tok_free(tokens);
-		}
-
-		if (setsoundpath == TRUE) {
-			setsoundpath = FALSE;
-		} else {
-			// Send response to TAPI
-			tcore_user_request_send_response(ur, TRESP_CALL_SET_SOUND_PATH, sizeof(struct tresp_call_sound_set_path), &resp);
-		}
-	} else {
-		dbg("User Request is NULL");
-	}
+	g_free(batch);
 
 	dbg("Exit");
 	return;
 }
 
-static void on_confirmation_call_set_source_sound_volume_level(TcorePending *p, int data_len, const void *data, void *user_data)
+// RESPONSE
+// Applies one +CLCC entry to its call object, touching only what changed
+static void _call_apply_clcc(TcorePlugin *plugin, CoreObject *core_obj, struct clcc_call_t *call, gboolean notify)
 {
-	UserRequest *ur = NULL;
-	GSList *tokens = NULL;
-	const char *line = NULL;
-	const TcoreATResponse *response = data;
-	char *resp_str = NULL;
-	struct tresp_call_sound_set_volume_level resp;
-	int error;
-
-	ur = tcore_pending_ref_user_request(p);
-	dbg("Entry");
-	// +XDRV: <group_id>,<function_id>,<xdrv_result>[,<response_n>]
-	if (!response) {
-		err("Input data is NULL");
-		return;
-	}
-
-	if (response->success > 0) {
-		dbg("RESPONSE OK");
-
-		line = (const char *) (((GSList *) response->lines)->data);
-		tokens = tcore_at_tok_new(line);
-
-		resp_str = g_slist_nth_data(tokens, 0);
-		if (!g_slist_nth_data(tokens, 0)) {
-			err("group_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
-
-		if (!g_slist_nth_data(tokens, 1)) {
-			err("function_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
-
-		resp_str = g_slist_nth_data(tokens, 2);
-		if (resp_str) {
-			error = atoi(resp_str);
-
-			if (0 == error) {
-				dbg("Response is Success ");
-				resp.err = TCORE_RETURN_SUCCESS;
-			} else {
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			}
-		}
-
-OUT:
-		// Free tokens
-		tcore_at_tok_free(tokens);
-	} else {
-		dbg("RESPONSE NOT OK");
-
-		line = (const char *) response->final_response;
-		tokens = tcore_at_tok_new(line);
-
-		if (g_slist_length(tokens) < 1) {
-			err("err cause not specified or string corrupted");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		} else {
-			error = atoi(g_slist_nth_data(tokens, 0));
-
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		}
-
-		// Free tokens
-		tcore_at_tok_free(tokens);
-	}
+	CallObject *co = NULL;
+	char number[CALL_CLIP_NUMBER_LEN] = {0, };
 
-	if (ur) {
-		if (resp.err && soundvolume == FALSE) {  // Send only failed notification . success notification send when destination device is set.
-			// Send reposne to TAPI
-			tcore_user_request_send_response(ur, TRESP_CALL_SET_SOUND_VOLUME_LEVEL, sizeof(struct tresp_call_sound_set_volume_level), &resp);
-			soundvolume = TRUE;
+	co = _call_slot_find(core_obj, call->info.id);
+	if (!co) {
+		co = _call_slot_new(core_obj, call->info.id);
+		if (!co) {
+			err("error : tcore_call_object_new [ id : %d ]", call->info.id);
+			return;
 		}
-	} else {
-		err("User Request is NULL");
-	}
-
-	dbg("Exit");
-	return;
-}
-
-
-static void on_confirmation_call_set_destination_sound_volume_level(TcorePending *p, int data_len, const void *data, void *user_data)
-{
-	UserRequest *ur = NULL;
-	GSList *tokens = NULL;
-	const char *line = NULL;
-	char *resp_str = NULL;
-	const TcoreATResponse *response = data;
-	struct tresp_call_sound_set_volume_level resp;
-	int error;
-
-	dbg("Entry");
-
-	ur = tcore_pending_ref_user_request(p);
-
-	// +XDRV: <group_id>,<function_id>,<xdrv_result>[,<response_n>]
-	if (!response) {
-		err("Input data is NULL");
-		return;
+		dbg("Call id : (%d) new", call->info.id);
 	}
 
-	if (ur) {
-		if (response->success > 0) {
-			dbg("RESPONSE OK");
-			line = (const char *) (((GSList *) response->lines)->data);
-			tokens = tcore_at_tok_new(line);
-			resp_str = g_slist_nth_data(tokens, 0);
-
-			if (!g_slist_nth_data(tokens, 0)) {
-				err("group_id is missing");
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-				goto OUT;
-			}
-
-			if (!g_slist_nth_data(tokens, 1)) {
-				err("function_id is missing");
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-				goto OUT;
-			}
-
-			resp_str = g_slist_nth_data(tokens, 2);
-
-			if (resp_str) {
-				error = atoi(resp_str);
-
-				if (0 == error) {
-					dbg("Response is Success");
-					resp.err = TCORE_RETURN_SUCCESS;
-				} else {
-					resp.err = TCORE_RETURN_3GPP_ERROR;
-				}
-			}
-
-OUT:
-			// Free tokens
-			tcore_at_tok_free(tokens);
-		} else {
-			dbg("RESPONSE NOT OK");
-
-			line = (const char *) response->final_response;
-			tokens = tcore_at_tok_new(line);
-
-			if (g_slist_length(tokens) < 1) {
-				err("err cause not specified or string corrupted");
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			} else {
-				error = atoi(g_slist_nth_data(tokens, 0));
-
-				// TODO: CMEE error mapping is required.
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			}
+	if (tcore_call_object_get_type(co) != call_type(call->info.type))
+		tcore_call_object_set_type(co, call_type(call->info.type));
 
-			tcore_at_tok_free(tokens);
-		}
+	if (tcore_call_object_get_direction(co) != call->info.direction)
+		tcore_call_object_set_direction(co, call->info.direction);
 
-		if (soundvolume == TRUE) {
-			soundvolume = FALSE;
-		} else {
-			// Send reposne to TAPI
-			tcore_user_request_send_response(ur, TRESP_CALL_SET_SOUND_VOLUME_LEVEL, sizeof(struct tresp_call_sound_set_volume_level), &resp);
-		}
-	} else {
-		err("User Request is NULL");
+	if (tcore_call_object_get_multiparty_state(co) != _call_is_in_mpty(call->info.mpty)) {
+		dbg("Call id : (%d) mpty -> (%d)", call->info.id, call->info.mpty);
+		tcore_call_object_set_multiparty_state(co, _call_is_in_mpty(call->info.mpty));
 	}
 
-	dbg("Exit");
-	return;
-}
+	tcore_call_object_get_number(co, number);
+	if (strcmp(number, call->number) != 0)
+		tcore_call_object_set_cli_info(co, CALL_CLI_MODE_DEFAULT, call->number);
 
+	if (tcore_call_object_get_active_line(co) != 0)
+		tcore_call_object_set_active_line(co, 0);
 
-static void on_confirmation_call_mute(TcorePending *p, int data_len, const void *data, void *user_data)
-{
-	UserRequest *ur = NULL;
-	GSList *tokens = NULL;
-	const char *line = NULL;
-	char *resp_str = NULL;
-	struct tresp_call_mute resp;
-	const TcoreATResponse *response = data;
-	int error;
-
-	dbg("Entry");
-
-	ur = tcore_pending_ref_user_request(p);
-
-	if (!response) {
-		err("Input data is NULL");
+	if (tcore_call_object_get_status(co) == call->info.status)
 		return;
-	}
 
-	if (response->success > 0) {
-		dbg("RESPONSE OK");
-
-		line = (const char *) (((GSList *) response->lines)->data);
-		tokens = tcore_at_tok_new(line);
-		resp_str = g_slist_nth_data(tokens, 0);
-
-		if (!g_slist_nth_data(tokens, 0)) {
-			err("group_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
-
-		if (!g_slist_nth_data(tokens, 1)) {
-			err(" function_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
-
-		resp_str = g_slist_nth_data(tokens, 2);
-
-		if (resp_str) {
-			error = atoi(resp_str);
-			if (0 == error) {
-				dbg("Response is Success");
-				resp.err = TCORE_RETURN_SUCCESS;
-			} else {
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			}
-		}
-OUT:
-		// Free tokens
-		tcore_at_tok_free(tokens);
+	if (notify) {
+		dbg("Call status before calling _call_branch_by_status() : (%d)", call->info.status);
+		_call_branch_by_status(plugin, co, call->info.status);
 	} else {
-		dbg("RESPONSE NOT OK");
-
-		line = (const char *) response->final_response;
-		tokens = tcore_at_tok_new(line);
-
-		if (g_slist_length(tokens) < 1) {
-			err("err cause not specified or string corrupted");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		} else {
-			error = atoi(g_slist_nth_data(tokens, 0));
-
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		}
-
-		// Free tokens
-		tcore_at_tok_free(tokens);
-	}
-
-	if (ur) {
-		tcore_user_request_send_response(ur, TRESP_CALL_MUTE, sizeof(struct tresp_call_mute), &resp);
-	} else {
-		err("User Request is NULL");
+		dbg("Call id : (%d) status (%d) -> (%d)", call->info.id, tcore_call_object_get_status(co), call->info.status);
+		tcore_call_object_set_status(co, call->info.status);
 	}
-
-	dbg("Exit");
-	return;
 }
 
-static void on_confirmation_call_unmute(TcorePending *p, int data_len, const void *data, void *user_data)
+// Calls the modem no longer lists are gone, even when their +XCALLSTAT got lost
+static void _call_release_unlisted(TcorePlugin *plugin, CoreObject *core_obj, unsigned int listed, gboolean notify)
 {
-	const TcoreATResponse *response = NULL;
-	struct tresp_call_unmute resp;
-	GSList *tokens = NULL;
-	const char *line = NULL;
-	UserRequest *ur = NULL;
-	char *resp_str = NULL;
-	int error;
+	CallObject *co = NULL;
+	int id;
 
-	dbg("Entry");
+	for (id = 1; id <= CALL_ID_MAX; id++) {
+		if (listed & (1 << id))
+			continue;
 
-	response = (TcoreATResponse *) data;
-	ur = tcore_pending_ref_user_request(p);
+		co = _call_slot_find(core_obj, id);
+		if (!co)
+			continue;
 
-	if (!response) {
-		err("Input data is NULL");
-		return;
+		dbg("Call id : (%d) not in +CLCC, releasing", id);
+		if (notify)
+			_call_branch_by_status(plugin, co, TCORE_CALL_STATUS_IDLE);
+		else
+			_call_slot_free(core_obj, co);
 	}
+}
 
-	if (response->success > 0) {
-		dbg("RESPONSE OK");
-
-		line = (const char *) (((GSList *) response->lines)->data);
-		tokens = tcore_at_tok_new(line);
-		resp_str = g_slist_nth_data(tokens, 0);
-
-		if (!g_slist_nth_data(tokens, 0)) {
-			err("group_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
-
-		if (!g_slist_nth_data(tokens, 1)) {
-			err(" function_id is missing");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-			goto OUT;
-		}
-
-		resp_str = g_slist_nth_data(tokens, 2);
-
-		if (resp_str) {
-			error = atoi(resp_str);
-			if (0 == error) {
-				dbg("Response is Success");
-				resp.err = TCORE_RETURN_SUCCESS;
-			} else {
-				resp.err = TCORE_RETURN_3GPP_ERROR;
-			}
-		}
-OUT:
-		// Free tokens
-		tcore_at_tok_free(tokens);
-	} else {
-		dbg("RESPONSE NOT OK");
-
-		line = (const char *) response->final_response;
-		tokens = tcore_at_tok_new(line);
-
-		if (g_slist_length(tokens) < 1) {
-			err("err cause not specified or string corrupted");
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		} else {
-			error = atoi(g_slist_nth_data(tokens, 0));
+// AT+CLCC finished one way or another, run the one request coalesced meanwhile
+static void _call_list_get_done(CoreObject *core_obj)
+{
+	struct call_property *prop = NULL;
+	gboolean *event_flag = NULL;
 
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
-		}
+	prop = _call_ref_property(core_obj);
+	if (!prop)
+		return;
 
-		// Free tokens
-		tcore_at_tok_free(tokens);
-	}
+	prop->clcc_in_flight = FALSE;
+	if (prop->clcc_followup) {
+		event_flag = g_new0(gboolean, 1);
+		*event_flag = prop->clcc_followup_notify;
+		prop->clcc_followup = FALSE;
+		prop->clcc_followup_notify = FALSE;
 
-	if (ur) {
-		tcore_user_request_send_response(ur, TRESP_CALL_UNMUTE, sizeof(struct tresp_call_unmute), &resp);
-	} else {
-		err("User Request is NULL");
+		dbg("Sending coalesced AT+CLCC");
+		_call_list_get(core_obj, event_flag);
 	}
+}
 
-	dbg("Exit");
-	return;
+// The response callback is not run for a timed out request
+static void on_timeout_call_list_get(TcorePending *p, void *user_data)
+{
+	err("AT+CLCC timed out");
+
+	g_free(user_data);
+	_call_list_get_done(tcore_pending_ref_core_object(p));
 }
 
-// RESPONSE
 static void on_response_call_list_get(TcorePending *p, int data_len, const void *data, void *user_data)
 {
 	TcorePlugin *plugin = NULL;
 	CoreObject *core_obj = NULL;
-	CallObject *co = NULL;
 	struct clcc_call_t *call_list = NULL;
 	gboolean *event_flag = (gboolean *) user_data;
 	const TcoreATResponse *response = data;
 	GSList *resp_data = NULL;
 	char *line = NULL;
+	struct call_property *prop = NULL;
+	unsigned int listed = 0;
+	gboolean complete = FALSE;
 
-	int cllc_info = 0, countCalls = 0, countValidCalls = 0;
+	int countCalls = 0, countValidCalls = 0;
 	int error = 0;
 	dbg("Entry");
 
 	plugin = tcore_pending_ref_plugin(p);
 	core_obj = tcore_pending_ref_core_object(p);
 
+	_call_trace_add_all(core_obj, CALL_TRACE_CLCC_RESPONSE);
+
 	if (response->success > 0) {
 		dbg("RESPONCE OK");
 		if (response->lines) {
@@ -1990,81 +2387,58 @@ static void on_response_call_list_get(TcorePending *p, int data_len, const void
 			dbg("Total records : %d", countCalls);
 		}
 
+		prop = _call_ref_property(core_obj);
+		complete = TRUE;
 		if (0 == countCalls) {
 			err("Call count is zero");
-			return;
-		}
+		} else if (prop) {
+			call_list = prop->clcc;
 
-		call_list = g_new0(struct clcc_call_t, countCalls);
+			for (countValidCalls = 0; resp_data != NULL && countValidCalls < CALL_ID_MAX; resp_data = resp_data->next, countValidCalls++) {
+				line = (char *) (resp_data->data);
 
-		for (countValidCalls = 0; resp_data != NULL; resp_data = resp_data->next, countValidCalls++, cllc_info++) {
-			line = (char *) (resp_data->data);
-
-			error = _callFromCLCCLine(line, call_list + countValidCalls);
-			if (0 != error) {
-				continue;
-			}
-
-			co = tcore_call_object_find_by_id(core_obj, call_list[cllc_info].info.id);
-			if (!co) {
-				co = tcore_call_object_new(core_obj, call_list[cllc_info].info.id);
-				if (!co) {
-					err("error : tcore_call_object_new [ id : %d ]", call_list[cllc_info].info.id);
+				memset(call_list + countValidCalls, 0, sizeof(struct clcc_call_t));
+				error = _callFromCLCCLine(line, call_list + countValidCalls);
+				if (0 != error) {
+					complete = FALSE;
 					continue;
 				}
-			}
-
-			// Call set parameters
-			tcore_call_object_set_type(co, call_type(call_list[cllc_info].info.type));
-			tcore_call_object_set_direction(co, call_list[cllc_info].info.direction);
-			tcore_call_object_set_multiparty_state(co, _call_is_in_mpty(call_list[cllc_info].info.mpty));
-			tcore_call_object_set_cli_info(co, CALL_CLI_MODE_DEFAULT, call_list[cllc_info].number);
-			tcore_call_object_set_active_line(co, 0);
 
-			if (*event_flag) {
-				dbg("Call status before calling _call_branch_by_status() : (%d)", call_list[cllc_info].info.status);
-				_call_branch_by_status(plugin, co, call_list[cllc_info].info.status);
-			} else {
-				// Set Status
-				tcore_call_object_set_status(co, call_list[cllc_info].info.status);
-
-				dbg("Call id : (%d)", call_list[cllc_info].info.id);
-				dbg("Call direction : (%d)", call_list[cllc_info].info.direction);
-				dbg("Call type : (%d)", call_list[cllc_info].info.type);
-				dbg("Call mpty : (%d)", call_list[cllc_info].info.mpty);
-				dbg("Call number : (%s)", call_list[cllc_info].number);
-				dbg("Call status : (%d)", call_list[cllc_info].info.status);
+				if (call_list[countValidCalls].info.id >= 1 && call_list[countValidCalls].info.id <= CALL_ID_MAX)
+					listed |= 1 << call_list[countValidCalls].info.id;
+				_call_apply_clcc(plugin, core_obj, call_list + countValidCalls, *event_flag);
 			}
 		}
 
-		// Free Call list
-		g_free(call_list);
+		// A trigger that arrived meanwhile may have created calls this answer predates
+		if (complete && prop && !prop->clcc_followup)
+			_call_release_unlisted(plugin, core_obj, listed, *event_flag);
 	}
 
 	// Free User data
 	g_free(event_flag);
 
+	_call_list_get_done(core_obj);
+
 	dbg("Exit");
 	return;
 }
 
 static void _on_confirmation_call_end_cause(TcorePending *p, int data_len, const void *data, void *user_data)
 {
-	TcorePlugin *plugin = NULL;
 	CoreObject *core_obj = NULL;
-	CallObject *co = (CallObject *) user_data;
+	int id = GPOINTER_TO_INT(user_data);
 	const TcoreATResponse *response = data;
 	const char *line = NULL;
-	struct tnoti_call_status_idle call_status;
 	GSList *tokens = NULL;
 	char *resp_str;
 	int error;
+	int cause = -1;
 
 	dbg("Entry");
-	plugin = tcore_pending_ref_plugin(p);
 	core_obj = tcore_pending_ref_core_object(p);
 
-	if (response->success > 0) {
+	if (response->success > 0 && response->lines) {
 		dbg("RESPONSE OK");
 		line = (const char *) (((GSList *) response->lines)->data);
 		tokens = tcore_at_tok_new(line);
@@ -2075,11 +2449,12 @@ static void _on_confirmation_call_end_cause(TcorePending *p, int data_len, const
 			resp_str = g_slist_nth_data(tokens, 1);
 			if (!resp_str) {
 				err("call end cause value missing");
+			} else {
+				error = atoi(resp_str);
+				dbg("call end cause - %d", error);
+				cause = _compare_call_end_cause(error);
+				dbg("TAPI call end cause - %d", cause);
 			}
-			error = atoi(resp_str);
-			dbg("call end cause - %d", error);
-			call_status.cause = _compare_call_end_cause(error);
-			dbg("TAPI call end cause - %d", call_status.cause);
 		}
 
 		// Free tokens
@@ -2093,29 +2468,19 @@ static void _on_confirmation_call_end_cause(TcorePending *p, int data_len, const
 		} else {
 			err(" err cause  value: %d", atoi(g_slist_nth_data(tokens, 0)));
 		}
-		call_status.cause = CC_CAUSE_NORMAL_CALL_CLEARING;
 		// Free tokens
 		tcore_at_tok_free(tokens);
 	}
 
-	call_status.type = tcore_call_object_get_type(co);
-	dbg("data.type : [%d]", call_status.type);
-
-	call_status.id = tcore_call_object_get_id(co);
-	dbg("data.id : [%d]", call_status.id);
+	// IDLE already went out, the cause only completes the record of the call
+	dbg("call(%d) end cause - %d", id, cause);
 
-	// Set Status
-	tcore_call_object_set_status(co, TCORE_CALL_STATUS_IDLE);
-
-	// Send Notification to TAPI
-	tcore_server_send_notification(tcore_plugin_ref_server(plugin),
-								   core_obj,
-								   TNOTI_CALL_STATUS_IDLE,
-								   sizeof(struct tnoti_call_status_idle),
-								   (void *) &call_status);
-
-	// Free Call object
-	tcore_call_object_free(core_obj, co);
+	// A new call may have taken the id meanwhile, its timeline is not ours
+	if (!_call_slot_find(core_obj, id)) {
+		_call_trace_add(core_obj, id, CALL_TRACE_XCEER, cause);
+		_call_trace_dump(core_obj, id);
+		_call_trace_close(core_obj, id);
+	}
 }
 
 static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call)
@@ -2125,8 +2490,8 @@ static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call)
 	int state;
 	int mode;
 	int isMT;
-	char *num = NULL;
 	unsigned int num_type;
+	unsigned int len = 0;
 	GSList *tokens = NULL;
 	char *resp = NULL;
 	dbg("Entry");
@@ -2224,16 +2589,13 @@ static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call)
 
 	// parse <num>
 	resp = g_slist_nth_data(tokens, 5);
-	dbg("Incoming number - %s and its len  - %d", resp, strlen(resp));
 
 	// tolerate null here
 	if (!resp) {
 		err("Number is NULL");
 		goto ERROR;
 	}
-	// Strike off double quotes
-	num = util_removeQuotes(resp);
-	dbg("num  after removing quotes - %s", num);
+	dbg("Incoming number - %s and its len  - %d", resp, strlen(resp));
 
 	p_call->info.num_len = strlen(resp);
 	dbg("num_len : [0x%x]\n", p_call->info.num_len);
@@ -2251,17 +2613,20 @@ static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call)
 	num_type = ((p_call->info.num_type) >> 4) & 0x07;
 	dbg("called party's type of number : [0x%x]\n", num_type);
 
-	if (num_type == 1 && num[0] != '+') {
+	if (*resp == '"')
+		resp++;
+
+	if (num_type == 1 && *resp != '+') {
 		// international number
-		p_call->number[0] = '+';
-		memcpy(&(p_call->number[1]), num, strlen(num));
-	} else {
-		memcpy(&(p_call->number), num, strlen(num));
+		p_call->number[len++] = '+';
 	}
+
+	// Strike off double quotes while copying
+	for (; *resp && *resp != '"' && len < sizeof(p_call->number) - 1; resp++)
+		p_call->number[len++] = *resp;
+	p_call->number[len] = '\0';
 	dbg("incoming number - %s", p_call->number);
 
-	g_free(num);
-	num = NULL;
 	// Free tokens
 	tcore_at_tok_free(tokens);
 
@@ -2271,11 +2636,6 @@ static int _callFromCLCCLine(char *line, struct clcc_call_t *p_call)
 ERROR:
 	err("Invalid CLCC line");
 
-	if (num) {
-		g_free(num);
-		num = NULL;
-	}
-
 	// Free tokens
 	tcore_at_tok_free(tokens);
 	err("Exit");
@@ -2290,22 +2650,12 @@ static void on_notification_call_waiting(CoreObject *o, const void *data, void *
 	char *pId;
 	int call_id;
 	gboolean *eflag;
-	GSList *pList = NULL;
 	CallObject *co = NULL, *dupco = NULL;
 
 	dbg("function entrance");
-	// check call with waiting status already exist
-	pList = tcore_call_object_find_by_status(o, TCORE_CALL_STATUS_WAITING);
-
-	if (pList != NULL) {
-		dbg("[error]Waiting call already exist. skip");
-		return;
-	}
-	// check call with incoming status already exist
-	pList = tcore_call_object_find_by_status(o, TCORE_CALL_STATUS_INCOMING);
-
-	if (pList != NULL) {
-		dbg("[error]incoming call already exist. skip");
+	// check call with waiting or incoming status already exist
+	if (_call_slot_find_by_status(o, CALL_STATUS_BIT(TCORE_CALL_STATUS_WAITING) | CALL_STATUS_BIT(TCORE_CALL_STATUS_INCOMING))) {
+		dbg("[error]Waiting or incoming call already exist. skip");
 		return;
 	}
 	line = (char *) data;
@@ -2314,23 +2664,24 @@ static void on_notification_call_waiting(CoreObject *o, const void *data, void *
 	pId = g_slist_nth_data(tokens, 0);
 	if (!pId) {
 		dbg("[error]:Call id is missing from +XCALLSTAT indication");
+		tcore_at_tok_free(tokens);
 		return;
 	}
 
 	call_id = atoi(pId);
-	dupco = tcore_call_object_find_by_id(o, call_id);
+	tcore_at_tok_free(tokens);
+
+	dupco = _call_slot_find(o, call_id);
 	if (dupco != NULL) {
 		dbg("co with same id already exist. skip");
 		return;
 	}
-	co = tcore_call_object_new(o, call_id);
+	co = _call_slot_new(o, call_id);
 	if (!co) {
 		dbg("[ error ] co is NULL");
 		return;
 	}
 
-	tcore_at_tok_free(tokens);
-
 	eflag = g_new0(gboolean, 1);
 	*eflag = TRUE;
 	dbg("calling _call_list_get");
@@ -2344,14 +2695,12 @@ static void on_notification_call_incoming(CoreObject *o, const void *data, void
 	char *pId;
 	int call_id;
 	gboolean *eflag;
-	GSList *pList = NULL;
 	CallObject *co = NULL, *dupco = NULL;
+	struct call_property *prop = NULL;
 
 	dbg("function entrance");
 	// check call with incoming status already exist
-	pList = tcore_call_object_find_by_status(o, TCORE_CALL_STATUS_INCOMING);
-
-	if (pList != NULL) {
+	if (_call_slot_find_by_status(o, CALL_STATUS_BIT(TCORE_CALL_STATUS_INCOMING))) {
 		dbg("incoming call already exist. skip");
 		return;
 	}
@@ -2362,25 +2711,46 @@ static void on_notification_call_incoming(CoreObject *o, const void *data, void
 	pId = g_slist_nth_data(tokens, 0);
 	if (!pId) {
 		dbg("Error:Call id is missing from %XCALLSTAT indication");
+		tcore_at_tok_free(tokens);
 		return;
 	}
 
 	call_id = atoi(pId);
+	tcore_at_tok_free(tokens);
 
-	dupco = tcore_call_object_find_by_id(o, call_id);
+	dupco = _call_slot_find(o, call_id);
 	if (dupco != NULL) {
 		dbg("co with same id already exist. skip");
 		return;
 	}
 
-	co = tcore_call_object_new(o, call_id);
+	co = _call_slot_new(o, call_id);
 	if (!co) {
 		dbg("[ error ] co is NULL");
 		return;
 	}
 
-	dbg("freeing  at token")
-	tcore_at_tok_free(tokens);
+	// +XCALLSTAT carries no type, CS calls here are voice until AT+CLCC says otherwise
+	tcore_call_object_set_type(co, TCORE_CALL_TYPE_VOICE);
+	tcore_call_object_set_direction(co, TCORE_CALL_DIRECTION_INCOMING);
+	tcore_call_object_set_active_line(co, 0);
+
+	prop = _call_ref_property(o);
+	if (prop) {
+		_call_mt_pending_clear(prop);
+
+		if (prop->clip.valid) {
+			dbg("+CLIP already received, notifying call(%d)", call_id);
+			prop->clip.valid = FALSE;
+			_call_mt_notify(o, co, &prop->clip);
+			return;
+		}
+
+		// Notify as soon as +CLIP arrives, AT+CLCC only if it does not
+		prop->mt_pending_id = call_id;
+		prop->mt_fallback_timer = g_timeout_add(CALL_CLIP_WAIT_MS, _call_mt_fallback, o);
+		return;
+	}
 
 	eflag = g_new0(gboolean, 1);
 	*eflag = TRUE;
@@ -2430,25 +2800,27 @@ static void on_notification_call_status(CoreObject *o, const void *data, void *u
 	case CALL_STATUS_ACTIVE:
 	{
 		dbg("call(%d) status : [ ACTIVE ]", id);
-		co = tcore_call_object_find_by_id(o, id);
+		co = _call_slot_find(o, id);
 		if (!co) {
 			dbg("co is NULL");
 			return;
 		}
 		_call_status_active(plugin, co);
+		_call_chld_observe(o, id, TCORE_CALL_STATUS_ACTIVE);
 	}
 	break;
 
 	case CALL_STATUS_HELD:
 		dbg("call(%d) status : [ held ]", id);
+		_call_chld_observe(o, id, TCORE_CALL_STATUS_HELD);
 		break;
 
 	case CALL_STATUS_DIALING:
 	{
 		dbg("call(%d) status : [ dialing ]", id);
-		co = tcore_call_object_find_by_id(o, id);
+		co = _call_slot_find(o, id);
 		if (!co) {
-			co = tcore_call_object_new(o, id);
+			co = _call_slot_new(o, id);
 			if (!co) {
 				dbg("error : tcore_call_object_new [ id : %d ]", id);
 				return;
@@ -2464,7 +2836,7 @@ static void on_notification_call_status(CoreObject *o, const void *data, void *u
 	case CALL_STATUS_ALERT:
 	{
 		dbg("call(%d) status : [ alert ]", id);
-		co = tcore_call_object_find_by_id(o, id);
+		co = _call_slot_find(o, id);
 		if (!co) {
 			dbg("co is NULL");
 			return;
@@ -2486,7 +2858,7 @@ static void on_notification_call_status(CoreObject *o, const void *data, void *u
 	{
 		dbg("call(%d) status : [ release ]", id);
 
-		co = tcore_call_object_find_by_id(o, id);
+		co = _call_slot_find(o, id);
 		if (!co) {
 			dbg("co is NULL");
 			return;
@@ -2517,10 +2889,21 @@ static TReturn s_call_outgoing(CoreObject *o, UserRequest *ur)
 	TcorePending *pending = NULL;
 	TcoreATRequest *req;
 	gboolean ret = FALSE;
+	gboolean emergency;
+	struct call_property *prop = NULL;
 
 	dbg("function entrance");
 	data = (struct treq_call_dial *) tcore_user_request_ref_data(ur, 0);
 	clir = _get_clir_status(data->number);
+	emergency = _call_is_emergency(o, data);
+
+	// The call id comes with +XCALLSTAT, the timeline picks this up from there
+	prop = _call_ref_property(o);
+	if (prop) {
+		prop->trace_dial_at = g_get_monotonic_time();
+		if (emergency)
+			prop->ecc_dial_at = prop->trace_dial_at;
+	}
 
 	// Compose ATD Cmd string
 	switch (clir) {
@@ -2553,7 +2936,15 @@ static TReturn s_call_outgoing(CoreObject *o, UserRequest *ur)
 	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
 
 	tcore_pending_set_request_data(pending, 0, req);
-	ret = _call_request_message(pending, o, ur, on_confirmation_call_outgoing, NULL);
+
+	// Emergency dials go ahead of whatever SIM, SMS or network work is queued
+	if (emergency) {
+		dbg("Emergency number, dialing with immediate priority");
+		ret = _call_request_message_with_priority(pending, o, ur, on_confirmation_call_outgoing, NULL,
+												  TCORE_PENDING_PRIORITY_IMMEDIATE);
+	} else {
+		ret = _call_request_message(pending, o, ur, on_confirmation_call_outgoing, NULL);
+	}
 
 	g_free(raw_str);
 	g_free(cmd_str);
@@ -2580,7 +2971,7 @@ static TReturn s_call_answer(CoreObject *o, UserRequest *ur)
 	dbg("function entrance");
 
 	data = (struct treq_call_answer *) tcore_user_request_ref_data(ur, 0);
-	co = tcore_call_object_find_by_id(o, data->id);
+	co = _call_slot_find(o, data->id);
 	if (data->type == CALL_ANSWER_TYPE_ACCEPT) {
 		dbg(" request type CALL_ANSWER_TYPE_ACCEPT");
 
@@ -2642,7 +3033,7 @@ static TReturn s_call_release(CoreObject *o, UserRequest *ur)
 
 	dbg("function entrance");
 	data = (struct treq_call_end *) tcore_user_request_ref_data(ur, 0);
-	co = tcore_call_object_find_by_id(o, data->id);
+	co = _call_slot_find(o, data->id);
 
 	dbg("type of release call = %d", data->type);
 
@@ -2726,8 +3117,10 @@ static TReturn s_call_hold(CoreObject *o, UserRequest *ur)
 	hold = (struct treq_call_hold *) tcore_user_request_ref_data(ur, 0);
 	dbg("call id : [ %d ]", hold->id);
 
-	co = tcore_call_object_find_by_id(o, hold->id);
-	tcore_call_control_hold(o, ur, on_confirmation_call_hold, co);
+	co = _call_slot_find(o, hold->id);
+	_call_chld_begin(o);
+	if (tcore_call_control_hold(o, ur, on_confirmation_call_hold, co) != TCORE_RETURN_SUCCESS)
+		_call_chld_done(o, FALSE, CALL_CHLD_SWAP, 0);
 
 	return TCORE_RETURN_SUCCESS;
 }
@@ -2740,8 +3133,10 @@ static TReturn s_call_active(CoreObject *o, UserRequest *ur)
 	active = (struct treq_call_active *) tcore_user_request_ref_data(ur, 0);
 	dbg("call id : [ %d ]", active->id);
 
-	co = tcore_call_object_find_by_id(o, active->id);
-	tcore_call_control_active(o, ur, on_confirmation_call_active, co);
+	co = _call_slot_find(o, active->id);
+	_call_chld_begin(o);
+	if (tcore_call_control_active(o, ur, on_confirmation_call_active, co) != TCORE_RETURN_SUCCESS)
+		_call_chld_done(o, FALSE, CALL_CHLD_SWAP, 0);
 
 	return TCORE_RETURN_SUCCESS;
 }
@@ -2754,8 +3149,10 @@ static TReturn s_call_swap(CoreObject *o, UserRequest *ur)
 	swap = (struct treq_call_swap *) tcore_user_request_ref_data(ur, 0);
 	dbg("call id : [ %d ]", swap->id);
 
-	co = tcore_call_object_find_by_id(o, swap->id);
-	tcore_call_control_swap(o, ur, on_confirmation_call_swap, co);
+	co = _call_slot_find(o, swap->id);
+	_call_chld_begin(o);
+	if (tcore_call_control_swap(o, ur, on_confirmation_call_swap, co) != TCORE_RETURN_SUCCESS)
+		_call_chld_done(o, FALSE, CALL_CHLD_SWAP, 0);
 
 	return TCORE_RETURN_SUCCESS;
 }
@@ -2768,8 +3165,10 @@ static TReturn s_call_join(CoreObject *o, UserRequest *ur)
 	join = (struct treq_call_join *) tcore_user_request_ref_data(ur, 0);
 	dbg("call id : [ %d ]", join->id);
 
-	co = tcore_call_object_find_by_id(o, join->id);
-	tcore_call_control_join(o, ur, on_confirmation_call_join, co);
+	co = _call_slot_find(o, join->id);
+	_call_chld_begin(o);
+	if (tcore_call_control_join(o, ur, on_confirmation_call_join, co) != TCORE_RETURN_SUCCESS)
+		_call_chld_done(o, FALSE, CALL_CHLD_JOIN, 0);
 
 	return TCORE_RETURN_SUCCESS;
 }
@@ -2780,10 +3179,12 @@ static TReturn s_call_split(CoreObject *o, UserRequest *ur)
 	CallObject *co = NULL;
 
 	split = (struct treq_call_split *) tcore_user_request_ref_data(ur, 0);
-	co = tcore_call_object_find_by_id(o, split->id);
+	co = _call_slot_find(o, split->id);
 	dbg("call id : [ %d ]", split->id);
 
-	tcore_call_control_split(o, ur, split->id, on_confirmation_call_split, co);
+	_call_chld_begin(o);
+	if (tcore_call_control_split(o, ur, split->id, on_confirmation_call_split, co) != TCORE_RETURN_SUCCESS)
+		_call_chld_done(o, FALSE, CALL_CHLD_SPLIT, split->id);
 
 	return TCORE_RETURN_SUCCESS;
 }
@@ -2810,7 +3211,7 @@ static TReturn s_call_transfer(CoreObject *o, UserRequest *ur)
 	transfer = (struct treq_call_transfer *) tcore_user_request_ref_data(ur, 0);
 	dbg("call id : [ %d ]", transfer->id);
 
-	co = tcore_call_object_find_by_id(o, transfer->id);
+	co = _call_slot_find(o, transfer->id);
 	tcore_call_control_transfer(o, ur, on_confirmation_call_transfer, co);
 
 	return TCORE_RETURN_SUCCESS;
@@ -2818,31 +3219,32 @@ static TReturn s_call_transfer(CoreObject *o, UserRequest *ur)
 
 static TReturn s_call_send_dtmf(CoreObject *o, UserRequest *ur)
 {
-	char *cmd_str = NULL;
 	TcorePending *pending = NULL;
 	TcoreATRequest *req;
-	UserRequest *dup;
 	gboolean ret = FALSE;
 	struct treq_call_dtmf *dtmf = 0;
-	char *dtmfstr = NULL, *tmp_dtmf = NULL;
+	char cmd_str[sizeof("AT+VTS=") + (MAX_CALL_DTMF_DIGITS_LEN * 2)];    // DTMF digits + comma for each dtmf digit.
+	char *tmp_dtmf = NULL;
+	unsigned int digit_count;
 	unsigned int dtmf_count;
 
 	dbg("Function enter");
 
-	dup = tcore_user_request_new(NULL, NULL);
-	(void) _set_dtmf_tone_duration(o, dup);
-
 	dtmf = (struct treq_call_dtmf *) tcore_user_request_ref_data(ur, 0);
-	dtmfstr = g_malloc0((MAX_CALL_DTMF_DIGITS_LEN * 2) + 1);    // DTMF digits + comma for each dtmf digit.
-
-	if (dtmfstr == NULL) {
-		dbg("Memory allocation failed");
-		return TCORE_RETURN_FAILURE;
+	digit_count = strnlen(dtmf->digits, MIN(sizeof(dtmf->digits), MAX_CALL_DTMF_DIGITS_LEN));
+	if (digit_count == 0) {
+		err("No DTMF digits");
+		return TCORE_RETURN_EINVAL;
 	}
+	dbg("Input DTMF string(%.*s)", digit_count, dtmf->digits);
+
+	(void) _set_dtmf_tone_duration(o, CALL_DTMF_TONE_DURATION);
 
-	tmp_dtmf = dtmfstr;
+	// AT+VTS = <d1>,<d2>,<d3>,<d4>,<d5>,<d6>, ..... <d32>
+	strcpy(cmd_str, "AT+VTS=");
+	tmp_dtmf = cmd_str + strlen(cmd_str);
 
-	for (dtmf_count = 0; dtmf_count < strlen(dtmf->digits); dtmf_count++) {
+	for (dtmf_count = 0; dtmf_count < digit_count; dtmf_count++) {
 		*tmp_dtmf = dtmf->digits[dtmf_count];
 		tmp_dtmf++;
 
@@ -2852,10 +3254,6 @@ static TReturn s_call_send_dtmf(CoreObject *o, UserRequest *ur)
 
 	// last digit is having COMMA , overwrite it with '\0' .
 	*(--tmp_dtmf) = '\0';
-	dbg("Input DTMF string(%s)", dtmfstr);
-
-	// AT+VTS = <d1>,<d2>,<d3>,<d4>,<d5>,<d6>, ..... <d32>
-	cmd_str = g_strdup_printf("AT+VTS=%s", dtmfstr);
 	dbg("request command : %s", cmd_str);
 
 	pending = tcore_pending_new(o, 0);
@@ -2864,9 +3262,6 @@ static TReturn s_call_send_dtmf(CoreObject *o, UserRequest *ur)
 
 	tcore_pending_set_request_data(pending, 0, req);
 	ret = _call_request_message(pending, o, ur, on_confirmation_call_dtmf, NULL);
-	g_free(dtmfstr);
-	g_free(cmd_str);
-
 	if (!ret) {
 		dbg("AT request sent failed")
 		return TCORE_RETURN_FAILURE;
@@ -2877,209 +3272,76 @@ static TReturn s_call_send_dtmf(CoreObject *o, UserRequest *ur)
 
 static TReturn s_call_set_sound_path(CoreObject *o, UserRequest *ur)
 {
-	UserRequest *ur_dup = NULL;
-	TcorePending *pending = NULL, *pending1 = NULL;
-	TcoreATRequest *req, *req1;
-	char *cmd_str = NULL, *cmd_str1 = NULL;
-	gboolean ret = FALSE;
-
-	dbg("function entrance");
-
 	// hard coded value for speaker.
-	cmd_str = g_strdup_printf("%s", "AT+XDRV=40,4,3,0,0,0,0,0,1,0,1,0,1"); // source type.
-	cmd_str1 = g_strdup_printf("%s", "AT+XDRV=40,5,2,0,0,0,0,0,1,0,1,0,1"); // destination type
-
-	pending = tcore_pending_new(o, 0);
-	req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
-
-	tcore_pending_set_request_data(pending, 0, req);
-	ur_dup = tcore_user_request_ref(ur);
-
-	ret = _call_request_message(pending, o, ur_dup, on_confirmation_call_set_source_sound_path, NULL);
+	const struct call_audio_write writes[] = {
+		{ CALL_AUDIO_SOURCE_PATH, "0,0,0,0,0,1,0,1,0,1" },
+		{ CALL_AUDIO_DESTINATION_PATH, "0,0,0,0,0,1,0,1,0,1" },
+	};
 
-	g_free(cmd_str);
-
-	if (!ret) {
-		dbg("At request(%s) sent failed", req->cmd);
-		return TCORE_RETURN_FAILURE;
-	}
-
-	pending1 = tcore_pending_new(o, 0);
-	req1 = tcore_at_request_new(cmd_str1, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("input command is %s", cmd_str1);
-	dbg("req-cmd : %s, prefix(if any) :%s, cmd_len : %d", req1->cmd, req1->prefix, strlen(req1->cmd));
-
-	tcore_pending_set_request_data(pending1, 0, req1);
-	ret = _call_request_message(pending1, o, ur, on_confirmation_call_set_destination_sound_path, NULL);
-
-	g_free(cmd_str1);
-
-	if (!ret) {
-		dbg("AT request %s has failed ", req1->cmd);
-		return TCORE_RETURN_FAILURE;
-	}
+	dbg("function entrance");
 
-	return TCORE_RETURN_SUCCESS;
+	return _call_audio_apply(o, ur, TRESP_CALL_SET_SOUND_PATH, writes, G_N_ELEMENTS(writes));
 }
 
 static TReturn s_call_set_sound_volume_level(CoreObject *o, UserRequest *ur)
 {
-	UserRequest *src_ur = NULL;
-	UserRequest *dest_ur = NULL;
-	TcorePending *src_pending = NULL;
-	TcorePending *dest_pending = NULL;
-	TcoreATRequest *src_req = NULL;
-	TcoreATRequest *dest_req = NULL;
-	char *cmd_str = NULL, *volume_level = NULL;
-	gboolean ret = FALSE;
-
 	struct treq_call_sound_set_volume_level *data = NULL;
+	struct call_audio_write writes[] = {
+		// Hard-coded values for MIC & Speakers
+		{ CALL_AUDIO_SOURCE_VOLUME, "88" },
+		{ CALL_AUDIO_SOURCE_VOLUME_0, "88" },
+		{ CALL_AUDIO_DESTINATION_VOLUME_0, "88" },
+		{ CALL_AUDIO_DESTINATION_VOLUME, NULL },
+	};
+
 	data = (struct treq_call_sound_set_volume_level *) tcore_user_request_ref_data(ur, 0);
 	dbg("Entry");
-	// Hard-coded values for MIC & Speakers
-	// Source volume
-	dbg("Set Source volume");
-
-	cmd_str = g_strdup_printf("%s", "AT+XDRV=40,7,3,88");   // Source type
-	dbg("Request command string: %s", cmd_str);
-
-	// Create new Pending request
-	src_pending = tcore_pending_new(o, 0);
-
-	// Create new AT-Command request
-	src_req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("Command: %s, prefix(if any): %s, Command length: %d", src_req->cmd, src_req->prefix, strlen(src_req->cmd));
-
-	// Free Command string
-	g_free(cmd_str);
-
-	tcore_pending_set_request_data(src_pending, 0, src_req);
-	src_ur = tcore_user_request_ref(ur);
-
-	// Send request
-	ret = _call_request_message(src_pending, o, src_ur, on_confirmation_call_set_source_sound_volume_level, NULL);
-	if (!ret) {
-		err("Failed to send AT-Command request");
-		return TCORE_RETURN_FAILURE;
-	}
-
-	cmd_str = g_strdup_printf("%s", "AT+XDRV=40,7,0,88");   // Destination type
-	dbg("Request command string: %s", cmd_str);
-
-	// Create new Pending request
-	src_pending = tcore_pending_new(o, 0);
-
-	// Create new AT-Command request
-	src_req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("Command: %s, prefix(if any): %s, Command length: %d", src_req->cmd, src_req->prefix, strlen(src_req->cmd));
-
-	// Free Command string
-	g_free(cmd_str);
-
-	tcore_pending_set_request_data(src_pending, 0, src_req);
-
-	src_ur = tcore_user_request_ref(ur);
-
-	// Send request
-	ret = _call_request_message(src_pending, o, src_ur, on_confirmation_call_set_source_sound_volume_level, NULL);
-	if (!ret) {
-		err("Failed to send AT-Command request");
-		return TCORE_RETURN_FAILURE;
-	}
-
-	// Destination volume
-	dbg("Set Source volume");
-
-	cmd_str = g_strdup_printf("%s", "AT+XDRV=40,8,0,88");   // Source type
-	dbg("Request command string: %s", cmd_str);
-
-	// Create new Pending request
-	dest_pending = tcore_pending_new(o, 0);
-
-	// Create new AT-Command request
-	dest_req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("Command: %s, prefix(if any): %s, Command length: %d", dest_req->cmd, dest_req->prefix, strlen(dest_req->cmd));
-
-	// Free Command string
-	g_free(cmd_str);
-
-	tcore_pending_set_request_data(dest_pending, 0, dest_req);
-	dest_ur = tcore_user_request_ref(ur);
-
-	// Send request
-	ret = _call_request_message(dest_pending, o, dest_ur, on_confirmation_call_set_source_sound_volume_level, NULL);
-	if (!ret) {
-		err("Failed to send AT-Command request");
-		return TCORE_RETURN_FAILURE;
-	}
 
 	dbg("Input volume level - %d", data->volume);
 	switch (data->volume) {
 	case CALL_SOUND_MUTE:
-		volume_level = "0";
+		writes[3].value = "0";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_1:
-		volume_level = "40";
+		writes[3].value = "40";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_2:
-		volume_level = "46";
+		writes[3].value = "46";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_3:
-		volume_level = "52";
+		writes[3].value = "52";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_4:
-		volume_level = "58";
+		writes[3].value = "58";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_5:
-		volume_level = "64";
+		writes[3].value = "64";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_6:
-		volume_level = "70";
+		writes[3].value = "70";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_7:
-		volume_level = "76";
+		writes[3].value = "76";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_8:
-		volume_level = "82";
+		writes[3].value = "82";
 		break;
 
 	case CALL_SOUND_VOLUME_LEVEL_9:
 	default:
-		volume_level = "88";
+		writes[3].value = "88";
 		break;
 	}
-	cmd_str = g_strdup_printf("%s%s", "AT+XDRV=40,8,2,", volume_level);   // Destination type
-	dbg("Request command string: %s", cmd_str);
-
-	// Create new Pending request
-	dest_pending = tcore_pending_new(o, 0);
-
-	// Create new AT-Command request
-	dest_req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("Command: %s, prefix(if any): %s, Command length: %d", dest_req->cmd, dest_req->prefix, strlen(dest_req->cmd));
-
-	// Free Command string
-	g_free(cmd_str);
-
-	tcore_pending_set_request_data(dest_pending, 0, dest_req);
 
-	// Send request
-	ret = _call_request_message(dest_pending, o, ur, on_confirmation_call_set_destination_sound_volume_level, NULL);
-	if (!ret) {
-		err("Failed to send AT-Command request");
-		return TCORE_RETURN_FAILURE;
-	}
-
-	return TCORE_RETURN_SUCCESS;
+	return _call_audio_apply(o, ur, TRESP_CALL_SET_SOUND_VOLUME_LEVEL, writes, G_N_ELEMENTS(writes));
 }
 
 
@@ -3093,93 +3355,138 @@ static TReturn s_call_get_sound_volume_level(CoreObject *o, UserRequest *ur)
 
 static TReturn s_call_mute(CoreObject *o, UserRequest *ur)
 {
-	char *cmd_str = NULL;
-	TcorePending *pending = NULL;
-	TcoreATRequest *req = NULL;
-	gboolean ret = FALSE;
+	const struct call_audio_write writes[] = {
+		{ CALL_AUDIO_DESTINATION_VOLUME_0, "0,0" },
+	};
 
 	dbg("Entry");
-	cmd_str = g_strdup_printf("%s", "AT+XDRV=40,8,0,0,0");
 
-	dbg("Request command string: %s", cmd_str);
+	return _call_audio_apply(o, ur, TRESP_CALL_MUTE, writes, G_N_ELEMENTS(writes));
+}
 
-	// Create new Pending request
-	pending = tcore_pending_new(o, 0);
+static TReturn s_call_unmute(CoreObject *o, UserRequest *ur)
+{
+	const struct call_audio_write writes[] = {
+		{ CALL_AUDIO_DESTINATION_VOLUME_0, "0,88" },
+	};
 
-	// Create new AT-Command request
-	req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("Command: %s, prefix(if any): %s, Command length: %d", req->cmd, req->prefix, strlen(req->cmd));
+	dbg("Entry");
 
-	// Free command string
-	g_free(cmd_str);
+	return _call_audio_apply(o, ur, TRESP_CALL_UNMUTE, writes, G_N_ELEMENTS(writes));
+}
 
-	// Set request data (AT command) to Pending request
-	tcore_pending_set_request_data(pending, 0, req);
 
-	// Send request
-	ret = _call_request_message(pending, o, ur, on_confirmation_call_mute, NULL);
-	if (!ret) {
-		err("Failed to send AT-Command request");
-		return TCORE_RETURN_FAILURE;
-	}
+static TReturn s_call_get_mute_status(CoreObject *o, UserRequest *ur)
+{
+	dbg("Entry");
 
 	dbg("Exit");
 	return TCORE_RETURN_SUCCESS;
 }
 
-static TReturn s_call_unmute(CoreObject *o, UserRequest *ur)
+static TReturn _call_audio_apply(CoreObject *o, UserRequest *ur, enum tcore_response_command command,
+								const struct call_audio_write *writes, unsigned int count)
 {
-	char *cmd_str = NULL;
+	struct call_property *prop = NULL;
+	struct call_audio_batch *batch = NULL;
 	TcorePending *pending = NULL;
 	TcoreATRequest *req = NULL;
+	UserRequest *pending_ur;
+	char *cmd_str = NULL;
 	gboolean ret = FALSE;
+	unsigned int i;
+
 	dbg("Entry");
+	prop = _call_ref_property(o);
 
-	cmd_str = g_strdup_printf("%s", "AT+XDRV=40,8,0,0,88");
-	dbg("Request command string: %s", cmd_str);
+	batch = g_new0(struct call_audio_batch, 1);
+	batch->command = command;
 
-	// Create new Pending request
-	pending = tcore_pending_new(o, 0);
+	// Drop the settings the modem already has
+	for (i = 0; i < count; i++) {
+		if (prop && g_strcmp0(prop->audio[writes[i].setting], writes[i].value) == 0) {
+			dbg("%s already set to %s", call_audio_xdrv_cmd[writes[i].setting], writes[i].value);
+			continue;
+		}
 
-	// Create new AT-Command request
-	req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
-	dbg("Command: %s, prefix(if any): %s, Command length: %d", req->cmd, req->prefix, strlen(req->cmd));
+		batch->writes[batch->count++] = writes[i];
+	}
 
-	// Free command string
-	g_free(cmd_str);
+	if (batch->count == 0) {
+		dbg("Audio already in the requested state");
+		_call_audio_send_response(ur, command, TCORE_RETURN_SUCCESS);
+		g_free(batch);
+		return TCORE_RETURN_SUCCESS;
+	}
 
-	// Set request data (AT command) to Pending request
-	tcore_pending_set_request_data(pending, 0, req);
+	for (i = 0; i < batch->count; i++) {
+		cmd_str = g_strdup_printf("%s,%s", call_audio_xdrv_cmd[batch->writes[i].setting], batch->writes[i].value);
+		dbg("Request command string: %s", cmd_str);
+
+		// Create new Pending request
+		pending = tcore_pending_new(o, 0);
+
+		// Create new AT-Command request
+		req = tcore_at_request_new(cmd_str, "+XDRV", TCORE_AT_SINGLELINE);
+		dbg("Command: %s, prefix(if any): %s, Command length: %d", req->cmd, req->prefix, strlen(req->cmd));
+
+		// Free Command string
+		g_free(cmd_str);
+
+		tcore_pending_set_request_data(pending, 0, req);
+
+		// Only the last command answers TAPI
+		if (i == batch->count - 1)
+			pending_ur = ur;
+		else
+			pending_ur = tcore_user_request_ref(ur);
+
+		// Send request
+		ret = _call_request_message(pending, o, pending_ur, on_confirmation_call_audio, batch);
+		if (!ret) {
+			err("Failed to send AT-Command request");
+			break;
+		}
+
+		// Assume it is applied, the confirmation drops the value on failure
+		if (prop)
+			g_strlcpy(prop->audio[batch->writes[i].setting], batch->writes[i].value, CALL_AUDIO_VALUE_LEN);
+	}
 
-	// Send request
-	ret = _call_request_message(pending, o, ur, on_confirmation_call_unmute, NULL);
 	if (!ret) {
-		err("Failed to send AT-Command request");
+		if (i == 0) {
+			g_free(batch);
+		} else {
+			// Commands already queued release the batch once answered
+			batch->count = i;
+		}
 		return TCORE_RETURN_FAILURE;
 	}
 
-	dbg("Exit");
-	return TCORE_RETURN_SUCCESS;
-}
-
-
-static TReturn s_call_get_mute_status(CoreObject *o, UserRequest *ur)
-{
-	dbg("Entry");
+	batch->queued = TRUE;
 
 	dbg("Exit");
 	return TCORE_RETURN_SUCCESS;
 }
 
-static TReturn _set_dtmf_tone_duration(CoreObject *o, UserRequest *ur)
+static TReturn _set_dtmf_tone_duration(CoreObject *o, int duration)
 {
 	char *cmd_str = NULL;
 	TcorePending *pending = NULL;
 	TcoreATRequest *req = NULL;
+	UserRequest *ur;
+	struct call_property *prop = NULL;
 	gboolean ret = FALSE;
 	dbg("Entry");
 
-	cmd_str = g_strdup_printf("%s", "AT+VTD=3"); // ~300 mili secs. +VTD= n, where  n = (0 - 255) * 1/10 secs.
+	// Tone duration sticks in the modem, skip AT+VTD while it is unchanged
+	prop = _call_ref_property(o);
+	if (prop && prop->dtmf_duration_valid && prop->dtmf_duration == duration) {
+		dbg("DTMF tone duration [%d] already set", duration);
+		return TCORE_RETURN_SUCCESS;
+	}
+
+	cmd_str = g_strdup_printf("AT+VTD=%d", duration); // +VTD= n, where  n = (0 - 255) * 1/10 secs.
 	dbg("Request command string: %s", cmd_str);
 
 	// Create new Pending request
@@ -3196,12 +3503,19 @@ static TReturn _set_dtmf_tone_duration(CoreObject *o, UserRequest *ur)
 	tcore_pending_set_request_data(pending, 0, req);
 
 	// Send request
+	ur = tcore_user_request_new(NULL, NULL);
 	ret = _call_request_message(pending, o, ur, _on_confirmation_dtmf_tone_duration, NULL);
 	if (!ret) {
 		err("Failed to send AT-Command request");
 		return TCORE_RETURN_FAILURE;
 	}
 
+	// Assume it is applied, the confirmation drops the cache on failure
+	if (prop) {
+		prop->dtmf_duration = duration;
+		prop->dtmf_duration_valid = TRUE;
+	}
+
 	dbg("Exit");
 	return TCORE_RETURN_SUCCESS;
 }
@@ -3857,6 +4171,7 @@ gboolean s_call_init(TcorePlugin *p, TcoreHal *h)
 {
 	CoreObject *o = NULL;
 	struct property_call_info *data = NULL;
+	struct call_property *prop = NULL;
 	dbg("Entry");
 
 	// Creating Call COre object
@@ -3877,6 +4192,9 @@ gboolean s_call_init(TcorePlugin *p, TcoreHal *h)
 	data = calloc(sizeof(struct property_call_info *), 1);
 	tcore_plugin_link_property(p, "CALL", data);
 
+	prop = calloc(sizeof(struct call_property), 1);
+	tcore_plugin_link_property(p, "CALLPROPERTY", prop);
+
 	dbg("Exit");
 	return TRUE;
 }
@@ -3885,10 +4203,18 @@ void s_call_exit(TcorePlugin *p)
 {
 	CoreObject *o = NULL;
 	struct property_network_info *data = NULL;
+	struct call_property *prop = NULL;
 	dbg("Entry");
 
 	o = tcore_plugin_ref_core_object(p, "call");
 
+	// Free plugin side call state
+	prop = tcore_plugin_ref_property(p, "CALLPROPERTY");
+	if (prop) {
+		_call_mt_pending_clear(prop);
+		free(prop);
+	}
+
 	// Free Call Core Object */
 	tcore_call_free(o);
 
@@ -26,8 +26,10 @@
 
 
 #include "s_common.h"
+#include "common/TelErr.h"
 
 #include <plugin.h>
+#include <co_sms.h>
 
 #undef  MAX
 #define MAX(a, b)  (((a) > (b)) ? (a) : (b))
@@ -53,6 +55,140 @@ char _util_unpackb(const char *src, int pos, int len);
 char _util_convert_byte_hexChar(char val);
 gboolean util_byte_to_hex(const char *byte_pdu, char *hex_pdu, int num_bytes);
 
+struct util_at_error_entry {
+	const char *text;           // Verbose form, at+cmee=2
+	enum util_at_error_class error_class;
+	TReturn result;
+	int sms_result;
+};
+
+#define AT_ERROR(text, error_class, result, sms_result) \
+	{ text, UTIL_AT_ERROR_##error_class, result, sms_result }
+
+// Indexed by <err>, codes not listed decode as a generic permanent error
+static const struct util_at_error_entry util_cme_error_table[UTIL_CME_ERROR_MAX] = {
+	[TAPI_OP_GEN_ERR_PHONE_FAILURE] = AT_ERROR("phone failure", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_PHONE_FAILURE),
+	[TAPI_OP_GEN_ERR_NO_CONNECTION_TO_PHONE] = AT_ERROR("no connection to phone", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_PHONE_ADAPTOR_LINK_RESERVED] = AT_ERROR("phone-adaptor link reserved", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_OPER_NOT_ALLOWED] = AT_ERROR("operation not allowed", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_OPER_NOT_SUPPORTED] = AT_ERROR("operation not supported", PERMANENT, TCORE_RETURN_ENOSYS, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_PH_SIM_PIN_REQU] = AT_ERROR("PH-SIM PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_PH_FSIM_PIN_REQU] = AT_ERROR("PH-FSIM PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_PH_FSIM_PUK_REQU] = AT_ERROR("PH-FSIM PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SIM_NOT_INSERTED] = AT_ERROR("SIM not inserted", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_NO_SIM),
+	[TAPI_OP_GEN_ERR_SIM_PIN_REQU] = AT_ERROR("SIM PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SIM_PUK_REQU] = AT_ERROR("SIM PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SIM_FAILURE] = AT_ERROR("SIM failure", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_NO_SIM),
+	[TAPI_OP_GEN_ERR_SIM_BUSY] = AT_ERROR("SIM busy", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SIM_WRONG] = AT_ERROR("SIM wrong", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_NO_SIM),
+	[TAPI_OP_GEN_ERR_INCORRECT_PW] = AT_ERROR("incorrect password", PERMANENT, TCORE_RETURN_EACCES, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_SIM_PIN2_REQU] = AT_ERROR("SIM PIN2 required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SIM_PUK2_REQU] = AT_ERROR("SIM PUK2 required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_MEM_FULL] = AT_ERROR("memory full", PERMANENT, TCORE_RETURN_ENOMEM, SMS_MEMORY_CAPACITY_EXCEEDED),
+	[TAPI_OP_GEN_ERR_INVALID_INDEX] = AT_ERROR("invalid index", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[TAPI_OP_GEN_ERR_NOT_FOUND] = AT_ERROR("not found", PERMANENT, TCORE_RETURN_ENOENT, SMS_INVALID_PARAMETER_FORMAT),
+	[TAPI_OP_GEN_ERR_MEM_FAILURE] = AT_ERROR("memory failure", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_TEXT_STR_TOO_LONG] = AT_ERROR("text string too long", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[TAPI_OP_GEN_ERR_INVALID_CHARACTERS_IN_TEXT_STR] = AT_ERROR("invalid characters in text string", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[TAPI_OP_GEN_ERR_DIAL_STR_TOO_LONG] = AT_ERROR("dial string too long", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[TAPI_OP_GEN_ERR_INVALID_CHARACTERS_IN_DIAL_STR] = AT_ERROR("invalid characters in dial string", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[TAPI_OP_GEN_ERR_NO_NET_SVC] = AT_ERROR("no network service", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_NET_TIMEOUT] = AT_ERROR("network timeout", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_NET_NOT_ALLOWED_EMERGENCY_CALLS_ONLY] = AT_ERROR("network not allowed - emergency calls only", PERMANENT, TCORE_RETURN_EPERM, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_NET_PERS_PIN_REQU] = AT_ERROR("network personalization PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_NET_PERS_PUK_REQU] = AT_ERROR("network personalization PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_NET_SUBSET_PERS_PIN_REQU] = AT_ERROR("network subset personalization PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_NET_SUBSET_PERS_PUK_REQU] = AT_ERROR("network subset personalization PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SVC_PROVIDER_PERS_PIN_REQU] = AT_ERROR("service provider personalization PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_SVC_PROVIDER_PERS_PUK_REQU] = AT_ERROR("service provider personalization PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_CORPORATE_PERS_PIN_REQU] = AT_ERROR("corporate personalization PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_CORPORATE_PERS_PUK_REQU] = AT_ERROR("corporate personalization PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_HIDDEN_KEY_REQU] = AT_ERROR("hidden key required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[TAPI_OP_GEN_ERR_UNKNOWN] = AT_ERROR("unknown", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_ILLEGAL_MS] = AT_ERROR("Illegal MS", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_ILLEGAL_ME] = AT_ERROR("Illegal ME", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_GPRS_SVC_NOT_ALLOWED] = AT_ERROR("GPRS services not allowed", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_PLMN_NOT_ALLOWED] = AT_ERROR("PLMN not allowed", PERMANENT, TCORE_RETURN_3GPP_PLMN_NOT_ALLOWED, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_LOCATION_AREA_NOT_ALLOWED] = AT_ERROR("Location area not allowed", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_ROAMING_NOT_ALLOWED_IN_THIS_LOCATION_AREA] = AT_ERROR("Roaming not allowed in this location area", PERMANENT, TCORE_RETURN_3GPP_ROAMING_NOT_ALLOWED, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_SVC_OPT_NOT_SUPPORTED] = AT_ERROR("service option not supported", PERMANENT, TCORE_RETURN_ENOSYS, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_REQ_SVC_OPT_NOT_SUBSCRIBED] = AT_ERROR("requested service option not subscribed", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_SVC_OPT_TEMPORARILY_OUT_OF_ORDER] = AT_ERROR("service option temporarily out of order", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_UNSPECIFIED_GPRS_ERR] = AT_ERROR("unspecified GPRS error", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_PDP_AUTHENTICATION_FAILURE] = AT_ERROR("PDP authentication failure", PERMANENT, TCORE_RETURN_EACCES, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_INVALID_MOBILE_CLASS] = AT_ERROR("invalid mobile class", PERMANENT, TCORE_RETURN_EINVAL, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_CONGESTION] = AT_ERROR("congestion", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_NET_FAILURE] = AT_ERROR("network failure", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_UPLINK_BUSY] = AT_ERROR("uplink busy", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[TAPI_OP_GEN_ERR_NO_ACCESS_RIGHTS_FOR_SIM_FILE] = AT_ERROR("no access rights for SIM file", PERMANENT, TCORE_RETURN_EACCES, SMS_DEVICE_FAILURE),
+	[TAPI_OP_GEN_ERR_OPER_NOT_APPLICABLE_OR_NOT_POSSIBLE] = AT_ERROR("operation not applicable or not possible", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+
+	// Call and supplementary service errors
+	[257] = AT_ERROR("network rejected request", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[258] = AT_ERROR("retry operation", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_DEVICE_FAILURE),
+	[259] = AT_ERROR("invalid deflected to number", PERMANENT, TCORE_RETURN_EINVAL, SMS_DEVICE_FAILURE),
+	[260] = AT_ERROR("deflected to own number", PERMANENT, TCORE_RETURN_EINVAL, SMS_DEVICE_FAILURE),
+	[261] = AT_ERROR("unknown subscriber", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[262] = AT_ERROR("service not available", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_DEVICE_FAILURE),
+	[263] = AT_ERROR("unknown class", PERMANENT, TCORE_RETURN_EINVAL, SMS_DEVICE_FAILURE),
+	[264] = AT_ERROR("unknown network message", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+};
+
+// 0..127 are RP causes (3GPP TS 24.011 E.2), 300 and up are ME/network errors
+static const struct util_at_error_entry util_cms_error_table[UTIL_CMS_ERROR_MAX] = {
+	[1] = AT_ERROR("unassigned number", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_INVALID_PARAMETER),
+	[8] = AT_ERROR("operator determined barring", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[10] = AT_ERROR("call barred", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[21] = AT_ERROR("short message transfer rejected", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[22] = AT_ERROR("memory capacity exceeded", PERMANENT, TCORE_RETURN_ENOMEM, SMS_MEMORY_CAPACITY_EXCEEDED),
+	[27] = AT_ERROR("destination out of service", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[28] = AT_ERROR("unidentified subscriber", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_INVALID_PARAMETER),
+	[29] = AT_ERROR("facility rejected", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[30] = AT_ERROR("unknown subscriber", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_INVALID_PARAMETER),
+	[38] = AT_ERROR("network out of order", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[41] = AT_ERROR("temporary failure", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[42] = AT_ERROR("congestion", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[47] = AT_ERROR("resources unavailable, unspecified", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[50] = AT_ERROR("requested facility not subscribed", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[69] = AT_ERROR("requested facility not implemented", PERMANENT, TCORE_RETURN_ENOSYS, SMS_DEVICE_FAILURE),
+	[81] = AT_ERROR("invalid short message transfer reference value", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER),
+	[95] = AT_ERROR("invalid message, unspecified", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER),
+	[96] = AT_ERROR("invalid mandatory information", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER),
+	[97] = AT_ERROR("message type non-existent or not implemented", PERMANENT, TCORE_RETURN_ENOSYS, SMS_DEVICE_FAILURE),
+	[98] = AT_ERROR("message not compatible with short message protocol state", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[99] = AT_ERROR("information element non-existent or not implemented", PERMANENT, TCORE_RETURN_ENOSYS, SMS_DEVICE_FAILURE),
+	[111] = AT_ERROR("protocol error, unspecified", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[127] = AT_ERROR("interworking, unspecified", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+
+	[300] = AT_ERROR("ME failure", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_PHONE_FAILURE),
+	[301] = AT_ERROR("SMS service of ME reserved", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_DEVICE_FAILURE),
+	[302] = AT_ERROR("operation not allowed", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[303] = AT_ERROR("operation not supported", PERMANENT, TCORE_RETURN_ENOSYS, SMS_DEVICE_FAILURE),
+	[304] = AT_ERROR("invalid PDU mode parameter", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[305] = AT_ERROR("invalid text mode parameter", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[310] = AT_ERROR("SIM not inserted", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_NO_SIM),
+	[311] = AT_ERROR("SIM PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[312] = AT_ERROR("PH-SIM PIN required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[313] = AT_ERROR("SIM failure", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_NO_SIM),
+	[314] = AT_ERROR("SIM busy", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_SIM_NOT_READY),
+	[315] = AT_ERROR("SIM wrong", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_NO_SIM),
+	[316] = AT_ERROR("SIM PUK required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[317] = AT_ERROR("SIM PIN2 required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[318] = AT_ERROR("SIM PUK2 required", LOCKED, TCORE_RETURN_EACCES, SMS_SIM_NOT_READY),
+	[320] = AT_ERROR("memory failure", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+	[321] = AT_ERROR("invalid memory index", PERMANENT, TCORE_RETURN_EINVAL, SMS_INVALID_PARAMETER_FORMAT),
+	[322] = AT_ERROR("memory full", PERMANENT, TCORE_RETURN_ENOMEM, SMS_MEMORY_CAPACITY_EXCEEDED),
+	[330] = AT_ERROR("SMSC address unknown", PERMANENT, TCORE_RETURN_EINVAL, SMS_SCADDR_NOT_AVAILABLE),
+	[331] = AT_ERROR("no network service", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[332] = AT_ERROR("network timeout", RETRYABLE, TCORE_RETURN_ETIMEDOUT, SMS_NO_NETWORK_RESP),
+	[340] = AT_ERROR("no +CNMA acknowledgement expected", PERMANENT, TCORE_RETURN_EPERM, SMS_DEVICE_FAILURE),
+	[500] = AT_ERROR("unknown error", PERMANENT, TCORE_RETURN_3GPP_ERROR, SMS_DEVICE_FAILURE),
+};
+
+// Verbose text to <err>, built on first use
+static GHashTable *util_cme_error_index;
+static GHashTable *util_cms_error_index;
+
 void util_hex_dump(char *pad, int size, const void *data)
 {
 	char buf[255] = {0, };
@@ -284,3 +420,301 @@ char* util_removeQuotes(void *data)
 
 	return tmp;
 }
+
+static GHashTable *_util_at_error_index(GHashTable **index, const struct util_at_error_entry *table, int max)
+{
+	int code;
+
+	if (*index)
+		return *index;
+
+	*index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	for (code = 0; code < max; code++) {
+		if (table[code].text)
+			g_hash_table_insert(*index, g_ascii_strdown(table[code].text, -1), GINT_TO_POINTER(code + 1));
+	}
+
+	return *index;
+}
+
+void util_at_error_decode(const char *final_response, struct util_at_error *error)
+{
+	const struct util_at_error_entry *table = util_cme_error_table;
+	GHashTable **index = &util_cme_error_index;
+	int max = UTIL_CME_ERROR_MAX;
+	const char *cause = NULL;
+	char *text = NULL;
+
+	error->cms = FALSE;
+	error->code = -1;
+	error->error_class = UTIL_AT_ERROR_PERMANENT;
+	error->result = TCORE_RETURN_3GPP_ERROR;
+	error->sms_result = SMS_DEVICE_FAILURE;
+
+	if (!final_response)
+		return;
+
+	if (g_str_has_prefix(final_response, "+CMS ERROR:")) {
+		error->cms = TRUE;
+		table = util_cms_error_table;
+		index = &util_cms_error_index;
+		max = UTIL_CMS_ERROR_MAX;
+		cause = final_response + strlen("+CMS ERROR:");
+	} else if (g_str_has_prefix(final_response, "+CME ERROR:")) {
+		cause = final_response + strlen("+CME ERROR:");
+	} else {
+		dbg("No error cause in [%s]", final_response);
+		return;
+	}
+
+	while (*cause == ' ')
+		cause++;
+
+	if (g_ascii_isdigit(*cause)) {
+		error->code = atoi(cause);
+	} else {
+		text = g_strstrip(g_ascii_strdown(cause, -1));
+		error->code = GPOINTER_TO_INT(g_hash_table_lookup(_util_at_error_index(index, table, max), text)) - 1;
+		g_free(text);
+	}
+
+	if (error->code < 0 || error->code >= max || !table[error->code].text) {
+		dbg("Unknown error cause [%s]", final_response);
+		return;
+	}
+
+	error->error_class = table[error->code].error_class;
+	error->result = table[error->code].result;
+	error->sms_result = table[error->code].sms_result;
+
+	dbg("%s ERROR: %d (%s), class [%d]", error->cms ? "CMS" : "CME", error->code,
+		table[error->code].text, error->error_class);
+}
+
+TReturn util_at_error_result(const char *final_response)
+{
+	struct util_at_error error;
+
+	util_at_error_decode(final_response, &error);
+	return error.result;
+}
+
+int util_at_error_sms_result(const char *final_response)
+{
+	struct util_at_error error;
+
+	util_at_error_decode(final_response, &error);
+	return error.sms_result;
+}
+
+/* Hex string of a GET RESPONSE, bytes are decoded where they are read */
+struct util_hex_buf {
+	const char *hex;
+	int len;                    // in bytes
+};
+
+static int _util_hex_byte(const struct util_hex_buf *buf, int offset)
+{
+	int hi;
+	int lo;
+
+	if (offset < 0 || offset >= buf->len)
+		return -1;
+
+	hi = g_ascii_xdigit_value(buf->hex[offset * 2]);
+	lo = g_ascii_xdigit_value(buf->hex[offset * 2 + 1]);
+	if (hi < 0 || lo < 0)
+		return -1;
+
+	return (hi << 4) | lo;
+}
+
+/* Big endian, size up to 4 bytes */
+static int _util_hex_uint(const struct util_hex_buf *buf, int offset, int size)
+{
+	int value = 0;
+	int byte;
+	int i;
+
+	for (i = 0; i < size; i++) {
+		byte = _util_hex_byte(buf, offset + i);
+		if (byte < 0)
+			return -1;
+		value = (value << 8) | byte;
+	}
+
+	return value;
+}
+
+/* Reads a BER-TLV header at *offset and leaves *offset on its value, which must end before end */
+static gboolean _util_tlv_next(const struct util_hex_buf *buf, int *offset, int end, int *tag, int *len)
+{
+	int t = _util_hex_byte(buf, *offset);
+	int l = _util_hex_byte(buf, *offset + 1);
+
+	if (t < 0 || l < 0)
+		return FALSE;
+
+	*offset += 2;
+
+	if (l == 0x81) {
+		l = _util_hex_byte(buf, *offset);
+		if (l < 0)
+			return FALSE;
+		*offset += 1;
+	} else if (l > 0x80) {
+		// Longer forms never occur in an FCP
+		return FALSE;
+	}
+
+	if (*offset + l > end)
+		return FALSE;
+
+	*tag = t;
+	*len = l;
+	return TRUE;
+}
+
+/*
+ * ETSI TS 102 221 11.1.1.3, FCP template '62' holding
+ * '82' file descriptor, '83' file identifier, '80' file size and
+ * optional tags that are skipped.
+ */
+static gboolean _util_sim_fcp_decode_usim(const struct util_hex_buf *buf, struct util_sim_fcp *fcp)
+{
+	gboolean descriptor = FALSE;
+	int offset = 0;
+	int end = 0;
+	int tag = 0;
+	int len = 0;
+
+	if (!_util_tlv_next(buf, &offset, buf->len, &tag, &len) || tag != 0x62)
+		return FALSE;
+
+	end = offset + len;
+	while (offset < end) {
+		if (!_util_tlv_next(buf, &offset, end, &tag, &len))
+			return FALSE;
+
+		switch (tag) {
+		case 0x82:
+			if (len < 1)
+				return FALSE;
+
+			switch (_util_hex_byte(buf, offset) & 0x07) {
+			case 0x01:
+				fcp->structure = UTIL_SIM_FILE_TRANSPARENT;
+				break;
+
+			case 0x02:
+				fcp->structure = UTIL_SIM_FILE_LINEAR_FIXED;
+				break;
+
+			case 0x06:
+				fcp->structure = UTIL_SIM_FILE_CYCLIC;
+				break;
+
+			default:
+				break;
+			}
+
+			// Record EFs carry data coding, record length (2) and record count
+			if (len >= 5) {
+				fcp->record_len = _util_hex_uint(buf, offset + 2, 2);
+				fcp->record_count = _util_hex_byte(buf, offset + 4);
+			}
+			descriptor = TRUE;
+			break;
+
+		case 0x83:
+			if (len == 2)
+				fcp->file_id = _util_hex_uint(buf, offset, 2);
+			break;
+
+		case 0x80:
+			if (len >= 1 && len <= 4)
+				fcp->file_size = _util_hex_uint(buf, offset, len);
+			break;
+
+		default:
+			break;
+		}
+
+		offset += len;
+	}
+
+	return descriptor;
+}
+
+/* GSM 11.11 9.2.1, fixed layout response to SELECT of an EF */
+static gboolean _util_sim_fcp_decode_gsm(const struct util_hex_buf *buf, struct util_sim_fcp *fcp)
+{
+	if (buf->len < 15)
+		return FALSE;
+
+	fcp->file_size = _util_hex_uint(buf, 2, 2);
+	fcp->file_id = _util_hex_uint(buf, 4, 2);
+
+	// Type of file, only EFs have a structure
+	if (_util_hex_byte(buf, 6) != 0x04)
+		return TRUE;
+
+	switch (_util_hex_byte(buf, 13)) {
+	case 0x00:
+		fcp->structure = UTIL_SIM_FILE_TRANSPARENT;
+		break;
+
+	case 0x01:
+		fcp->structure = UTIL_SIM_FILE_LINEAR_FIXED;
+		break;
+
+	default:
+		fcp->structure = UTIL_SIM_FILE_CYCLIC;
+		break;
+	}
+
+	fcp->record_len = _util_hex_byte(buf, 14);
+	if (fcp->record_len > 0)
+		fcp->record_count = fcp->file_size / fcp->record_len;
+
+	return TRUE;
+}
+
+/*
+ * Decodes the response data of a GET RESPONSE, given as the (optionally
+ * quoted) hex string of the +CRSM line, without converting it to a buffer
+ * first. Every access is bounds checked, FALSE on a malformed response.
+ */
+gboolean util_sim_fcp_decode(const char *hex, gboolean usim, struct util_sim_fcp *fcp)
+{
+	struct util_hex_buf buf;
+	int len = 0;
+	gboolean ret;
+
+	if (!hex || !fcp)
+		return FALSE;
+
+	memset(fcp, 0x00, sizeof(struct util_sim_fcp));
+
+	if (*hex == '"')
+		hex++;
+	while (hex[len] && hex[len] != '"')
+		len++;
+
+	buf.hex = hex;
+	buf.len = len / 2;
+
+	if (usim)
+		ret = _util_sim_fcp_decode_usim(&buf, fcp);
+	else
+		ret = _util_sim_fcp_decode_gsm(&buf, fcp);
+
+	if (ret == FALSE || fcp->file_size < 0 || fcp->record_len < 0 || fcp->record_count < 0) {
+		dbg("Invalid FCP [%s]", hex);
+		return FALSE;
+	}
+
+	dbg("FCP ef[0x%x] structure[%d] size[%d] record len[%d] count[%d]", fcp->file_id,
+		fcp->structure, fcp->file_size, fcp->record_len, fcp->record_count);
+	return TRUE;
+}
@@ -213,7 +213,6 @@ static void on_response_set_flight_mode(TcorePending *p, int data_len, const voi
 	GSList *tokens = NULL;
 	const char *line = NULL;
 	struct tresp_modem_set_flightmode res = {0};
-	int response = 0;
 	struct tnoti_modem_flight_mode modem_flight_mode = {0};
 	const struct treq_modem_set_flightmode *req_data = NULL;
 
@@ -231,9 +230,7 @@ static void on_response_set_flight_mode(TcorePending *p, int data_len, const voi
 			dbg("err cause not specified or string corrupted");
 			res.result = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			response = atoi(g_slist_nth_data(tokens, 0));
-			/* TODO: CMEE error mapping is required. */
-			res.result = TCORE_RETURN_3GPP_ERROR;
+			res.result = util_at_error_result(line);
 		}
 	}
 
@@ -273,7 +270,6 @@ static void on_response_imei(TcorePending *p, int data_len, const void *data, vo
 	UserRequest *ur = NULL;
 	GSList *tokens = NULL;
 	const char *line;
-	int response = 0;
 
 	memset(&res, 0, sizeof(struct tresp_modem_get_imei));
 
@@ -301,20 +297,7 @@ static void on_response_imei(TcorePending *p, int data_len, const void *data, vo
 		}
 	} else {
 		dbg("RESPONSE NOK");
-		if (resp->lines) {
-			line = (const char *) resp->lines->data;
-			tokens = tcore_at_tok_new(line);
-		}
-
-
-		if (g_slist_length(tokens) < 1) {
-			dbg("err cause not specified or string corrupted");
-			res.result = TCORE_RETURN_3GPP_ERROR;
-		} else {
-			response = atoi(g_slist_nth_data(tokens, 0));
-			/* TODO: CMEE error mapping is required. */
-			res.result = TCORE_RETURN_3GPP_ERROR;
-		}
+		res.result = util_at_error_result(resp->final_response);
 	}
 
 	ur = tcore_pending_ref_user_request(p);
@@ -343,8 +326,6 @@ static void on_response_version(TcorePending *p, int data_len, const void *data,
 	char *pcode = NULL;
 	char *id = NULL;
 
-	int response = 0;
-
 	if (resp->success > 0) {
 		dbg("RESPONSE OK");
 		if (resp->lines) {
@@ -389,22 +370,8 @@ static void on_response_version(TcorePending *p, int data_len, const void *data,
 		free(vi);
 	} else {
 		dbg("RESPONSE NOK");
-		if (resp->lines) {
-			line = (const char *) resp->lines->data;
-			tokens = tcore_at_tok_new(line);
-		}
-
 		memset(&res, 0, sizeof(struct tresp_modem_get_version));
-
-
-		if (g_slist_length(tokens) < 1) {
-			dbg("err cause not specified or string corrupted");
-			res.result = TCORE_RETURN_3GPP_ERROR;
-		} else {
-			response = atoi(g_slist_nth_data(tokens, 0));
-			/* TODO: CMEE error mapping is required. */
-			res.result = TCORE_RETURN_3GPP_ERROR;
-		}
+		res.result = util_at_error_result(resp->final_response);
 	}
 
 	ur = tcore_pending_ref_user_request(p);
@@ -34,6 +34,7 @@
 
 #include "s_common.h"
 #include "s_sat.h"
+#include "s_sim.h"
 #define ENVELOPE_CMD_LEN        256
 
 static TReturn s_terminal_response(CoreObject *o, UserRequest *ur);
@@ -69,6 +70,7 @@ static gboolean on_event_sat_proactive_command(CoreObject *o, const void *event_
 	char *hexData = NULL;
 	char *tmp = NULL;
 	char *recordData = NULL;
+	CoreObject *co_sim = NULL;
 
 	dbg("Function Entry");
 
@@ -221,6 +223,12 @@ static gboolean on_event_sat_proactive_command(CoreObject *o, const void *event_
 		dbg("wrong input");
 		break;
 	}
+	if (decoded_data.cmd_type == SAT_PROATV_CMD_REFRESH) {
+		// The modem performs the refresh itself, cached EF contents are stale now
+		co_sim = tcore_plugin_ref_core_object(tcore_object_ref_plugin(o), "sim");
+		if (co_sim)
+			s_sim_ef_cache_invalidate(co_sim);
+	}
 	if ((decoded_data.cmd_type == SAT_PROATV_CMD_REFRESH) || (decoded_data.cmd_type == SAT_PROATV_CMD_SETUP_EVENT_LIST)) {
 		/*Not supported*/
 		dbg("Not suported Proactive command");
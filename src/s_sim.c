@@ -21,6 +21,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <glib.h>
 #include <tcore.h>
 #include <hal.h>
@@ -38,13 +41,35 @@
 
 #define ID_RESERVED_AT 0x0229
 
-#define SWAPBYTES16(x) \
-	{ \
-		unsigned short int data = *(unsigned short int *) &(x);	\
-		data = ((data & 0xff00) >> 8) |	   \
-			   ((data & 0x00ff) << 8);	   \
-		*(unsigned short int *) &(x) = data;	  \
-	}
+#define SIM_EF_CACHE_PATH "/opt/dbspace/.sim_ef_cache.dat"
+#define SIM_EF_CACHE_MAGIC "SIMEF1"
+#define SIM_EF_CACHE_FLUSH_DELAY 3 /* seconds */
+
+#define SIM_IDENTITY_PATH "/opt/dbspace/.sim_identity.dat"
+#define SIM_IDENTITY_MAGIC "SIMID1"
+#define SIM_IDENTITY_IMSI_LEN 15
+
+#define SIM_UPDATE_COALESCE_DELAY 500 /* ms an update waits for a newer one of the same EF */
+
+#define SIM_STATS_LOG_INTERVAL 600 /* seconds between access counter summaries */
+#define SIM_STATS_APDU 0 /* counter bucket of s_transmit_apdu traffic, which has no EF */
+
+#define SIM_RECORD_READ_WINDOW 4 /* READ RECORDs queued at once */
+#define SIM_RECORD_EMPTY_RUN_MAX 4 /* consecutive empty records ending a read */
+
+#define SIM_PREFETCH_WINDOW 2 /* prefetch reads in flight once INIT_COMPLETED is out */
+
+/* AT+XPINCNT lock types, slot 0 holds the PS lock which has none */
+#define SIM_LOCK_SLOT_PIN1 1
+#define SIM_LOCK_SLOT_PIN2 2
+#define SIM_LOCK_SLOT_PUK1 3
+#define SIM_LOCK_SLOT_PUK2 4
+#define SIM_LOCK_SLOT_MAX 10
+
+#define SIM_APDU_CHANNEL_MAX 20 /* basic channel and 19 logical channels, TS 102 221 */
+#define SIM_MSISDN_SLOT_CNT(meta) ((int) G_N_ELEMENTS((meta)->files.data.msisdn_list.msisdn))
+#define SIM_APDU_INS_MANAGE_CHANNEL 0x70
+#define SIM_APDU_INS_SELECT 0xA4
 
 enum s_sim_file_type_e {
 	SIM_FTYPE_DEDICATED = 0x00, /**< Dedicated */
@@ -90,6 +115,11 @@ enum s_sim_sec_op_e {
 	SEC_SIM_UNKNOWN = 0xff
 };
 
+struct s_sim_lock {
+	int retry_count; /**< attempts left, -1 until reported */
+	int lock_status; /**< +XLOCK <lock status>, -1 until reported */
+};
+
 struct s_sim_property {
 	gboolean b_valid; /**< Valid or not */
 	enum tel_sim_file_id file_id; /**< File identifier */
@@ -98,11 +128,115 @@ struct s_sim_property {
 	int rec_count; /**< Number of records in file */
 	int data_size; /**< File size */
 	int current_index; /**< current index to read */
+	int request_index; /**< last record requested, runs ahead of current_index */
+	int empty_run; /**< consecutive empty records received */
+	gboolean window_cached; /**< records in flight are cache replays */
+	gint64 read_start; /**< first READ RECORD, monotonic us */
 	enum tel_sim_status first_recv_status;
 	enum s_sim_sec_op_e current_sec_op; /**< current index to read */
+	struct s_sim_lock locks[SIM_LOCK_SLOT_MAX]; /**< by AT+XPINCNT lock type */
+	gboolean identity_loaded; /**< identity record read from SIM_IDENTITY_PATH */
+	guint32 identity_iccid; /**< ICCID hash of the last card seen */
+	char identity_imsi[SIM_IDENTITY_IMSI_LEN + 1]; /**< IMSI of that card, empty until read */
+	int identity_same; /**< ICCID matches the record, -1 until compared or without a record */
+	gboolean identity_current; /**< identity_iccid is the ICCID of the card inserted */
 	struct tresp_sim_read files;
 };
 
+/* Card access counters of one EF */
+struct s_sim_ef_stats {
+	int ef;
+	unsigned int requests; /**< reads, updates or APDUs asked for */
+	unsigned int round_trips; /**< AT commands sent to the modem */
+	unsigned int cache_hits; /**< answers from the EF cache or FCP table */
+	unsigned int bytes; /**< file or APDU data read and written */
+	int inflight; /**< round trips not answered yet */
+	gint64 busy_since; /**< monotonic us, first of the round trips in flight */
+	gint64 busy_us; /**< time with a round trip of the EF outstanding */
+	gint64 max_us; /**< longest such stretch */
+};
+
+struct s_sim_stats {
+	GHashTable *ef; /**< file id -> struct s_sim_ef_stats */
+	guint log_id; /**< periodic summary */
+	gboolean dirty; /**< counters moved since the last summary */
+};
+
+/* AT+CRSM answers of the static EFs of the current card, persisted per ICCID */
+struct s_sim_ef_cache {
+	char iccid[SIM_ICCID_LEN_MAX + 1]; /**< Card the entries belong to, empty until read */
+	GHashTable *entries; /**< AT+CRSM command -> +CRSM response line */
+	GHashTable *fcp; /**< file id -> struct s_sim_fcp */
+	guint flush_id; /**< Pending disk write */
+	int prefetch_next; /**< next sim_prefetch_plan entry to issue */
+	int prefetch_inflight; /**< prefetch reads not answered yet */
+	GHashTable *updates; /**< "cmd,ef,p1,p2" -> struct s_sim_update not sent yet */
+};
+
+/* An AT+CRSM UPDATE, standing in for every request it superseded */
+struct s_sim_update {
+	CoreObject *o;
+	char *key; /**< in s_sim_ef_cache.updates while waiting */
+	enum tel_sim_file_id ef;
+	int cmd;
+	int p1;
+	int p2;
+	int p3;
+	char *data; /**< hex */
+	GSList *requests; /**< UserRequests answered by this write, oldest first */
+	guint timer_id;
+};
+
+/* APDU traffic of one channel, logical channels map onto +CCHO sessions */
+struct s_sim_apdu_channel {
+	gboolean opened; /**< Handed out by MANAGE CHANNEL, always set for the basic channel */
+	int session_id; /**< +CCHO session, -1 until an applet is selected */
+	gboolean busy; /**< An APDU of the channel is with the modem */
+	GQueue *queue; /**< UserRequests waiting for the channel, in order */
+	int apdu_count; /**< APDUs answered since the channel was opened */
+	gint64 open_time; /**< monotonic us */
+};
+
+struct s_sim_apdu {
+	struct s_sim_apdu_channel channel[SIM_APDU_CHANNEL_MAX];
+};
+
+/* GET RESPONSE outcome of an EF, fixed for a given card */
+struct s_sim_fcp {
+	enum s_sim_file_type_e file_type;
+	int rec_length;
+	int rec_count;
+	int data_size;
+};
+
+struct s_sim_ef_cache_replay {
+	CoreObject *o;
+	UserRequest *ur;
+	char *line;
+	void (*process)(CoreObject *o, UserRequest *ur, const TcoreATResponse *resp);
+};
+
+/* GET RESPONSE answered from the FCP cache, run from the main loop */
+struct s_sim_fcp_replay {
+	CoreObject *o;
+	UserRequest *ur;
+	enum tel_sim_file_id ef;
+};
+
+static const struct {
+	const char *name;
+	enum tel_sim_facility_type type;
+	int slot;
+} sim_lock_facility[] = {
+	{ "PS", SIM_FACILITY_PS, 0 },
+	{ "SC", SIM_FACILITY_SC, SIM_LOCK_SLOT_PIN1 },
+	{ "FD", SIM_FACILITY_FD, SIM_LOCK_SLOT_PIN2 },
+	{ "PN", SIM_FACILITY_PN, 5 },
+	{ "PU", SIM_FACILITY_PU, 6 },
+	{ "PP", SIM_FACILITY_PP, 7 },
+	{ "PC", SIM_FACILITY_PC, 8 },
+};
+
 static void _next_from_get_file_info(CoreObject *o, UserRequest *ur, enum tel_sim_file_id ef, enum tel_sim_access_result rt);
 static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_sim_access_result rt, int decode_ret);
 static gboolean _get_sim_type(CoreObject *o);
@@ -110,6 +244,17 @@ static TReturn _get_file_info(CoreObject *o, UserRequest *ur, const enum tel_sim
 static gboolean _get_file_data(CoreObject *o, UserRequest *ur, const enum tel_sim_file_id ef, const int offset, const int length);
 static gboolean _get_file_record(CoreObject *o, UserRequest *ur, const enum tel_sim_file_id ef, const int index, const int length);
 static void _sim_status_update(CoreObject *o, enum tel_sim_status sim_status);
+static void _sim_file_info_process(CoreObject *co_sim, UserRequest *ur, const TcoreATResponse *resp);
+static void _sim_file_data_process(CoreObject *co_sim, UserRequest *ur, const TcoreATResponse *resp);
+static void _sim_read_records(CoreObject *o, UserRequest *ur, struct s_sim_property *file_meta);
+static void _sim_prefetch_next(CoreObject *o);
+static void _sim_apdu_reset(CoreObject *o);
+static void _sim_ef_cache_invalidate(CoreObject *o, enum tel_sim_file_id ef);
+static void _sim_ecc_cache_clear(CoreObject *o);
+static gboolean _sim_file_write_private(const char *path, const char *data, gsize len);
+static void _sim_apdu_channel_next(CoreObject *o, int ch);
+static void _sim_update_flush_ef(CoreObject *o, enum tel_sim_file_id ef);
+static void _sim_update_drop(CoreObject *o);
 static void on_confirmation_sim_message_send(TcorePending *p, gboolean result, void *user_data);  // from Kernel
 extern gboolean util_byte_to_hex(const char *byte_pdu, char *hex_pdu, int num_bytes);
 
@@ -125,6 +270,173 @@ static void on_confirmation_sim_message_send(TcorePending *p, gboolean result, v
 	}
 }
 
+static struct s_sim_ef_stats *_sim_stats_ef(CoreObject *o, int ef)
+{
+	struct s_sim_stats *stats = tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMSTATS");
+	struct s_sim_ef_stats *ef_stats = NULL;
+
+	if (!stats)
+		return NULL;
+
+	ef_stats = g_hash_table_lookup(stats->ef, GINT_TO_POINTER(ef));
+	if (!ef_stats) {
+		ef_stats = calloc(sizeof(struct s_sim_ef_stats), 1);
+		if (!ef_stats)
+			return NULL;
+		ef_stats->ef = ef;
+		g_hash_table_insert(stats->ef, GINT_TO_POINTER(ef), ef_stats);
+	}
+
+	stats->dirty = TRUE;
+	return ef_stats;
+}
+
+/* EF an AT+CRSM command addresses */
+static int _sim_stats_cmd_ef(const char *cmd)
+{
+	int ef = SIM_EF_INVALID;
+
+	if (cmd)
+		sscanf(cmd, "AT+CRSM=%*d, %d", &ef);
+	return ef;
+}
+
+/* Data bytes of a +CRSM: <sw1>,<sw2>,<response> line */
+static int _sim_stats_line_bytes(const char *line)
+{
+	const char *pos = NULL;
+	int digits = 0;
+
+	if (!line)
+		return 0;
+
+	pos = strchr(line, ',');
+	if (pos)
+		pos = strchr(pos + 1, ',');
+	if (!pos)
+		return 0;
+
+	for (pos++; *pos; pos++) {
+		if (g_ascii_isxdigit(*pos))
+			digits++;
+	}
+	return digits / 2;
+}
+
+static void _sim_stats_request(CoreObject *o, int ef, int bytes)
+{
+	struct s_sim_ef_stats *ef_stats = _sim_stats_ef(o, ef);
+
+	if (!ef_stats)
+		return;
+
+	ef_stats->requests++;
+	ef_stats->bytes += bytes;
+}
+
+static void _sim_stats_cache_hit(CoreObject *o, int ef)
+{
+	struct s_sim_ef_stats *ef_stats = _sim_stats_ef(o, ef);
+
+	if (ef_stats)
+		ef_stats->cache_hits++;
+}
+
+static void _sim_stats_sent(CoreObject *o, int ef)
+{
+	struct s_sim_ef_stats *ef_stats = _sim_stats_ef(o, ef);
+
+	if (!ef_stats)
+		return;
+
+	ef_stats->round_trips++;
+	if (ef_stats->inflight++ == 0)
+		ef_stats->busy_since = g_get_monotonic_time();
+}
+
+/*
+ * Busy time runs while any round trip of the EF is outstanding, so the
+ * READ RECORD window and parallel APDU channels are not counted twice.
+ */
+static void _sim_stats_received(CoreObject *o, int ef, int bytes)
+{
+	struct s_sim_ef_stats *ef_stats = _sim_stats_ef(o, ef);
+	gint64 elapsed;
+
+	if (!ef_stats)
+		return;
+
+	ef_stats->bytes += bytes;
+	if (ef_stats->inflight <= 0)
+		return;
+
+	if (--ef_stats->inflight == 0) {
+		elapsed = g_get_monotonic_time() - ef_stats->busy_since;
+		ef_stats->busy_us += elapsed;
+		if (elapsed > ef_stats->max_us)
+			ef_stats->max_us = elapsed;
+	}
+}
+
+static gint _sim_stats_compare(gconstpointer a, gconstpointer b)
+{
+	const struct s_sim_ef_stats *sa = a;
+	const struct s_sim_ef_stats *sb = b;
+
+	if (sa->busy_us == sb->busy_us)
+		return sa->ef - sb->ef;
+	return sa->busy_us < sb->busy_us ? 1 : -1;
+}
+
+/* Access counters of every EF touched so far, busiest first. Free with g_free(). */
+static char *_sim_stats_dump(CoreObject *o)
+{
+	struct s_sim_stats *stats = NULL;
+	struct s_sim_ef_stats *ef_stats = NULL;
+	GString *buf = NULL;
+	GList *list = NULL;
+	GList *l = NULL;
+
+	if (!o)
+		return NULL;
+
+	stats = tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMSTATS");
+	if (!stats)
+		return NULL;
+
+	buf = g_string_new("EF       requests round_trips cache_hits bytes busy_ms max_ms\n");
+	list = g_list_sort(g_hash_table_get_values(stats->ef), _sim_stats_compare);
+	for (l = list; l; l = l->next) {
+		ef_stats = l->data;
+		if (ef_stats->ef == SIM_STATS_APDU)
+			g_string_append_printf(buf, "%-8s", "APDU");
+		else
+			g_string_append_printf(buf, "0x%04x  ", ef_stats->ef);
+		g_string_append_printf(buf, " %8u %11u %10u %5u %7d %6d\n", ef_stats->requests, ef_stats->round_trips,
+							   ef_stats->cache_hits, ef_stats->bytes, (int) (ef_stats->busy_us / 1000),
+							   (int) (ef_stats->max_us / 1000));
+	}
+	g_list_free(list);
+
+	return g_string_free(buf, FALSE);
+}
+
+static gboolean _sim_stats_on_log(gpointer user_data)
+{
+	CoreObject *o = user_data;
+	struct s_sim_stats *stats = tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMSTATS");
+	char *summary = NULL;
+
+	if (!stats || !stats->dirty)
+		return TRUE;
+
+	stats->dirty = FALSE;
+	summary = _sim_stats_dump(o);
+	dbg("SIM access counters\n%s", summary);
+	g_free(summary);
+	return TRUE;
+}
+
 static enum tcore_response_command _find_resp_command(UserRequest *ur)
 {
 	enum tcore_request_command command;
@@ -323,6 +635,153 @@ static int _sim_get_current_pin_facility(enum s_sim_sec_op_e op)
 	return ret_type;
 }
 
+/* AT+XPINCNT lock type of a security operation, also its slot in s_sim_property.locks */
+static int _sim_lock_slot(enum s_sim_sec_op_e op)
+{
+	int lock_type = 0;
+
+	switch (op) {
+	case SEC_PIN1_VERIFY:
+	case SEC_PIN1_CHANGE:
+	case SEC_PIN1_ENABLE:
+	case SEC_PIN1_DISABLE:
+		lock_type = 1;
+		break;
+
+	case SEC_PIN2_VERIFY:
+	case SEC_PIN2_CHANGE:
+	case SEC_PIN2_ENABLE:
+	case SEC_PIN2_DISABLE:
+	case SEC_FDN_ENABLE:
+	case SEC_FDN_DISABLE:
+		lock_type = 2;
+		break;
+
+	case SEC_PUK1_VERIFY:
+		lock_type = 3;
+		break;
+
+	case SEC_PUK2_VERIFY:
+		lock_type = 4;
+		break;
+
+	case SEC_NET_ENABLE:
+	case SEC_NET_DISABLE:
+		lock_type = 5;
+		break;
+
+	case SEC_NS_ENABLE:
+	case SEC_NS_DISABLE:
+		lock_type = 6;
+		break;
+
+	case SEC_SP_ENABLE:
+	case SEC_SP_DISABLE:
+		lock_type = 7;
+		break;
+
+	case SEC_CP_ENABLE:
+	case SEC_CP_DISABLE:
+		lock_type = 8;
+		break;
+
+	case SEC_ADM_VERIFY:
+		lock_type = 9;
+		break;
+
+	default:
+		break;
+	}
+
+	return lock_type;
+}
+
+static int _sim_lock_slot_by_facility(enum tel_sim_facility_type type)
+{
+	unsigned int i;
+
+	for (i = 0; i < G_N_ELEMENTS(sim_lock_facility); i++) {
+		if (sim_lock_facility[i].type == type)
+			return sim_lock_facility[i].slot;
+	}
+	return -1;
+}
+
+static void _sim_lock_reset(struct s_sim_property *sp)
+{
+	int i;
+
+	for (i = 0; i < SIM_LOCK_SLOT_MAX; i++) {
+		sp->locks[i].retry_count = -1;
+		sp->locks[i].lock_status = -1;
+	}
+}
+
+/*
+ * A successful verify, change or facility operation makes the card reset
+ * the counters involved to their maximum, which it does not report.
+ */
+static void _sim_lock_forget(struct s_sim_property *sp, enum s_sim_sec_op_e op)
+{
+	int slot = _sim_lock_slot(op);
+
+	sp->locks[slot].retry_count = -1;
+
+	if (slot == SIM_LOCK_SLOT_PUK1)
+		sp->locks[SIM_LOCK_SLOT_PIN1].retry_count = -1;
+	else if (slot == SIM_LOCK_SLOT_PUK2)
+		sp->locks[SIM_LOCK_SLOT_PIN2].retry_count = -1;
+}
+
+/* Lock info of a facility from the cached counters, FALSE while they are unknown */
+static gboolean _sim_lock_info_build(CoreObject *o, enum tel_sim_facility_type type, struct tresp_sim_get_lock_info *resp)
+{
+	struct s_sim_property *sp = tcore_sim_ref_userdata(o);
+	int slot = _sim_lock_slot_by_facility(type);
+
+	memset(resp, 0x00, sizeof(struct tresp_sim_get_lock_info));
+	resp->result = SIM_ACCESS_SUCCESS;
+	resp->type = type;
+	resp->lock_status = SIM_LOCK_STATUS_UNLOCKED;
+	resp->retry_count = -1;
+
+	if (!sp || slot < 0)
+		return FALSE;
+
+	switch (type) {
+	case SIM_FACILITY_SC:
+		if (sp->locks[SIM_LOCK_SLOT_PIN1].retry_count == 0) {
+			resp->retry_count = sp->locks[SIM_LOCK_SLOT_PUK1].retry_count;
+			resp->lock_status = resp->retry_count == 0 ? SIM_LOCK_STATUS_PERM_BLOCKED : SIM_LOCK_STATUS_PUK;
+		} else {
+			resp->retry_count = sp->locks[SIM_LOCK_SLOT_PIN1].retry_count;
+			if (tcore_sim_get_status(o) == SIM_STATUS_PIN_REQUIRED)
+				resp->lock_status = SIM_LOCK_STATUS_PIN;
+		}
+		break;
+
+	case SIM_FACILITY_FD:
+		if (sp->locks[SIM_LOCK_SLOT_PIN2].retry_count == 0) {
+			resp->retry_count = sp->locks[SIM_LOCK_SLOT_PUK2].retry_count;
+			resp->lock_status = resp->retry_count == 0 ? SIM_LOCK_STATUS_PERM_BLOCKED : SIM_LOCK_STATUS_PUK2;
+		} else {
+			resp->retry_count = sp->locks[SIM_LOCK_SLOT_PIN2].retry_count;
+		}
+		break;
+
+	default:
+		// +XLOCK <lock status>: 0 unlocked, 1 control key required, 2 blocked
+		resp->retry_count = sp->locks[slot].retry_count;
+		if (sp->locks[slot].lock_status == 1)
+			resp->lock_status = SIM_LOCK_STATUS_PIN;
+		else if (sp->locks[slot].lock_status == 2)
+			resp->lock_status = SIM_LOCK_STATUS_PERM_BLOCKED;
+		break;
+	}
+
+	return resp->retry_count >= 0;
+}
+
 static enum tel_sim_access_result _decode_status_word(unsigned short status_word1, unsigned short status_word2)
 {
 	enum tel_sim_access_result rst = SIM_ACCESS_FAILED;
@@ -410,12 +869,111 @@ static enum tel_sim_access_result _decode_status_word(unsigned short status_word
 	return rst;
 }
 
+/* FNV-1a, the record only needs to tell cards apart */
+static guint32 _sim_identity_hash(const char *iccid)
+{
+	guint32 hash = 2166136261U;
+
+	while (*iccid) {
+		hash ^= (unsigned char) *iccid++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static void _sim_identity_load(struct s_sim_property *sp)
+{
+	gchar *contents = NULL;
+	unsigned int hash = 0;
+	char imsi[SIM_IDENTITY_IMSI_LEN + 1] = {0, };
+
+	if (sp->identity_loaded)
+		return;
+	sp->identity_loaded = TRUE;
+
+	if (g_file_get_contents(SIM_IDENTITY_PATH, &contents, NULL, NULL) == FALSE)
+		return;
+
+	if (sscanf(contents, SIM_IDENTITY_MAGIC " %8x %15s", &hash, imsi) >= 1) {
+		sp->identity_iccid = hash;
+		g_strlcpy(sp->identity_imsi, imsi, sizeof(sp->identity_imsi));
+	} else {
+		err("identity record corrupted");
+	}
+	g_free(contents);
+}
+
+static void _sim_identity_save(struct s_sim_property *sp)
+{
+	gchar *contents = NULL;
+
+	// Holds the IMSI, kept as private as the vconf key it stands in for
+	contents = g_strdup_printf(SIM_IDENTITY_MAGIC "\n%08x\n%s\n", sp->identity_iccid, sp->identity_imsi);
+	if (_sim_file_write_private(SIM_IDENTITY_PATH, contents, strlen(contents)) == FALSE)
+		err("identity record not written");
+	g_free(contents);
+}
+
+/*
+ * Decides new versus same card from the ICCID, read ahead of the IMSI at
+ * init. A new card takes every cache derived from the previous one along.
+ */
+static void _sim_identity_check_iccid(CoreObject *o, const char *iccid)
+{
+	struct s_sim_property *sp = tcore_sim_ref_userdata(o);
+	guint32 hash;
+
+	if (!sp || !iccid || iccid[0] == '\0')
+		return;
+
+	_sim_identity_load(sp);
+	hash = _sim_identity_hash(iccid);
+	sp->identity_current = TRUE;
+
+	// No record, or this card's IMSI never made it there: the stored IMSI decides
+	if (sp->identity_iccid == 0 || (sp->identity_iccid == hash && sp->identity_imsi[0] == '\0')) {
+		dbg("no identity record for the card");
+		sp->identity_same = -1;
+		sp->identity_iccid = hash;
+		sp->identity_imsi[0] = '\0';
+		_sim_identity_save(sp);
+		return;
+	}
+
+	if (sp->identity_iccid == hash) {
+		dbg("SAME SIM");
+		sp->identity_same = TRUE;
+		tcore_sim_set_identification(o, FALSE);
+		return;
+	}
+
+	dbg("NEW SIM");
+	sp->identity_same = FALSE;
+	tcore_sim_set_identification(o, TRUE);
+	_sim_ef_cache_invalidate(o, SIM_EF_INVALID);
+	_sim_lock_reset(sp);
+
+	sp->identity_iccid = hash;
+	sp->identity_imsi[0] = '\0';
+	_sim_identity_save(sp);
+}
+
 static gboolean _sim_check_identity(CoreObject *o, struct tel_sim_imsi *imsi)
 {
 	Server *s = NULL;
 	Storage *strg = NULL;
+	struct s_sim_property *sp = NULL;
 	char *old_imsi = NULL;
-	char new_imsi[15 + 1] = {0, };
+	char new_imsi[SIM_IDENTITY_IMSI_LEN + 1] = {0, };
+
+	sp = tcore_sim_ref_userdata(o);
+	snprintf(new_imsi, sizeof(new_imsi), "%s%s", imsi->plmn, imsi->msin);
+
+	// Card already recognised by its ICCID, no storage round trip
+	if (sp->identity_same == TRUE && strcmp(sp->identity_imsi, new_imsi) == 0) {
+		dbg("SAME SIM, newImsi[%s]", new_imsi);
+		return TRUE;
+	}
 
 	s = tcore_plugin_ref_server(tcore_object_ref_plugin(o));
 	if (!s) {
@@ -427,16 +985,16 @@ static gboolean _sim_check_identity(CoreObject *o, struct tel_sim_imsi *imsi)
 		dbg("there is no valid storage plugin");
 		return FALSE;
 	}
-	memcpy(&new_imsi, imsi->plmn, strlen(imsi->plmn));
-	memcpy(&new_imsi[strlen(imsi->plmn)], imsi->msin, strlen(imsi->msin));
-	new_imsi[strlen(imsi->plmn) + strlen(imsi->msin)] = '\0';
 
-	old_imsi = tcore_storage_get_string(strg, STORAGE_KEY_TELEPHONY_IMSI);
+	// A new ICCID makes the stored IMSI irrelevant
+	if (sp->identity_same != FALSE)
+		old_imsi = tcore_storage_get_string(strg, STORAGE_KEY_TELEPHONY_IMSI);
 	dbg("old_imsi[%s],newImsi[%s]", old_imsi, new_imsi);
 
 	if (old_imsi != NULL) {
 		if (strncmp(old_imsi, new_imsi, 15) != 0) {
 			dbg("NEW SIM");
+			_sim_ecc_cache_clear(o);
 			if (tcore_storage_set_string(strg, STORAGE_KEY_TELEPHONY_IMSI, (const char *) &new_imsi) == FALSE) {
 				dbg("[FAIL] UPDATE STORAGE_KEY_TELEPHONY_IMSI");
 			}
@@ -445,6 +1003,7 @@ static gboolean _sim_check_identity(CoreObject *o, struct tel_sim_imsi *imsi)
 			dbg("SAME SIM");
 			tcore_sim_set_identification(o, FALSE);
 		}
+		free(old_imsi);
 	} else {
 		dbg("OLD SIM VALUE IS NULL. NEW SIM");
 		if (tcore_storage_set_string(strg, STORAGE_KEY_TELEPHONY_IMSI, (const char *) &new_imsi) == FALSE) {
@@ -452,6 +1011,17 @@ static gboolean _sim_check_identity(CoreObject *o, struct tel_sim_imsi *imsi)
 		}
 		tcore_sim_set_identification(o, TRUE);
 	}
+
+	// Same ICCID, different IMSI: the files behind it may differ as well
+	if (sp->identity_same == TRUE) {
+		dbg("IMSI changed on the same card");
+		_sim_ef_cache_invalidate(o, SIM_EF_INVALID);
+	}
+
+	if (sp->identity_current) {
+		g_strlcpy(sp->identity_imsi, new_imsi, sizeof(sp->identity_imsi));
+		_sim_identity_save(sp);
+	}
 	return 1;
 }
 
@@ -538,8 +1108,7 @@ static void _next_from_get_file_info(CoreObject *o, UserRequest *ur, enum tel_si
 				file_meta->rec_count = SIM_ECC_RECORD_CNT_MAX;
 			}
 
-			file_meta->current_index++;
-			_get_file_record(o, ur, ef, file_meta->current_index, file_meta->rec_length);
+			_sim_read_records(o, ur, file_meta);
 		}
 		break;
 
@@ -587,8 +1156,14 @@ static void _next_from_get_file_info(CoreObject *o, UserRequest *ur, enum tel_si
 		if (file_meta->rec_count > SIM_CF_RECORD_CNT_MAX) {
 			file_meta->rec_count = SIM_CF_RECORD_CNT_MAX;
 		}
-		file_meta->current_index++;
-		_get_file_record(o, ur, ef, file_meta->current_index, file_meta->rec_length);
+		_sim_read_records(o, ur, file_meta);
+		break;
+
+	case SIM_EF_MSISDN:
+		if (file_meta->rec_count > SIM_MSISDN_SLOT_CNT(file_meta)) {
+			file_meta->rec_count = SIM_MSISDN_SLOT_CNT(file_meta);
+		}
+		_sim_read_records(o, ur, file_meta);
 		break;
 
 	case SIM_EF_OPL:
@@ -598,8 +1173,7 @@ static void _next_from_get_file_info(CoreObject *o, UserRequest *ur, enum tel_si
 	case SIM_EF_MBDN:
 	case SIM_EF_CPHS_MAILBOX_NUMBERS:
 	case SIM_EF_CPHS_INFORMATION_NUMBERS:
-		file_meta->current_index++;
-		_get_file_record(o, ur, ef, file_meta->current_index, file_meta->rec_length);
+		_sim_read_records(o, ur, file_meta);
 		break;
 
 	default:
@@ -609,17 +1183,580 @@ static void _next_from_get_file_info(CoreObject *o, UserRequest *ur, enum tel_si
 	return;
 }
 
-static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_sim_access_result rt, int decode_ret)
+// Keeps the last EF-ECC read for the call module, see _call_is_emergency()
+static void _sim_ecc_cache_store(CoreObject *o, const struct tel_sim_ecc_list *ecc)
 {
-	struct s_sim_property *file_meta = NULL;
+	struct tel_sim_ecc_list *cache = NULL;
 
-	dbg("Entry");
+	cache = tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMECC");
+	if (!cache)
+		return;
 
-	file_meta = (struct s_sim_property *) tcore_user_request_ref_metainfo(ur, NULL);
-	dbg("[SIM]EF[0x%x] read rt[%d] Decode rt[%d]", file_meta->file_id, rt, decode_ret);
-	switch (file_meta->file_id) {
+	memcpy(cache, ecc, sizeof(struct tel_sim_ecc_list));
+	dbg("[SIM DATA]ECC cached, count[%d]", cache->ecc_count);
+}
+
+// EF-ECC is read again before it is trusted, see _sim_ecc_cache_store()
+static void _sim_ecc_cache_clear(CoreObject *o)
+{
+	struct tel_sim_ecc_list *cache = NULL;
+
+	cache = tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMECC");
+	if (cache)
+		memset(cache, 0x00, sizeof(struct tel_sim_ecc_list));
+}
+
+/* Only EFs whose content changes through SAT REFRESH or s_update_file() alone */
+static gboolean _sim_ef_cache_allowed(enum tel_sim_file_id ef)
+{
+	switch (ef) {
+	case SIM_EF_ECC:
 	case SIM_EF_ELP:
-	case SIM_EF_USIM_PL:
+	case SIM_EF_LP:
+	case SIM_EF_USIM_PL:
+	case SIM_EF_SST:
+	case SIM_EF_SPN:
+	case SIM_EF_SPDI:
+	case SIM_EF_OPL:
+	case SIM_EF_PNN:
+	case SIM_EF_MSISDN:
+	case SIM_EF_OPLMN_ACT:
+	case SIM_EF_MBDN:
+	case SIM_EF_USIM_MBI:
+	case SIM_EF_CPHS_CPHS_INFO:
+	case SIM_EF_CPHS_OPERATOR_NAME_STRING:
+	case SIM_EF_CPHS_OPERATOR_NAME_SHORT_FORM_STRING:
+	case SIM_EF_CPHS_CUSTOMER_SERVICE_PROFILE:
+	case SIM_EF_CPHS_CUSTOMER_SERVICE_PROFILE_LINE2:
+	case SIM_EF_CPHS_MAILBOX_NUMBERS:
+	case SIM_EF_CPHS_INFORMATION_NUMBERS:
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+static struct s_sim_ef_cache *_sim_ef_cache_ref(CoreObject *o)
+{
+	return tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMEFCACHE");
+}
+
+static void _sim_ef_cache_append(gpointer key, gpointer value, gpointer user_data)
+{
+	GString *buf = user_data;
+
+	g_string_append_len(buf, key, strlen(key) + 1);
+	g_string_append_len(buf, value, strlen(value) + 1);
+}
+
+/*
+ * Replaces path with data, readable by the owner only: the files hold card
+ * data. Written aside and renamed, a crash leaves the old file or the new one.
+ */
+static gboolean _sim_file_write_private(const char *path, const char *data, gsize len)
+{
+	gchar *tmp = NULL;
+	gssize done = 0;
+	gsize off = 0;
+	int fd = -1;
+
+	tmp = g_strdup_printf("%s.tmp", path);
+	unlink(tmp);
+
+	fd = open(tmp, O_CREAT | O_EXCL | O_WRONLY | O_TRUNC, 0600);
+	if (fd < 0) {
+		err("%s: %s", tmp, strerror(errno));
+		g_free(tmp);
+		return FALSE;
+	}
+
+	while (off < len) {
+		done = write(fd, data + off, len - off);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			break;
+		off += done;
+	}
+
+	if (close(fd) < 0 || off < len || rename(tmp, path) < 0) {
+		err("%s: %s", path, strerror(errno));
+		unlink(tmp);
+		g_free(tmp);
+		return FALSE;
+	}
+
+	g_free(tmp);
+	return TRUE;
+}
+
+/*
+ * File layout: magic, ICCID, then AT+CRSM command / response line pairs,
+ * every field NUL terminated.
+ */
+static void _sim_ef_cache_write(struct s_sim_ef_cache *cache)
+{
+	GString *buf = NULL;
+
+	if (cache->iccid[0] == '\0')
+		return;
+
+	buf = g_string_new(NULL);
+	g_string_append_len(buf, SIM_EF_CACHE_MAGIC, sizeof(SIM_EF_CACHE_MAGIC));
+	g_string_append_len(buf, cache->iccid, strlen(cache->iccid) + 1);
+	g_hash_table_foreach(cache->entries, _sim_ef_cache_append, buf);
+
+	if (_sim_file_write_private(SIM_EF_CACHE_PATH, buf->str, buf->len) == FALSE) {
+		err("EF cache write failed");
+	} else {
+		dbg("EF cache written, entries[%d] size[%d]", g_hash_table_size(cache->entries), (int) buf->len);
+	}
+
+	g_string_free(buf, TRUE);
+}
+
+static gboolean _sim_ef_cache_flush(gpointer user_data)
+{
+	struct s_sim_ef_cache *cache = user_data;
+
+	cache->flush_id = 0;
+	_sim_ef_cache_write(cache);
+	return FALSE;
+}
+
+// Batches the writes of a read burst (SIM init, PNN/OPL records) into one
+static void _sim_ef_cache_schedule_flush(struct s_sim_ef_cache *cache)
+{
+	if (cache->flush_id)
+		return;
+
+	cache->flush_id = g_timeout_add_seconds(SIM_EF_CACHE_FLUSH_DELAY, _sim_ef_cache_flush, cache);
+}
+
+static void _sim_ef_cache_load(CoreObject *o, const char *iccid)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	gchar *contents = NULL;
+	gsize len = 0;
+	gsize pos = 0;
+	const char *key = NULL;
+	const char *line = NULL;
+
+	if (!cache || !iccid || iccid[0] == '\0')
+		return;
+
+	if (strcmp(cache->iccid, iccid) != 0) {
+		dbg("EF cache belongs to another card, dropped");
+		g_hash_table_remove_all(cache->entries);
+		g_hash_table_remove_all(cache->fcp);
+		g_strlcpy(cache->iccid, iccid, sizeof(cache->iccid));
+	}
+
+	if (g_hash_table_size(cache->entries) > 0)
+		return;
+
+	if (g_file_get_contents(SIM_EF_CACHE_PATH, &contents, &len, NULL) == FALSE)
+		return;
+
+	if (len < sizeof(SIM_EF_CACHE_MAGIC) || contents[len - 1] != '\0'
+		|| memcmp(contents, SIM_EF_CACHE_MAGIC, sizeof(SIM_EF_CACHE_MAGIC)) != 0) {
+		err("EF cache file corrupted");
+		g_free(contents);
+		return;
+	}
+
+	pos = sizeof(SIM_EF_CACHE_MAGIC);
+	if (pos >= len || strcmp(contents + pos, iccid) != 0) {
+		dbg("EF cache file of another card");
+		g_free(contents);
+		return;
+	}
+	pos += strlen(contents + pos) + 1;
+
+	while (pos < len) {
+		key = contents + pos;
+		pos += strlen(key) + 1;
+		if (pos >= len)
+			break;
+
+		line = contents + pos;
+		pos += strlen(line) + 1;
+		g_hash_table_replace(cache->entries, g_strdup(key), g_strdup(line));
+	}
+
+	dbg("EF cache loaded, entries[%d]", g_hash_table_size(cache->entries));
+	g_free(contents);
+}
+
+static void _sim_ef_cache_store(CoreObject *o, const char *cmd, const TcoreATResponse *resp)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	GSList *tokens = NULL;
+	const char *line = NULL;
+	int ef = 0;
+	int sw1 = 0;
+	int sw2 = 0;
+
+	if (!cache || cache->iccid[0] == '\0' || !cmd || resp->success <= 0 || !resp->lines)
+		return;
+
+	if (sscanf(cmd, "AT+CRSM=%*d, %d", &ef) != 1 || !_sim_ef_cache_allowed(ef))
+		return;
+
+	line = (const char *) resp->lines->data;
+	tokens = tcore_at_tok_new(line);
+	if (g_slist_length(tokens) >= 2) {
+		sw1 = atoi(g_slist_nth_data(tokens, 0));
+		sw2 = atoi(g_slist_nth_data(tokens, 1));
+	}
+	tcore_at_tok_free(tokens);
+
+	// Error status words may be transient, only successful answers are kept
+	if (!((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91))
+		return;
+
+	g_hash_table_replace(cache->entries, g_strdup(cmd), g_strdup(line));
+	_sim_ef_cache_schedule_flush(cache);
+}
+
+static gboolean _sim_ef_cache_drop_ef(gpointer key, gpointer value, gpointer user_data)
+{
+	int ef = 0;
+
+	if (sscanf(key, "AT+CRSM=%*d, %d", &ef) != 1)
+		return TRUE;
+
+	return ef == GPOINTER_TO_INT(user_data);
+}
+
+static void _sim_ef_cache_invalidate(CoreObject *o, enum tel_sim_file_id ef)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+
+	// Covers SAT REFRESH and a new ICCID or IMSI as well
+	if (ef == SIM_EF_INVALID || ef == SIM_EF_ECC)
+		_sim_ecc_cache_clear(o);
+
+	if (!cache)
+		return;
+
+	dbg("EF cache invalidate ef[0x%x]", ef);
+	if (ef == SIM_EF_INVALID) {
+		g_hash_table_remove_all(cache->entries);
+		g_hash_table_remove_all(cache->fcp);
+	} else
+		g_hash_table_foreach_remove(cache->entries, _sim_ef_cache_drop_ef, GINT_TO_POINTER(ef));
+
+	_sim_ef_cache_schedule_flush(cache);
+}
+
+// SAT REFRESH, the card may have changed any of its files
+void s_sim_ef_cache_invalidate(CoreObject *o)
+{
+	_sim_ef_cache_invalidate(o, SIM_EF_INVALID);
+}
+
+static gboolean _sim_ef_cache_on_replay(gpointer user_data)
+{
+	struct s_sim_ef_cache_replay *replay = user_data;
+	TcoreATResponse resp;
+	GSList lines;
+
+	lines.data = replay->line;
+	lines.next = NULL;
+
+	memset(&resp, 0x00, sizeof(TcoreATResponse));
+	resp.success = 1;
+	resp.lines = &lines;
+	resp.final_response = "OK";
+
+	replay->process(replay->o, replay->ur, &resp);
+
+	// Drops the reference a pending would have released when freed
+	tcore_user_request_unref(replay->ur);
+
+	g_free(replay->line);
+	free(replay);
+	return FALSE;
+}
+
+/*
+ * Serves an AT+CRSM from the cache. The answer is fed to the regular
+ * response handler from the main loop, as if the modem had sent it.
+ */
+static gboolean _sim_ef_cache_replay(CoreObject *o, UserRequest *ur, const char *cmd,
+									 void (*process)(CoreObject *o, UserRequest *ur, const TcoreATResponse *resp))
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	struct s_sim_ef_cache_replay *replay = NULL;
+	const char *line = NULL;
+
+	if (!cache)
+		return FALSE;
+
+	line = g_hash_table_lookup(cache->entries, cmd);
+	if (!line)
+		return FALSE;
+
+	replay = calloc(sizeof(struct s_sim_ef_cache_replay), 1);
+	if (!replay)
+		return FALSE;
+
+	dbg("EF cache hit [%s]", cmd);
+	_sim_stats_cache_hit(o, _sim_stats_cmd_ef(cmd));
+	replay->o = o;
+	replay->ur = ur;
+	replay->line = g_strdup(line);
+	replay->process = process;
+	g_idle_add(_sim_ef_cache_on_replay, replay);
+	return TRUE;
+}
+
+/*
+ * Files the upper layers ask for right after INIT_COMPLETED. They are read
+ * through the regular s_read_file() path once the card is identified, so
+ * their answers land in the EF cache. ICCID and CPHS INFO belong to the
+ * mandatory init chain and are not part of the plan.
+ */
+static const struct {
+	enum tcore_request_command command;
+	gboolean cphs_only;
+} sim_prefetch_plan[] = {
+	{ TREQ_SIM_GET_ECC, FALSE },
+	{ TREQ_SIM_GET_LANGUAGE, FALSE },
+	{ TREQ_SIM_GET_SPN, FALSE },
+	{ TREQ_SIM_GET_SPDI, FALSE },
+	{ TREQ_SIM_GET_OPL, FALSE },
+	{ TREQ_SIM_GET_PNN, FALSE },
+	{ TREQ_SIM_GET_MSISDN, FALSE },
+	{ TREQ_SIM_GET_OPLMNWACT, FALSE },
+	{ TREQ_SIM_GET_CPHS_NETNAME, TRUE },
+	{ TREQ_SIM_GET_MAILBOX, FALSE },
+};
+
+static void _sim_prefetch_on_response(UserRequest *ur, enum tcore_response_command command, unsigned int data_len,
+									  const void *data, void *user_data)
+{
+	CoreObject *o = user_data;
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	const struct tresp_sim_read *resp = data;
+
+	dbg("[SIM]prefetch resp[0x%x] result[%d]", command, resp ? (int) resp->result : -1);
+
+	if (!cache)
+		return;
+
+	if (cache->prefetch_inflight > 0)
+		cache->prefetch_inflight--;
+
+	_sim_prefetch_next(o);
+}
+
+/* Reads stay one at a time until the mandatory init reads have landed */
+static void _sim_prefetch_next(CoreObject *o)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	UserRequest *ur = NULL;
+	int window = 1;
+	int i;
+
+	if (!cache)
+		return;
+
+	if (tcore_sim_get_status(o) == SIM_STATUS_INIT_COMPLETED)
+		window = SIM_PREFETCH_WINDOW;
+
+	while (cache->prefetch_inflight < window && cache->prefetch_next < (int) G_N_ELEMENTS(sim_prefetch_plan)) {
+		i = cache->prefetch_next++;
+
+		if (sim_prefetch_plan[i].cphs_only && !tcore_sim_get_cphs_status(o))
+			continue;
+
+		ur = tcore_user_request_new(NULL, NULL);
+		tcore_user_request_set_command(ur, sim_prefetch_plan[i].command);
+		tcore_user_request_set_response_hook(ur, _sim_prefetch_on_response, o);
+
+		cache->prefetch_inflight++;
+		if (tcore_object_dispatch_request(o, ur) != TCORE_RETURN_SUCCESS) {
+			dbg("[SIM]prefetch of [0x%x] not dispatched", sim_prefetch_plan[i].command);
+			cache->prefetch_inflight--;
+			tcore_user_request_unref(ur);
+		}
+	}
+
+	if (cache->prefetch_inflight == 0 && cache->prefetch_next >= (int) G_N_ELEMENTS(sim_prefetch_plan))
+		dbg("[SIM]prefetch done");
+}
+
+static void _sim_prefetch_start(CoreObject *o)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+
+	if (!cache)
+		return;
+
+	dbg("[SIM]prefetch start, files[%d]", (int) G_N_ELEMENTS(sim_prefetch_plan));
+	cache->prefetch_next = 0;
+	cache->prefetch_inflight = 0;
+	_sim_prefetch_next(o);
+}
+
+static void _sim_prefetch_stop(CoreObject *o)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+
+	if (!cache)
+		return;
+
+	cache->prefetch_next = G_N_ELEMENTS(sim_prefetch_plan);
+	cache->prefetch_inflight = 0;
+}
+
+/* Size and record layout of EFs met on this card, they only change with the card */
+static void _sim_fcp_store(CoreObject *o, const struct s_sim_property *file_meta)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	struct s_sim_fcp *fcp = NULL;
+
+	// ICCID tells the card apart, it is always asked to the card
+	if (!cache || file_meta->file_id == SIM_EF_ICCID)
+		return;
+
+	fcp = calloc(sizeof(struct s_sim_fcp), 1);
+	if (!fcp)
+		return;
+
+	fcp->file_type = file_meta->file_type;
+	fcp->rec_length = file_meta->rec_length;
+	fcp->rec_count = file_meta->rec_count;
+	fcp->data_size = file_meta->data_size;
+	g_hash_table_replace(cache->fcp, GINT_TO_POINTER(file_meta->file_id), fcp);
+}
+
+static const struct s_sim_fcp *_sim_fcp_lookup(CoreObject *o, enum tel_sim_file_id ef)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+
+	if (!cache || ef == SIM_EF_ICCID)
+		return NULL;
+
+	return g_hash_table_lookup(cache->fcp, GINT_TO_POINTER(ef));
+}
+
+static gboolean _sim_ef_cache_lookup(CoreObject *o, const char *cmd)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+
+	if (!cache)
+		return FALSE;
+
+	return g_hash_table_lookup(cache->entries, cmd) != NULL;
+}
+
+static char *_sim_record_cmd(enum tel_sim_file_id ef, int index, int length)
+{
+	int p1 = (unsigned char) index;
+	int p2 = (unsigned char) 0x04;       /* 0x4 for absolute mode  */
+	int p3 = (unsigned char) length;
+
+	return g_strdup_printf("AT+CRSM=178, %d, %d, %d, %d", ef, p1, p2, p3);          /*command - 178 : READ RECORD*/
+}
+
+static gboolean _sim_record_is_empty(const char *hex)
+{
+	if (!hex || *hex == '\0')
+		return FALSE;
+
+	for (; *hex; hex++) {
+		if (*hex != 'F' && *hex != 'f')
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Lists written from the first record on, where a run of free records means
+ * the rest is free too. Files addressed by record number (PNN from OPL, MBDN
+ * from MBI, CFIS and MWIS by profile) or with free records anywhere (OPL) are
+ * read to the end.
+ */
+static gboolean _sim_record_empty_run_ends(enum tel_sim_file_id ef)
+{
+	switch (ef) {
+	case SIM_EF_ECC:
+	case SIM_EF_MSISDN:
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+/*
+ * Keeps up to SIM_RECORD_READ_WINDOW READ RECORDs queued instead of one
+ * round trip per record. Each pending holds its own reference of ur, the
+ * one taken by the response handler for the next step is dropped here.
+ */
+static void _sim_read_records(CoreObject *o, UserRequest *ur, struct s_sim_property *file_meta)
+{
+	char *cmd = NULL;
+	gboolean cached = FALSE;
+	int rec_count = MAX(file_meta->rec_count, 1); // record 1 is always read, as before
+
+	if (file_meta->request_index == 0)
+		file_meta->read_start = g_get_monotonic_time();
+
+	while (file_meta->request_index < rec_count
+		   && file_meta->request_index - file_meta->current_index < SIM_RECORD_READ_WINDOW
+		   && file_meta->empty_run < SIM_RECORD_EMPTY_RUN_MAX) {
+		cmd = _sim_record_cmd(file_meta->file_id, file_meta->request_index + 1, file_meta->rec_length);
+		cached = _sim_ef_cache_lookup(o, cmd);
+		g_free(cmd);
+
+		// Cache replays and card answers do not complete in order relative to each other
+		if (file_meta->request_index > file_meta->current_index && cached != file_meta->window_cached)
+			break;
+
+		file_meta->window_cached = cached;
+		file_meta->request_index++;
+		_get_file_record(o, tcore_user_request_ref(ur), file_meta->file_id, file_meta->request_index, file_meta->rec_length);
+	}
+
+	tcore_user_request_unref(ur);
+}
+
+/* Accounts one record answer, TRUE once the whole file is read */
+static gboolean _sim_record_received(CoreObject *o, UserRequest *ur, struct s_sim_property *file_meta)
+{
+	gint64 elapsed = 0;
+
+	file_meta->current_index++;
+
+	if (file_meta->current_index < file_meta->request_index
+		|| (file_meta->current_index < file_meta->rec_count && file_meta->empty_run < SIM_RECORD_EMPTY_RUN_MAX)) {
+		_sim_read_records(o, ur, file_meta);
+		return FALSE;
+	}
+
+	elapsed = g_get_monotonic_time() - file_meta->read_start;
+	dbg("[SIM]EF[0x%x] records[%d/%d] in [%d]ms, [%d] records/s", file_meta->file_id,
+		file_meta->current_index, file_meta->rec_count, (int) (elapsed / 1000),
+		elapsed > 0 ? (int) ((gint64) file_meta->current_index * G_USEC_PER_SEC / elapsed) : 0);
+	return TRUE;
+}
+
+static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_sim_access_result rt, int decode_ret)
+{
+	struct s_sim_property *file_meta = NULL;
+
+	dbg("Entry");
+
+	file_meta = (struct s_sim_property *) tcore_user_request_ref_metainfo(ur, NULL);
+	dbg("[SIM]EF[0x%x] read rt[%d] Decode rt[%d]", file_meta->file_id, rt, decode_ret);
+	switch (file_meta->file_id) {
+	case SIM_EF_ELP:
+	case SIM_EF_USIM_PL:
 	case SIM_EF_LP:
 	case SIM_EF_USIM_LI:
 		if (decode_ret == TRUE) {
@@ -659,13 +1796,12 @@ static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_si
 
 	case SIM_EF_ECC:
 		if (tcore_sim_get_type(o) == SIM_TYPE_USIM) {
-			if (file_meta->current_index == file_meta->rec_count) {
+			if (_sim_record_received(o, ur, file_meta)) {
+				_sim_ecc_cache_store(o, &file_meta->files.data.ecc);
 				tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
-			} else {
-				file_meta->current_index++;
-				_get_file_record(o, ur, file_meta->file_id, file_meta->current_index, file_meta->rec_length);
 			}
 		} else if (tcore_sim_get_type(o) == SIM_TYPE_GSM) {
+			_sim_ecc_cache_store(o, &file_meta->files.data.ecc);
 			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
 		} else {
 			dbg("[SIM DATA]Invalid CardType[%d] Unable to handle", tcore_sim_get_type(o));
@@ -678,30 +1814,18 @@ static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_si
 		break;
 
 	case SIM_EF_MSISDN:
-		if (file_meta->current_index == file_meta->rec_count) {
+		if (_sim_record_received(o, ur, file_meta))
 			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
-		} else {
-			file_meta->current_index++;
-			_get_file_record(o, ur, file_meta->file_id, file_meta->current_index, file_meta->rec_length);
-		}
 		break;
 
 	case SIM_EF_OPL:
-		if (file_meta->current_index == file_meta->rec_count) {
+		if (_sim_record_received(o, ur, file_meta))
 			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
-		} else {
-			file_meta->current_index++;
-			_get_file_record(o, ur, file_meta->file_id, file_meta->current_index, file_meta->rec_length);
-		}
 		break;
 
 	case SIM_EF_PNN:
-		if (file_meta->current_index == file_meta->rec_count) {
+		if (_sim_record_received(o, ur, file_meta))
 			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
-		} else {
-			file_meta->current_index++;
-			_get_file_record(o, ur, file_meta->file_id, file_meta->current_index, file_meta->rec_length);
-		}
 		break;
 
 	case SIM_EF_USIM_CFIS:
@@ -710,12 +1834,8 @@ static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_si
 	case SIM_EF_MBDN:
 	case SIM_EF_CPHS_MAILBOX_NUMBERS:
 	case SIM_EF_CPHS_INFORMATION_NUMBERS:
-		if (file_meta->current_index == file_meta->rec_count) {
+		if (_sim_record_received(o, ur, file_meta))
 			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
-		} else {
-			file_meta->current_index++;
-			_get_file_record(o, ur, file_meta->file_id, file_meta->current_index, file_meta->rec_length);
-		}
 		break;
 
 	case SIM_EF_CPHS_OPERATOR_NAME_STRING:
@@ -737,6 +1857,19 @@ static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_si
 		break;
 
 	case SIM_EF_ICCID:
+		if (tcore_user_request_ref_communicator(ur) == NULL) {
+			// Internal read at SIM init, selects the EF cache of this card
+			if (rt == SIM_ACCESS_SUCCESS && decode_ret == TRUE) {
+				_sim_identity_check_iccid(o, file_meta->files.data.iccid.iccid);
+				_sim_ef_cache_load(o, file_meta->files.data.iccid.iccid);
+				_sim_prefetch_start(o);
+			}
+			tcore_user_request_unref(ur);
+		} else {
+			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_read), &file_meta->files);
+		}
+		break;
+
 	case SIM_EF_SST:
 	case SIM_EF_SPN:
 	case SIM_EF_SPDI:
@@ -760,12 +1893,36 @@ static void _next_from_get_file_data(CoreObject *o, UserRequest *ur, enum tel_si
 static void _sim_status_update(CoreObject *o, enum tel_sim_status sim_status)
 {
 	struct tnoti_sim_status noti_data = {0, };
+	struct s_sim_ef_cache *cache = NULL;
+	struct s_sim_property *sp = tcore_sim_ref_userdata(o);
+
+	// ECC of a removed card must not outlive it
+	if (sim_status == SIM_STATUS_CARD_REMOVED) {
+		_sim_ecc_cache_clear(o);
+
+		cache = _sim_ef_cache_ref(o);
+		if (cache) {
+			g_hash_table_remove_all(cache->entries);
+			g_hash_table_remove_all(cache->fcp);
+			cache->iccid[0] = '\0';
+		}
+		_sim_prefetch_stop(o);
+		_sim_lock_reset(sp);
+		_sim_apdu_reset(o);
+		_sim_update_drop(o);
+		sp->identity_same = -1;
+		sp->identity_current = FALSE;
+	}
 
 	dbg("tcore_sim_set_status and send noti w/ [%d]", sim_status);
 	tcore_sim_set_status(o, sim_status);
 	noti_data.sim_status = sim_status;
 	tcore_server_send_notification(tcore_plugin_ref_server(tcore_object_ref_plugin(o)), o, TNOTI_SIM_STATUS,
 								   sizeof(struct tnoti_sim_status), &noti_data);
+
+	// Mandatory reads are done, the rest of the prefetch may widen its window
+	if (sim_status == SIM_STATUS_INIT_COMPLETED)
+		_sim_prefetch_next(o);
 }
 
 static void _response_get_sim_type(TcorePending *p, int data_len, const void *data, void *user_data)
@@ -817,11 +1974,8 @@ static void _response_get_sim_type(TcorePending *p, int data_len, const void *da
 	dbg(" Function exit");
 }
 
-static void _response_get_file_info(TcorePending *p, int data_len, const void *data, void *user_data)
+static void _sim_file_info_process(CoreObject *co_sim, UserRequest *ur, const TcoreATResponse *resp)
 {
-	const TcoreATResponse *resp = data;
-	UserRequest *ur = NULL;
-	CoreObject *co_sim = NULL;
 	struct s_sim_property *file_meta = NULL;
 	GSList *tokens = NULL;
 	enum tel_sim_access_result rt;
@@ -831,8 +1985,6 @@ static void _response_get_file_info(TcorePending *p, int data_len, const void *d
 
 	dbg(" Function entry ");
 
-	co_sim = tcore_pending_ref_core_object(p);
-	ur = tcore_pending_ref_user_request(p);
 	file_meta = (struct s_sim_property *) tcore_user_request_ref_metainfo(ur, NULL);
 
 	if (resp->success > 0) {
@@ -851,368 +2003,39 @@ static void _response_get_file_info(TcorePending *p, int data_len, const void *d
 
 		/*1. SIM access success case*/
 		if ((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91) {
-			unsigned char tag_len = 0; /*	1 or 2 bytes ??? */
-			unsigned short record_len = 0;
-			char num_of_records = 0;
-			unsigned char file_id_len = 0;
-			unsigned short file_id = 0;
-			unsigned short file_size = 0;
-			unsigned short file_type = 0;
-			unsigned short arr_file_id = 0;
-			int arr_file_id_rec_num = 0;
-
-			/*	handling only last 3 bits */
-			unsigned char file_type_tag = 0x07;
-			unsigned char *ptr_data;
-
-			char *hexData;
-			char *tmp;
-			char *recordData = NULL;
-			hexData = g_slist_nth_data(tokens, 2);
-			dbg("hexData: %s", hexData);
-			dbg("hexData: %s", hexData + 1);
-
-			tmp = util_removeQuotes(hexData);
-			recordData = util_hexStringToBytes(tmp);
-			util_hex_dump("    ", strlen(hexData) / 2, recordData);
-			free(tmp);
-
-			ptr_data = (unsigned char *) recordData;
-			if (tcore_sim_get_type(co_sim) == SIM_TYPE_USIM) {
-				/*
-				 ETSI TS 102 221 v7.9.0
-				 - Response Data
-				 '62'	FCP template tag
-				 - Response for an EF
-				 '82'	M	File Descriptor
-				 '83'	M	File Identifier
-				 'A5'	O	Proprietary information
-				 '8A'	M	Life Cycle Status Integer
-				 '8B', '8C' or 'AB'	C1	Security attributes
-				 '80'	M	File size
-				 '81'	O	Total file size
-				 '88'	O	Short File Identifier (SFI)
-				 */
-
-				/* rsim.res_len  has complete data length received  */
-
-				/* FCP template tag - File Control Parameters tag*/
-				if (*ptr_data == 0x62) {
-					/* parse complete FCP tag*/
-					/* increment to next byte */
-					ptr_data++;
-					tag_len = *ptr_data++;
-					dbg("tag_len: %02x", tag_len);
-					/* FCP file descriptor - file type, accessibility, DF, ADF etc*/
-					if (*ptr_data == 0x82) {
-						/* increment to next byte */
-						ptr_data++;
-						/* 2 or 5 value*/
-						ptr_data++;
-						/*	unsigned char file_desc_len = *ptr_data++;*/
-						/*	dbg("file descriptor length: [%d]", file_desc_len);*/
-						/* TBD:  currently capture only file type : ignore sharable, non sharable, working, internal etc*/
-						/* consider only last 3 bits*/
-						dbg("file_type_tag: %02x", file_type_tag);
-						file_type_tag = file_type_tag & (*ptr_data);
-						dbg("file_type_tag: %02x", file_type_tag);
-
-						switch (file_type_tag) {
-						/* increment to next byte */
-						// ptr_data++;
-						case 0x1:
-							dbg("Getting FileType: [Transparent file type]");
-							file_type = SIM_FTYPE_TRANSPARENT;
-
-							/* increment to next byte */
-							ptr_data++;
-							/* increment to next byte */
-							ptr_data++;
-							break;
-
-						case 0x2:
-							dbg("Getting FileType: [Linear fixed file type]");
-							/* increment to next byte */
-							ptr_data++;
-							/*	data coding byte - value 21 */
-							ptr_data++;
-							/*	2bytes */
-							memcpy(&record_len, ptr_data, 2);
-							/* swap bytes */
-							SWAPBYTES16(record_len);
-							ptr_data = ptr_data + 2;
-							num_of_records = *ptr_data++;
-							/* Data lossy conversation from enum (int) to unsigned char */
-							file_type = SIM_FTYPE_LINEAR_FIXED;
-							break;
-
-						case 0x6:
-							dbg(" Cyclic fixed file type");
-							/* increment to next byte */
-							ptr_data++;
-							/*	data coding byte - value 21 */
-							ptr_data++;
-							/*	2bytes */
-							memcpy(&record_len, ptr_data, 2);
-							/* swap bytes  */
-							SWAPBYTES16(record_len);
-							ptr_data = ptr_data + 2;
-							num_of_records = *ptr_data++;
-							file_type = SIM_FTYPE_CYCLIC;
-							break;
-
-						default:
-							dbg("not handled file type [0x%x]", *ptr_data);
-							break;
-						}
-					} else {
-						dbg("INVALID FCP received - DEbug!");
-						return;
-					}
-
-					/*File identifier - file id?? */ // 0x84,0x85,0x86 etc are currently ignored and not handled
-					if (*ptr_data == 0x83) {
-						/* increment to next byte */
-						ptr_data++;
-						file_id_len = *ptr_data++;
-						dbg("file_id_len: %02x", file_id_len);
-
-						memcpy(&file_id, ptr_data, file_id_len);
-						dbg("file_id: %x", file_id);
-
-						/* swap bytes	 */
-						SWAPBYTES16(file_id);
-						dbg("file_id: %x", file_id);
-
-						ptr_data = ptr_data + 2;
-						dbg("Getting FileID=[0x%x]", file_id);
-					} else {
-						dbg("INVALID FCP received - DEbug!");
-						free(recordData);
-						return;
-					}
-
-					/*	proprietary information  */
-					if (*ptr_data == 0xA5) {
-						unsigned short prop_len;
-						/* increment to next byte */
-						ptr_data++;
-
-						/* length */
-						prop_len = *ptr_data;
-						dbg("prop_len: %02x", prop_len);
-
-						/* skip data */
-						ptr_data = ptr_data + prop_len + 1;
-					} else {
-						dbg("INVALID FCP received - DEbug!");
-					}
-
-					/* life cycle status integer [8A][length:0x01][status]*/
-					/*
-					 status info b8~b1
-					 00000000 : No information given
-					 00000001 : creation state
-					 00000011 : initialization state
-					 000001-1 : operation state -activated
-					 000001-0 : operation state -deactivated
-					 000011-- : Termination state
-					 b8~b5 !=0, b4~b1=X : Proprietary
-					 Any other value : RFU
-					 */
-					if (*ptr_data == 0x8A) {
-						/* increment to next byte */
-						ptr_data++;
-						/* length - value 1 */
-						ptr_data++;
-
-						switch (*ptr_data) {
-						case 0x04:
-						case 0x06:
-							dbg("<RX> operation state -deactivated");
-							ptr_data++;
-							break;
-
-						case 0x05:
-						case 0x07:
-							dbg("<RX> operation state -activated");
-							ptr_data++;
-							break;
-
-						default:
-							dbg("<RX> DEBUG! LIFE CYCLE STATUS =[0x%x]", *ptr_data);
-							ptr_data++;
-							break;
-						}
-					}
-
-					/* related to security attributes : currently not handled*/
-					if (*ptr_data == 0x86 || *ptr_data == 0x8B || *ptr_data == 0x8C || *ptr_data == 0xAB) {
-						/* increment to next byte */
-						ptr_data++;
-						/* if tag length is 3 */
-						if (*ptr_data == 0x03) {
-							/* increment to next byte */
-							ptr_data++;
-							/* EFARR file id */
-							memcpy(&arr_file_id, ptr_data, 2);
-							/* swap byes */
-							SWAPBYTES16(arr_file_id);
-							ptr_data = ptr_data + 2;
-							arr_file_id_rec_num = *ptr_data++;
-						} else {
-							/* if tag length is not 3 */
-							/* ignoring bytes	*/
-							// ptr_data = ptr_data + 4;
-							dbg("Useless security attributes, so jump to next tag");
-							ptr_data = ptr_data + (*ptr_data + 1);
-						}
-					} else {
-						dbg("INVALID FCP received[0x%x] - DEbug!", *ptr_data);
-						free(recordData);
-						return;
-					}
-
-					dbg("Current ptr_data value is [%x]", *ptr_data);
-
-					/* file size excluding structural info*/
-					if (*ptr_data == 0x80) {
-						/* for EF file size is body of file and for Linear or cyclic it is
-						 * number of recXsizeof(one record)
-						 */
-						/* increment to next byte */
-						ptr_data++;
-						/* length is 1 byte - value is 2 bytes or more */
-						ptr_data++;
-						memcpy(&file_size, ptr_data, 2);
-						/* swap bytes */
-						SWAPBYTES16(file_size);
-						ptr_data = ptr_data + 2;
-					} else {
-						dbg("INVALID FCP received - DEbug!");
-						free(recordData);
-						return;
-					}
+			struct util_sim_fcp fcp;
 
-					/* total file size including structural info*/
-					if (*ptr_data == 0x81) {
-						int len;
-						/* increment to next byte */
-						ptr_data++;
-						/* length */
-						len = *ptr_data;
-						/* ignored bytes */
-						ptr_data = ptr_data + 3;
-					} else {
-						dbg("INVALID FCP received - DEbug!");
-						/* 0x81 is optional tag?? check out! so do not return -1 from here! */
-						/* return -1; */
-					}
-					/*short file identifier ignored*/
-					if (*ptr_data == 0x88) {
-						dbg("0x88: Do Nothing");
-						/*DO NOTHING*/
-					}
-				} else {
-					dbg("INVALID FCP received - DEbug!");
-					free(recordData);
-					return;
-				}
-			} else if (tcore_sim_get_type(co_sim) == SIM_TYPE_GSM) {
-				unsigned char gsm_specific_file_data_len = 0;
-				/*	ignore RFU byte1 and byte2 */
-				ptr_data++;
-				ptr_data++;
-				/*	file size */
-				// file_size = p_info->response_len;
-				memcpy(&file_size, ptr_data, 2);
-				/* swap bytes */
-				SWAPBYTES16(file_size);
-				/*	parsed file size */
-				ptr_data = ptr_data + 2;
-				/*  file id  */
-				memcpy(&file_id, ptr_data, 2);
-				SWAPBYTES16(file_id);
-				dbg(" FILE id --> [%x]", file_id);
-				ptr_data = ptr_data + 2;
-				/* save file type - transparent, linear fixed or cyclic */
-				file_type_tag = (*(ptr_data + 7));
-
-				switch (*ptr_data) {
-				case 0x0:
-					/* RFU file type */
-					dbg(" RFU file type- not handled - Debug!");
-					break;
+			if (util_sim_fcp_decode(g_slist_nth_data(tokens, 2), tcore_sim_get_type(co_sim) == SIM_TYPE_USIM, &fcp) == FALSE) {
+				err("invalid FCP for ef[0x%x]", file_meta->file_id);
+				rt = SIM_ACCESS_FAILED;
+			} else {
+				dbg("req ef[0x%x] resp ef[0x%x] size[%d] Type[%d] NumOfRecords[%d] RecordLen[%d]",
+					file_meta->file_id, fcp.file_id, fcp.file_size, fcp.structure, fcp.record_count, fcp.record_len);
 
-				case 0x1:
-					/* MF file type */
-					dbg(" MF file type - not handled - Debug!");
+				switch (fcp.structure) {
+				case UTIL_SIM_FILE_TRANSPARENT:
+					file_meta->file_type = SIM_FTYPE_TRANSPARENT;
 					break;
 
-				case 0x2:
-					/* DF file type */
-					dbg(" DF file type - not handled - Debug!");
+				case UTIL_SIM_FILE_LINEAR_FIXED:
+					file_meta->file_type = SIM_FTYPE_LINEAR_FIXED;
 					break;
 
-				case 0x4:
-					/* EF file type */
-					dbg(" EF file type [%d] ", file_type_tag);
-					/*	increment to next byte */
-					ptr_data++;
-
-					if (file_type_tag == 0x00 || file_type_tag == 0x01) {
-						/* increament to next byte as this byte is RFU */
-						ptr_data++;
-						file_type =
-							(file_type_tag == 0x00) ? SIM_FTYPE_TRANSPARENT : SIM_FTYPE_LINEAR_FIXED;
-					} else {
-						/* increment to next byte */
-						ptr_data++;
-						/*	For a cyclic EF all bits except bit 7 are RFU; b7=1 indicates that */
-						/* the INCREASE command is allowed on the selected cyclic file. */
-						file_type = SIM_FTYPE_CYCLIC;
-					}
-					/* bytes 9 to 11 give SIM file access conditions */
-					ptr_data++;
-					/* byte 10 has one nibble that is RF U and another for INCREASE which is not used currently */
-					ptr_data++;
-					/* byte 11 is invalidate and rehabilate nibbles */
-					ptr_data++;
-					/* byte 12 - file status */
-					ptr_data++;
-					/* byte 13 - GSM specific data */
-					gsm_specific_file_data_len = *ptr_data;
-					ptr_data++;
-					/*	byte 14 - structure of EF - transparent or linear or cyclic , already saved above */
-					ptr_data++;
-					/* byte 15 - length of record for linear and cyclic , for transparent it is set to 0x00. */
-					record_len = *ptr_data;
-					dbg("record length[%d], file size[%d]", record_len, file_size);
-
-					if (record_len != 0)
-						num_of_records = (file_size / record_len);
-
-					dbg("Number of records [%d]", num_of_records);
+				case UTIL_SIM_FILE_CYCLIC:
+					file_meta->file_type = SIM_FTYPE_CYCLIC;
 					break;
 
 				default:
-					dbg(" not handled file type");
+					file_meta->file_type = SIM_FTYPE_INVALID_TYPE;
 					break;
 				}
-			} else {
-				dbg(" Card Type - UNKNOWN  [%d]", tcore_sim_get_type(co_sim));
+				file_meta->data_size = fcp.file_size;
+				file_meta->rec_length = fcp.record_len;
+				file_meta->rec_count = fcp.record_count;
+				file_meta->current_index = 0; // reset for new record type EF
+				rt = SIM_ACCESS_SUCCESS;
+				_sim_fcp_store(co_sim, file_meta);
 			}
-
-			dbg("req ef[0x%x] resp ef[0x%x] size[%ld] Type[0x%x] NumOfRecords[%ld] RecordLen[%ld]",
-				file_meta->file_id, file_id, file_size, file_type, num_of_records, record_len);
-
-			file_meta->file_type = file_type;
-			file_meta->data_size = file_size;
-			file_meta->rec_length = record_len;
-			file_meta->rec_count = num_of_records;
-			file_meta->current_index = 0; // reset for new record type EF
-			rt = SIM_ACCESS_SUCCESS;
-			free(recordData);
 		} else {
 			/*2. SIM access fail case*/
 			dbg("error to get ef[0x%x]", file_meta->file_id);
@@ -1236,11 +2059,8 @@ static void _response_get_file_info(TcorePending *p, int data_len, const void *d
 	dbg(" Function exit");
 }
 
-static void _response_get_file_data(TcorePending *p, int data_len, const void *data, void *user_data)
+static void _sim_file_data_process(CoreObject *co_sim, UserRequest *ur, const TcoreATResponse *resp)
 {
-	const TcoreATResponse *resp = data;
-	UserRequest *ur = NULL;
-	CoreObject *co_sim = NULL;
 	struct s_sim_property *file_meta = NULL;
 	GSList *tokens = NULL;
 	enum tel_sim_access_result rt;
@@ -1259,8 +2079,6 @@ static void _response_get_file_data(TcorePending *p, int data_len, const void *d
 
 	dbg(" Function entry ");
 
-	co_sim = tcore_pending_ref_core_object(p);
-	ur = tcore_pending_ref_user_request(p);
 	file_meta = (struct s_sim_property *) tcore_user_request_ref_metainfo(ur, NULL);
 
 	if (resp->success > 0) {
@@ -1288,6 +2106,11 @@ static void _response_get_file_data(TcorePending *p, int data_len, const void *d
 			file_meta->files.result = rt;
 			dbg("file_meta->file_id : %x", file_meta->file_id);
 
+			if (_sim_record_is_empty(tmp) && _sim_record_empty_run_ends(file_meta->file_id))
+				file_meta->empty_run++;
+			else
+				file_meta->empty_run = 0;
+
 			switch (file_meta->file_id) {
 			case SIM_EF_IMSI:
 			{
@@ -1347,7 +2170,8 @@ static void _response_get_file_data(TcorePending *p, int data_len, const void *d
 				dbg("decode w/ index [%d]", file_meta->current_index);
 				memset(&msisdn, 0x00, sizeof(struct tel_sim_msisdn));
 				dr = tcore_sim_decode_msisdn(&msisdn, (unsigned char *) res, res_len);
-				if (dr == TRUE) {
+				if (dr == TRUE
+						&& file_meta->files.data.msisdn_list.count < SIM_MSISDN_SLOT_CNT(file_meta)) {
 					memcpy(&file_meta->files.data.msisdn_list.msisdn[file_meta->files.data.msisdn_list.count], &msisdn, sizeof(struct tel_sim_msisdn));
 					file_meta->files.data.msisdn_list.count++;
 				}
@@ -1429,23 +2253,154 @@ static void _response_get_file_data(TcorePending *p, int data_len, const void *d
 	ur = tcore_user_request_ref(ur);
 
 	dbg("Calling _next_from_get_file_data");
-	_next_from_get_file_data(tcore_pending_ref_core_object(p), ur, rt, dr);
+	_next_from_get_file_data(co_sim, ur, rt, dr);
 	dbg(" Function exit");
 }
 
-static void _on_response_get_retry_count(TcorePending *p, int data_len, const void *data, void *user_data)
+static void _response_get_file_info(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	const TcoreATResponse *resp = data;
+	CoreObject *co_sim = NULL;
+	TcoreATRequest *req = NULL;
+
+	co_sim = tcore_pending_ref_core_object(p);
+	req = tcore_pending_ref_request_data(p, NULL);
+	if (req) {
+		_sim_stats_received(co_sim, _sim_stats_cmd_ef(req->cmd), 0);
+		_sim_ef_cache_store(co_sim, req->cmd, resp);
+	}
+
+	_sim_file_info_process(co_sim, tcore_pending_ref_user_request(p), resp);
+}
+
+static void _response_get_file_data(TcorePending *p, int data_len, const void *data, void *user_data)
 {
 	const TcoreATResponse *resp = data;
-	UserRequest *ur = NULL;
 	CoreObject *co_sim = NULL;
+	TcoreATRequest *req = NULL;
+
+	co_sim = tcore_pending_ref_core_object(p);
+	req = tcore_pending_ref_request_data(p, NULL);
+	if (req) {
+		_sim_stats_received(co_sim, _sim_stats_cmd_ef(req->cmd),
+							resp->lines ? _sim_stats_line_bytes(resp->lines->data) : 0);
+		_sim_ef_cache_store(co_sim, req->cmd, resp);
+	}
+
+	_sim_file_data_process(co_sim, tcore_pending_ref_user_request(p), resp);
+}
+
+/* Answers a failed PIN/PUK operation with the attempts left */
+static void _sim_send_retry_count(CoreObject *co_sim, UserRequest *ur, int attempts_left)
+{
 	struct s_sim_property *sp = NULL;
-	GSList *tokens = NULL;
-	const char *line = NULL;
 	struct tresp_sim_verify_pins v_pin = {0, };
 	struct tresp_sim_verify_puks v_puk = {0, };
 	struct tresp_sim_change_pins change_pin = {0, };
 	struct tresp_sim_disable_facility dis_facility = {0, };
 	struct tresp_sim_enable_facility en_facility = {0, };
+
+	sp = tcore_sim_ref_userdata(co_sim);
+
+	switch (sp->current_sec_op) {
+	case SEC_PIN1_VERIFY:
+	case SEC_PIN2_VERIFY:
+	case SEC_SIM_VERIFY:
+	case SEC_ADM_VERIFY:
+		v_pin.result = SIM_INCORRECT_PASSWORD;
+		v_pin.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
+		v_pin.retry_count = attempts_left;
+		tcore_user_request_send_response(ur, _find_resp_command(ur),
+										 sizeof(struct tresp_sim_verify_pins), &v_pin);
+		break;
+
+	case SEC_PUK1_VERIFY:
+	case SEC_PUK2_VERIFY:
+		v_puk.result = SIM_INCORRECT_PASSWORD;
+		v_puk.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
+		v_puk.retry_count = attempts_left;
+		tcore_user_request_send_response(ur, _find_resp_command(ur),
+										 sizeof(struct tresp_sim_verify_puks), &v_puk);
+		break;
+
+	case SEC_PIN1_CHANGE:
+	case SEC_PIN2_CHANGE:
+		change_pin.result = SIM_INCORRECT_PASSWORD;
+		change_pin.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
+		change_pin.retry_count = attempts_left;
+		tcore_user_request_send_response(ur, _find_resp_command(ur),
+										 sizeof(struct tresp_sim_change_pins), &change_pin);
+		break;
+
+	case SEC_PIN1_DISABLE:
+	case SEC_PIN2_DISABLE:
+	case SEC_FDN_DISABLE:
+	case SEC_SIM_DISABLE:
+	case SEC_NET_DISABLE:
+	case SEC_NS_DISABLE:
+	case SEC_SP_DISABLE:
+	case SEC_CP_DISABLE:
+		dis_facility.result = SIM_INCORRECT_PASSWORD;
+		dis_facility.type = _sim_get_current_pin_facility(sp->current_sec_op);
+		dis_facility.retry_count = attempts_left;
+		tcore_user_request_send_response(ur, _find_resp_command(ur),
+										 sizeof(struct tresp_sim_disable_facility), &dis_facility);
+		break;
+
+	case SEC_PIN1_ENABLE:
+	case SEC_PIN2_ENABLE:
+	case SEC_FDN_ENABLE:
+	case SEC_SIM_ENABLE:
+	case SEC_NET_ENABLE:
+	case SEC_NS_ENABLE:
+	case SEC_SP_ENABLE:
+	case SEC_CP_ENABLE:
+		en_facility.result = SIM_INCORRECT_PASSWORD;
+		en_facility.type = _sim_get_current_pin_facility(sp->current_sec_op);
+		en_facility.retry_count = attempts_left;
+		tcore_user_request_send_response(ur, _find_resp_command(ur),
+										 sizeof(struct tresp_sim_enable_facility), &en_facility);
+		break;
+
+	default:
+		dbg("not handled sec op[%d]", sp->current_sec_op);
+		break;
+	}
+}
+
+/*
+ * A wrong password (+CME ERROR: 16) costs exactly one attempt, so a known
+ * counter answers the failure without AT+XPINCNT. FALSE when the counter
+ * is unknown or the operation failed for another reason.
+ */
+static gboolean _sim_retry_count_from_cache(CoreObject *co_sim, UserRequest *ur, const char *final_response)
+{
+	struct s_sim_property *sp = NULL;
+	struct util_at_error error;
+	int slot;
+
+	sp = tcore_sim_ref_userdata(co_sim);
+	slot = _sim_lock_slot(sp->current_sec_op);
+
+	util_at_error_decode(final_response, &error);
+	if (error.cms || error.code != 16 || sp->locks[slot].retry_count <= 0)
+		return FALSE;
+
+	sp->locks[slot].retry_count--;
+	dbg("lock type[%d] attempts left[%d] from cache", slot, sp->locks[slot].retry_count);
+
+	_sim_send_retry_count(co_sim, ur, sp->locks[slot].retry_count);
+	return TRUE;
+}
+
+static void _on_response_get_retry_count(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	const TcoreATResponse *resp = data;
+	UserRequest *ur = NULL;
+	CoreObject *co_sim = NULL;
+	struct s_sim_property *sp = NULL;
+	GSList *tokens = NULL;
+	const char *line = NULL;
 	int lock_type = 0;
 	int attempts_left = 0;
 	int time_penalty = 0;
@@ -1467,77 +2422,28 @@ static void _on_response_get_retry_count(TcorePending *p, int data_len, const vo
 				return;
 			}
 		}
-		lock_type = atoi(g_slist_nth_data(tokens, 0));
-		attempts_left = atoi(g_slist_nth_data(tokens, 1));
-		time_penalty = atoi(g_slist_nth_data(tokens, 2));
-
-		dbg("lock_type = %d, attempts_left = %d, time_penalty = %d",
-			lock_type, attempts_left, time_penalty);
-
-		switch (sp->current_sec_op) {
-		case SEC_PIN1_VERIFY:
-		case SEC_PIN2_VERIFY:
-		case SEC_SIM_VERIFY:
-		case SEC_ADM_VERIFY:
-			v_pin.result = SIM_INCORRECT_PASSWORD;
-			v_pin.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
-			v_pin.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_verify_pins), &v_pin);
-			break;
 
-		case SEC_PUK1_VERIFY:
-		case SEC_PUK2_VERIFY:
-			v_puk.result = SIM_INCORRECT_PASSWORD;
-			v_puk.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
-			v_puk.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_verify_puks), &v_puk);
-			break;
-
-		case SEC_PIN1_CHANGE:
-		case SEC_PIN2_CHANGE:
-			change_pin.result = SIM_INCORRECT_PASSWORD;
-			change_pin.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
-			change_pin.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_change_pins), &change_pin);
-			break;
+		if (g_slist_length(tokens) == 4) {
+			// <PIN1>,<PIN2>,<PUK1>,<PUK2> attempts, all counters at once
+			sp->locks[SIM_LOCK_SLOT_PIN1].retry_count = atoi(g_slist_nth_data(tokens, 0));
+			sp->locks[SIM_LOCK_SLOT_PIN2].retry_count = atoi(g_slist_nth_data(tokens, 1));
+			sp->locks[SIM_LOCK_SLOT_PUK1].retry_count = atoi(g_slist_nth_data(tokens, 2));
+			sp->locks[SIM_LOCK_SLOT_PUK2].retry_count = atoi(g_slist_nth_data(tokens, 3));
+			lock_type = _sim_lock_slot(sp->current_sec_op);
+			attempts_left = sp->locks[lock_type].retry_count;
+		} else {
+			lock_type = atoi(g_slist_nth_data(tokens, 0));
+			attempts_left = atoi(g_slist_nth_data(tokens, 1));
+			time_penalty = atoi(g_slist_nth_data(tokens, 2));
 
-		case SEC_PIN1_DISABLE:
-		case SEC_PIN2_DISABLE:
-		case SEC_FDN_DISABLE:
-		case SEC_SIM_DISABLE:
-		case SEC_NET_DISABLE:
-		case SEC_NS_DISABLE:
-		case SEC_SP_DISABLE:
-		case SEC_CP_DISABLE:
-			dis_facility.result = SIM_INCORRECT_PASSWORD;
-			dis_facility.type = _sim_get_current_pin_facility(sp->current_sec_op);
-			dis_facility.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_disable_facility), &dis_facility);
-			break;
+			if (lock_type >= 0 && lock_type < SIM_LOCK_SLOT_MAX)
+				sp->locks[lock_type].retry_count = attempts_left;
+		}
 
-		case SEC_PIN1_ENABLE:
-		case SEC_PIN2_ENABLE:
-		case SEC_FDN_ENABLE:
-		case SEC_SIM_ENABLE:
-		case SEC_NET_ENABLE:
-		case SEC_NS_ENABLE:
-		case SEC_SP_ENABLE:
-		case SEC_CP_ENABLE:
-			en_facility.result = SIM_INCORRECT_PASSWORD;
-			en_facility.type = _sim_get_current_pin_facility(sp->current_sec_op);
-			en_facility.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_enable_facility), &en_facility);
-			break;
+		dbg("lock_type = %d, attempts_left = %d, time_penalty = %d",
+			lock_type, attempts_left, time_penalty);
 
-		default:
-			dbg("not handled sec op[%d]", sp->current_sec_op);
-			break;
-		}
+		_sim_send_retry_count(co_sim, ur, attempts_left);
 		tcore_at_tok_free(tokens);
 	}
 	dbg(" Function exit");
@@ -1572,29 +2478,74 @@ static gboolean _get_sim_type(CoreObject *o)
 	return TRUE;
 }
 
+static gboolean _sim_fcp_on_replay(gpointer user_data)
+{
+	struct s_sim_fcp_replay *replay = user_data;
+
+	// The reference the GET RESPONSE pending would have owned goes to the next step
+	_next_from_get_file_info(replay->o, replay->ur, replay->ef, SIM_ACCESS_SUCCESS);
+
+	free(replay);
+	return FALSE;
+}
+
 static TReturn _get_file_info(CoreObject *o, UserRequest *ur, const enum tel_sim_file_id ef)
 {
 	TcoreHal *hal = NULL;
 	TcorePending *pending = NULL;
 	struct s_sim_property file_meta = {0, };
+	const struct s_sim_fcp *fcp = NULL;
+	struct s_sim_fcp_replay *replay = NULL;
 	char *cmd_str = NULL;
 	int trt = 0;
 
 	dbg(" Function entry ");
 
+	// A read must see what was written before it
+	_sim_update_flush_ef(o, ef);
+	_sim_stats_request(o, ef, 0);
+
 	file_meta.file_id = ef;
 	dbg("file_meta.file_id: %d", file_meta.file_id);
 	hal = tcore_object_get_hal(o);
 	dbg("hal: %x", hal);
-	pending = tcore_pending_new(o, 0);
+
+	fcp = _sim_fcp_lookup(o, ef);
+	if (fcp) {
+		file_meta.file_type = fcp->file_type;
+		file_meta.rec_length = fcp->rec_length;
+		file_meta.rec_count = fcp->rec_count;
+		file_meta.data_size = fcp->data_size;
+	}
 
 	trt = tcore_user_request_set_metainfo(ur, sizeof(struct s_sim_property), &file_meta);
 	dbg("trt[%d]", trt);
+
+	// Answered later like a card response, callers do not expect it before returning
+	if (fcp) {
+		replay = calloc(sizeof(struct s_sim_fcp_replay), 1);
+		if (replay) {
+			dbg("FCP of ef[0x%x] known, GET RESPONSE skipped", ef);
+			_sim_stats_cache_hit(o, ef);
+			replay->o = o;
+			replay->ur = ur;
+			replay->ef = ef;
+			g_idle_add(_sim_fcp_on_replay, replay);
+			return TCORE_RETURN_SUCCESS;
+		}
+	}
+
 	cmd_str = g_strdup_printf("AT+CRSM=192, %d", ef);           /*command - 192 : GET RESPONSE*/
 	dbg("cmd_str: %x", cmd_str);
 
+	if (_sim_ef_cache_replay(o, ur, cmd_str, _sim_file_info_process)) {
+		free(cmd_str);
+		return TCORE_RETURN_SUCCESS;
+	}
+
 	pending = tcore_at_pending_new(o, cmd_str, "+CRSM:", TCORE_AT_SINGLELINE, _response_get_file_info, NULL);
 	tcore_pending_link_user_request(pending, ur);
+	_sim_stats_sent(o, ef);
 	tcore_hal_send_request(hal, pending);
 
 	free(cmd_str);
@@ -1614,7 +2565,6 @@ static gboolean _get_file_data(CoreObject *o, UserRequest *ur, const enum tel_si
 
 	dbg(" Function entry ");
 	hal = tcore_object_get_hal(o);
-	pending = tcore_pending_new(o, 0);
 
 	dbg("file_id: %x", ef);
 
@@ -1624,6 +2574,12 @@ static gboolean _get_file_data(CoreObject *o, UserRequest *ur, const enum tel_si
 
 	cmd_str = g_strdup_printf("AT+CRSM=176, %d, %d, %d, %d", ef, p1, p2, p3);          /*command - 176 : READ BINARY*/
 
+	if (_sim_ef_cache_replay(o, ur, cmd_str, _sim_file_data_process)) {
+		free(cmd_str);
+		return TRUE;
+	}
+
+	pending = tcore_pending_new(o, 0);
 	req = tcore_at_request_new(cmd_str, "+CRSM:", TCORE_AT_SINGLELINE);
 
 	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
@@ -1633,6 +2589,7 @@ static gboolean _get_file_data(CoreObject *o, UserRequest *ur, const enum tel_si
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sim_message_send, NULL);
 
+	_sim_stats_sent(o, ef);
 	tcore_hal_send_request(hal, pending);
 
 	free(cmd_str);
@@ -1646,20 +2603,19 @@ static gboolean _get_file_record(CoreObject *o, UserRequest *ur, const enum tel_
 	TcoreATRequest *req = NULL;
 	TcorePending *pending = NULL;
 	char *cmd_str = NULL;
-	int p1 = 0;
-	int p2 = 0;
-	int p3 = 0;
 
 	dbg(" Function entry ");
 
 	hal = tcore_object_get_hal(o);
-	pending = tcore_pending_new(o, 0);
 
-	p1 = (unsigned char) index;
-	p2 = (unsigned char) 0x04;       /* 0x4 for absolute mode  */
-	p3 = (unsigned char) length;
+	cmd_str = _sim_record_cmd(ef, index, length);
+
+	if (_sim_ef_cache_replay(o, ur, cmd_str, _sim_file_data_process)) {
+		free(cmd_str);
+		return TRUE;
+	}
 
-	cmd_str = g_strdup_printf("AT+CRSM=178, %d, %d, %d, %d", ef, p1, p2, p3);          /*command - 178 : READ RECORD*/
+	pending = tcore_pending_new(o, 0);
 
 	req = tcore_at_request_new(cmd_str, "+CRSM:", TCORE_AT_SINGLELINE);
 
@@ -1670,82 +2626,32 @@ static gboolean _get_file_record(CoreObject *o, UserRequest *ur, const enum tel_
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sim_message_send, NULL);
 
+	_sim_stats_sent(o, ef);
 	tcore_hal_send_request(hal, pending);
 
 	free(cmd_str);
 	dbg(" Function exit");
-	return TRUE;
-}
-
-static TReturn _get_retry_count(CoreObject *o, UserRequest *ur)
-{
-	TcoreHal *hal = NULL;
-	TcoreATRequest *req = NULL;
-	TcorePending *pending = NULL;
-	char *cmd_str = NULL;
-	int lock_type = 0;
-	struct s_sim_property *sp = NULL;
-	const struct treq_sim_get_lock_info *req_data = NULL;
-
-	dbg(" Function entry ");
-
-	hal = tcore_object_get_hal(o);
-	pending = tcore_pending_new(o, 0);
-	req_data = tcore_user_request_ref_data(ur, NULL);
-	sp = tcore_sim_ref_userdata(o);
-
-	switch (sp->current_sec_op) {
-	case SEC_PIN1_VERIFY:
-	case SEC_PIN1_CHANGE:
-	case SEC_PIN1_ENABLE:
-	case SEC_PIN1_DISABLE:
-		lock_type = 1;
-		break;
-
-	case SEC_PIN2_VERIFY:
-	case SEC_PIN2_CHANGE:
-	case SEC_PIN2_ENABLE:
-	case SEC_PIN2_DISABLE:
-	case SEC_FDN_ENABLE:
-	case SEC_FDN_DISABLE:
-		lock_type = 2;
-		break;
-
-	case SEC_PUK1_VERIFY:
-		lock_type = 3;
-		break;
-
-	case SEC_PUK2_VERIFY:
-		lock_type = 4;
-		break;
-
-	case SEC_NET_ENABLE:
-	case SEC_NET_DISABLE:
-		lock_type = 5;
-		break;
-
-	case SEC_NS_ENABLE:
-	case SEC_NS_DISABLE:
-		lock_type = 6;
-		break;
-
-	case SEC_SP_ENABLE:
-	case SEC_SP_DISABLE:
-		lock_type = 7;
-		break;
+	return TRUE;
+}
 
-	case SEC_CP_ENABLE:
-	case SEC_CP_DISABLE:
-		lock_type = 8;
-		break;
+static TReturn _get_retry_count(CoreObject *o, UserRequest *ur)
+{
+	TcoreHal *hal = NULL;
+	TcoreATRequest *req = NULL;
+	TcorePending *pending = NULL;
+	char *cmd_str = NULL;
+	int lock_type = 0;
+	struct s_sim_property *sp = NULL;
+	const struct treq_sim_get_lock_info *req_data = NULL;
 
-	case SEC_ADM_VERIFY:
-		lock_type = 9;
-		break;
+	dbg(" Function entry ");
 
-	default:
-		break;
-	}
+	hal = tcore_object_get_hal(o);
+	pending = tcore_pending_new(o, 0);
+	req_data = tcore_user_request_ref_data(ur, NULL);
+	sp = tcore_sim_ref_userdata(o);
+
+	lock_type = _sim_lock_slot(sp->current_sec_op);
 
 	cmd_str = g_strdup_printf("AT+XPINCNT=%d", lock_type);
 	req = tcore_at_request_new(cmd_str, "+XPINCNT:", TCORE_AT_SINGLELINE);
@@ -1763,15 +2669,19 @@ static TReturn _get_retry_count(CoreObject *o, UserRequest *ur)
 }
 
 
+/* +XLOCK: <fac>,<lock state>,<lock status>[,<fac>,<lock state>,<lock status>...] */
 static gboolean on_event_facility_lock_status(CoreObject *o, const void *event_info, void *user_data)
 {
 	struct s_sim_property *sp = NULL;
 	char *line = NULL;
+	char *fac = NULL;
 	GSList *tokens = NULL;
 	GSList *lines = NULL;
+	unsigned int count;
+	unsigned int i;
+	unsigned int j;
 
 	dbg("Function entry");
-	return TRUE;
 
 	sp = tcore_sim_ref_userdata(o);
 	lines = (GSList *) event_info;
@@ -1781,10 +2691,22 @@ static gboolean on_event_facility_lock_status(CoreObject *o, const void *event_i
 	}
 	line = (char *) (lines->data);
 	tokens = tcore_at_tok_new(line);
-	if (g_slist_length(tokens) != 1) {
+	count = g_slist_length(tokens);
+	if (count < 3 || count % 3 != 0) {
 		msg("invalid message");
-		tcore_at_tok_free(tokens);
-		return TRUE;
+		goto OUT;
+	}
+
+	for (i = 0; i < count; i += 3) {
+		fac = util_removeQuotes(g_slist_nth_data(tokens, i));
+		for (j = 0; j < G_N_ELEMENTS(sim_lock_facility); j++) {
+			if (g_strcmp0(fac, sim_lock_facility[j].name) == 0) {
+				sp->locks[sim_lock_facility[j].slot].lock_status = atoi(g_slist_nth_data(tokens, i + 2));
+				dbg("facility[%s] lock status[%d]", fac, sp->locks[sim_lock_facility[j].slot].lock_status);
+				break;
+			}
+		}
+		free(fac);
 	}
 
 OUT:
@@ -1885,8 +2807,17 @@ static gboolean on_event_pin_status(CoreObject *o, const void *event_info, void
 		break;
 	}
 
+	// PIN1 is used up once the card asks for PUK1, and PUK1 once it is blocked
+	if (sim_status == SIM_STATUS_PUK_REQUIRED || sim_status == SIM_STATUS_CARD_BLOCKED)
+		sp->locks[SIM_LOCK_SLOT_PIN1].retry_count = 0;
+	if (sim_status == SIM_STATUS_CARD_BLOCKED)
+		sp->locks[SIM_LOCK_SLOT_PUK1].retry_count = 0;
+
 	switch (sim_status) {
 	case SIM_STATUS_INIT_COMPLETED:
+		ur = tcore_user_request_new(NULL, NULL);     // ICCID first, it selects the EF cache of the card
+		_get_file_info(o, ur, SIM_EF_ICCID);
+
 		ur = tcore_user_request_new(NULL, NULL);     // this is for using ur metainfo set/ref functionality.
 		_get_file_info(o, ur, SIM_EF_IMSI);
 		break;
@@ -1961,6 +2892,7 @@ static void on_response_verify_pins(TcorePending *p, int data_len, const void *d
 		dbg("RESPONSE OK");
 		res.result = SIM_PIN_OPERATION_SUCCESS;
 		res.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
+		_sim_lock_forget(sp, sp->current_sec_op);
 		if (res.pin_type == SIM_PTYPE_PIN1 || res.pin_type == SIM_PTYPE_SIM) {
 			if (tcore_sim_get_status(co_sim) != SIM_STATUS_INIT_COMPLETED)
 				_sim_status_update(co_sim, SIM_STATUS_INITIALIZING);
@@ -1977,8 +2909,10 @@ static void on_response_verify_pins(TcorePending *p, int data_len, const void *d
 			err = atoi(g_slist_nth_data(tokens, 0));
 			dbg("on_response_verify_pins: err = %d", err);
 			queue = tcore_object_ref_user_data(co_sim);
-			ur = tcore_user_request_ref(ur);
-			_get_retry_count(co_sim, ur);
+			if (_sim_retry_count_from_cache(co_sim, ur, resp->final_response) == FALSE) {
+				ur = tcore_user_request_ref(ur);
+				_get_retry_count(co_sim, ur);
+			}
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -2009,6 +2943,7 @@ static void on_response_verify_puks(TcorePending *p, int data_len, const void *d
 		dbg("RESPONSE OK");
 		res.result = SIM_PIN_OPERATION_SUCCESS;
 		res.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
+		_sim_lock_forget(sp, sp->current_sec_op);
 		tcore_user_request_send_response(ur, TRESP_SIM_VERIFY_PUKS, sizeof(struct tresp_sim_verify_pins), &res);
 	} else {
 		dbg("RESPONSE NOK");
@@ -2021,8 +2956,10 @@ static void on_response_verify_puks(TcorePending *p, int data_len, const void *d
 		} else {
 			err = atoi(g_slist_nth_data(tokens, 0));
 			queue = tcore_object_ref_user_data(co_sim);
-			ur = tcore_user_request_ref(ur);
-			_get_retry_count(co_sim, ur);
+			if (_sim_retry_count_from_cache(co_sim, ur, resp->final_response) == FALSE) {
+				ur = tcore_user_request_ref(ur);
+				_get_retry_count(co_sim, ur);
+			}
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -2053,6 +2990,7 @@ static void on_response_change_pins(TcorePending *p, int data_len, const void *d
 		dbg("RESPONSE OK");
 		res.result = SIM_PIN_OPERATION_SUCCESS;
 		res.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
+		_sim_lock_forget(sp, sp->current_sec_op);
 		tcore_user_request_send_response(ur, TRESP_SIM_CHANGE_PINS, sizeof(struct tresp_sim_change_pins), &res);
 	} else {
 		dbg("RESPONSE NOK");
@@ -2065,8 +3003,10 @@ static void on_response_change_pins(TcorePending *p, int data_len, const void *d
 		} else {
 			err = atoi(g_slist_nth_data(tokens, 0));
 			queue = tcore_object_ref_user_data(co_sim);
-			ur = tcore_user_request_ref(ur);
-			_get_retry_count(co_sim, ur);
+			if (_sim_retry_count_from_cache(co_sim, ur, resp->final_response) == FALSE) {
+				ur = tcore_user_request_ref(ur);
+				_get_retry_count(co_sim, ur);
+			}
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -2153,6 +3093,7 @@ static void on_response_enable_facility(TcorePending *p, int data_len, const voi
 			}
 		}
 		res.result = SIM_PIN_OPERATION_SUCCESS;
+		_sim_lock_forget(sp, sp->current_sec_op);
 		if (ur) {
 			tcore_user_request_send_response(ur, TRESP_SIM_ENABLE_FACILITY,
 											 sizeof(struct tresp_sim_enable_facility), &res);
@@ -2161,8 +3102,10 @@ static void on_response_enable_facility(TcorePending *p, int data_len, const voi
 	} else {
 		dbg("RESPONSE NOK");
 		queue = tcore_object_ref_user_data(co_sim);
-		ur = tcore_user_request_ref(ur);
-		_get_retry_count(co_sim, ur);
+		if (_sim_retry_count_from_cache(co_sim, ur, resp->final_response) == FALSE) {
+			ur = tcore_user_request_ref(ur);
+			_get_retry_count(co_sim, ur);
+		}
 	}
 	dbg(" Function exit");
 }
@@ -2201,6 +3144,7 @@ static void on_response_disable_facility(TcorePending *p, int data_len, const vo
 			}
 		}
 		res.result = SIM_PIN_OPERATION_SUCCESS;
+		_sim_lock_forget(sp, sp->current_sec_op);
 		if (ur) {
 			tcore_user_request_send_response(ur, TRESP_SIM_DISABLE_FACILITY,
 											 sizeof(struct tresp_sim_disable_facility), &res);
@@ -2209,226 +3153,713 @@ static void on_response_disable_facility(TcorePending *p, int data_len, const vo
 	} else {
 		dbg("RESPONSE NOK");
 		queue = tcore_object_ref_user_data(co_sim);
-		ur = tcore_user_request_ref(ur);
-		_get_retry_count(co_sim, ur);
+		if (_sim_retry_count_from_cache(co_sim, ur, resp->final_response) == FALSE) {
+			ur = tcore_user_request_ref(ur);
+			_get_retry_count(co_sim, ur);
+		}
+	}
+	dbg(" Function exit");
+}
+
+static void on_response_get_lock_info(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	const TcoreATResponse *resp = data;
+	UserRequest *ur = NULL;
+	CoreObject *co_sim = NULL;
+	struct s_sim_property *sp = NULL;
+	GSList *tokens = NULL;
+	const char *line = NULL;
+	const struct treq_sim_get_lock_info *req_data = NULL;
+	struct tresp_sim_get_lock_info res;
+	int slot;
+
+	dbg(" Function entry ");
+
+	co_sim = tcore_pending_ref_core_object(p);
+	sp = tcore_sim_ref_userdata(co_sim);
+	ur = tcore_pending_ref_user_request(p);
+	req_data = tcore_user_request_ref_data(ur, NULL);
+	slot = _sim_lock_slot_by_facility(req_data->type);
+
+	if (resp->success > 0 && resp->lines) {
+		dbg("RESPONSE OK");
+		line = (const char *) resp->lines->data;
+		tokens = tcore_at_tok_new(line);
+		if (g_slist_length(tokens) == 4) {
+			sp->locks[SIM_LOCK_SLOT_PIN1].retry_count = atoi(g_slist_nth_data(tokens, 0));
+			sp->locks[SIM_LOCK_SLOT_PIN2].retry_count = atoi(g_slist_nth_data(tokens, 1));
+			sp->locks[SIM_LOCK_SLOT_PUK1].retry_count = atoi(g_slist_nth_data(tokens, 2));
+			sp->locks[SIM_LOCK_SLOT_PUK2].retry_count = atoi(g_slist_nth_data(tokens, 3));
+		} else if (g_slist_length(tokens) == 3 && slot >= 0) {
+			sp->locks[slot].retry_count = atoi(g_slist_nth_data(tokens, 1));
+		} else {
+			msg("invalid message");
+		}
+		tcore_at_tok_free(tokens);
+	}
+
+	if (_sim_lock_info_build(co_sim, req_data->type, &res) == FALSE) {
+		dbg("RESPONSE NOK");
+		res.result = SIM_ACCESS_FAILED;
+	}
+
+	dbg("facility[%d] lock status[%d] retry count[%d]", res.type, res.lock_status, res.retry_count);
+	tcore_user_request_send_response(ur, TRESP_SIM_GET_LOCK_INFO, sizeof(struct tresp_sim_get_lock_info), &res);
+	dbg(" Function exit");
+}
+
+static void _sim_update_free(struct s_sim_update *update)
+{
+	g_slist_free(update->requests);
+	g_free(update->key);
+	g_free(update->data);
+	free(update);
+}
+
+/* Answers every request a write stood for and drops the references their pendings would have */
+static void _sim_update_answer(struct s_sim_update *update, enum tel_sim_access_result result)
+{
+	struct tresp_sim_set_callforwarding resp_cf = {0, };
+	struct tresp_sim_set_language resp_language = {0, };
+	struct s_sim_property *sp = NULL;
+	UserRequest *ur = NULL;
+	GSList *l = NULL;
+
+	for (l = update->requests; l; l = l->next) {
+		ur = l->data;
+		sp = (struct s_sim_property *) tcore_user_request_ref_metainfo(ur, NULL);
+
+		switch (sp->file_id) {
+		case SIM_EF_CPHS_CALL_FORWARD_FLAGS:
+		case SIM_EF_USIM_CFIS:
+			resp_cf.result = result;
+			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_set_callforwarding), &resp_cf);
+			break;
+
+		case SIM_EF_ELP:
+		case SIM_EF_LP:
+		case SIM_EF_USIM_LI:
+		case SIM_EF_USIM_PL:
+			resp_language.result = result;
+			tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_set_language), &resp_language);
+			break;
+
+		default:
+			dbg("Invalid File ID - %d", sp->file_id)
+			break;
+		}
+		tcore_user_request_unref(ur);
+	}
+}
+
+/*
+ * A whole-file UPDATE BINARY or an absolute UPDATE RECORD leaves the card
+ * holding exactly what was written, which becomes the cached READ answer.
+ */
+static gboolean _sim_ef_cache_write_through(CoreObject *o, const struct s_sim_update *update)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	const struct s_sim_fcp *fcp = NULL;
+	char *cmd = NULL;
+
+	if (!cache || cache->iccid[0] == '\0' || !_sim_ef_cache_allowed(update->ef))
+		return FALSE;
+
+	fcp = _sim_fcp_lookup(o, update->ef);
+	if (!fcp)
+		return FALSE;
+
+	if (update->cmd == 214 && update->p1 == 0 && update->p2 == 0 && update->p3 == fcp->data_size)
+		cmd = g_strdup_printf("AT+CRSM=176, %d, %d, %d, %d", update->ef, 0, 0, update->p3);
+	else if (update->cmd == 220 && update->p2 == 0x04 && update->p3 == fcp->rec_length)
+		cmd = _sim_record_cmd(update->ef, update->p1, update->p3);
+	else
+		return FALSE;
+
+	dbg("EF cache write-through [%s]", cmd);
+	g_hash_table_replace(cache->entries, cmd, g_strdup_printf("144,0,\"%s\"", update->data));
+	_sim_ef_cache_schedule_flush(cache);
+	return TRUE;
+}
+
+static void on_response_update_file(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	const TcoreATResponse *resp = data;
+	struct s_sim_update *update = user_data;
+	CoreObject *co_sim = NULL;
+	GSList *tokens = NULL;
+	enum tel_sim_access_result result;
+	const char *line;
+	int sw1 = 0;
+	int sw2 = 0;
+
+	dbg(" Function entry ");
+
+	co_sim = tcore_pending_ref_core_object(p);
+	_sim_stats_received(co_sim, update->ef, 0);
+
+	if (resp->success > 0) {
+		dbg("RESPONSE OK");
+		result = SIM_ACCESS_FAILED;
+		if (resp->lines) {
+			line = (const char *) resp->lines->data;
+			tokens = tcore_at_tok_new(line);
+			if (g_slist_length(tokens) == 2) {
+				sw1 = atoi(g_slist_nth_data(tokens, 0));
+				sw2 = atoi(g_slist_nth_data(tokens, 1));
+
+				if ((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91) {
+					result = SIM_ACCESS_SUCCESS;
+				} else {
+					result = _decode_status_word(sw1, sw2);
+				}
+			} else {
+				msg("invalid message");
+			}
+			tcore_at_tok_free(tokens);
+		}
+	} else {
+		dbg("RESPONSE NOK");
+		result = SIM_ACCESS_FAILED;
 	}
+
+	// Even a failed UPDATE may have partially written the EF
+	if (result != SIM_ACCESS_SUCCESS || _sim_ef_cache_write_through(co_sim, update) == FALSE)
+		_sim_ef_cache_invalidate(co_sim, update->ef);
+
+	_sim_update_answer(update, result);
+	_sim_update_free(update);
 	dbg(" Function exit");
 }
 
-static void on_response_get_lock_info(TcorePending *p, int data_len, const void *data, void *user_data)
+static void _sim_update_send(struct s_sim_update *update)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(update->o);
+	TcoreATRequest *req = NULL;
+	TcorePending *pending = NULL;
+	char *cmd_str = NULL;
+
+	if (cache && update->key)
+		g_hash_table_steal(cache->updates, update->key);
+
+	if (update->timer_id)
+		g_source_remove(update->timer_id);
+	update->timer_id = 0;
+
+	// Reads served until the answer would predate the write
+	_sim_ef_cache_invalidate(update->o, update->ef);
+
+	dbg("EF[0x%x] update, standing for %d request(s)", update->ef, g_slist_length(update->requests));
+
+	cmd_str = g_strdup_printf("AT+CRSM=%d,%d,%d,%d,%d,\"%s\"", update->cmd, update->ef, update->p1, update->p2, update->p3, update->data);
+	req = tcore_at_request_new(cmd_str, "+CRSM:", TCORE_AT_SINGLELINE);
+	pending = tcore_pending_new(update->o, 0);
+
+	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
+
+	tcore_pending_set_request_data(pending, 0, req);
+	tcore_pending_set_response_callback(pending, on_response_update_file, update);
+	tcore_pending_set_send_callback(pending, on_confirmation_sim_message_send, NULL);
+	_sim_stats_sent(update->o, update->ef);
+	tcore_hal_send_request(tcore_object_get_hal(update->o), pending);
+
+	g_free(cmd_str);
+}
+
+static gboolean _sim_update_on_timer(gpointer user_data)
+{
+	struct s_sim_update *update = user_data;
+
+	update->timer_id = 0;
+	_sim_update_send(update);
+	return FALSE;
+}
+
+/*
+ * Holds an UPDATE for SIM_UPDATE_COALESCE_DELAY. A newer one for the same
+ * file location replaces its data in the meantime, so a burst of updates
+ * (MWIS toggled while voicemail arrives) reaches the card once, with the
+ * final state, and answers all of its requests.
+ */
+static void _sim_update_queue(CoreObject *o, UserRequest *ur, enum tel_sim_file_id ef,
+							  int cmd, int p1, int p2, int p3, const char *data)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	struct s_sim_update *update = NULL;
+	char *key = NULL;
+
+	_sim_stats_request(o, ef, p3);
+
+	key = g_strdup_printf("%d,%d,%d,%d", cmd, ef, p1, p2);
+	if (cache)
+		update = g_hash_table_lookup(cache->updates, key);
+
+	if (update) {
+		dbg("EF[0x%x] update coalesced with the previous one", ef);
+		g_free(key);
+		g_free(update->data);
+		update->data = g_strdup(data);
+		update->p3 = p3;
+		update->requests = g_slist_append(update->requests, ur);
+		return;
+	}
+
+	update = calloc(sizeof(struct s_sim_update), 1);
+	update->o = o;
+	update->ef = ef;
+	update->cmd = cmd;
+	update->p1 = p1;
+	update->p2 = p2;
+	update->p3 = p3;
+	update->data = g_strdup(data);
+	update->requests = g_slist_append(NULL, ur);
+
+	if (!cache) {
+		g_free(key);
+		_sim_update_send(update);
+		return;
+	}
+
+	update->key = key;
+	g_hash_table_insert(cache->updates, update->key, update);
+	update->timer_id = g_timeout_add(SIM_UPDATE_COALESCE_DELAY, _sim_update_on_timer, update);
+}
+
+static gboolean _sim_update_match_ef(gpointer key, gpointer value, gpointer user_data)
+{
+	struct s_sim_update *update = value;
+
+	return update->ef == GPOINTER_TO_INT(user_data);
+}
+
+static void _sim_update_flush_ef(CoreObject *o, enum tel_sim_file_id ef)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	struct s_sim_update *update = NULL;
+
+	if (!cache)
+		return;
+
+	while ((update = g_hash_table_find(cache->updates, _sim_update_match_ef, GINT_TO_POINTER(ef))) != NULL)
+		_sim_update_send(update);
+}
+
+/* The card went away with the updates still waiting for it */
+static void _sim_update_drop(CoreObject *o)
+{
+	struct s_sim_ef_cache *cache = _sim_ef_cache_ref(o);
+	struct s_sim_update *update = NULL;
+	GHashTableIter iter;
+	gpointer value = NULL;
+
+	if (!cache)
+		return;
+
+	g_hash_table_iter_init(&iter, cache->updates);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		update = value;
+		g_hash_table_iter_steal(&iter);
+		g_source_remove(update->timer_id);
+		_sim_update_answer(update, SIM_ACCESS_CARD_ERROR);
+		_sim_update_free(update);
+	}
+}
+
+static struct s_sim_apdu *_sim_apdu_ref(CoreObject *o)
+{
+	return tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SIMAPDU");
+}
+
+/* Channel a command APDU is meant for, from its class byte (TS 102 221 10.1.1) */
+static int _sim_apdu_channel_of(unsigned char cla)
+{
+	if (cla == 0xFF)
+		return -1;
+
+	if (cla & 0x40)
+		return 4 + (cla & 0x0F);
+
+	return cla & 0x03;
+}
+
+/*
+ * Class byte with the channel bits of card_ch, for APDUs a +CCHO session
+ * carries: the channel handed out by MANAGE CHANNEL is ours, the card knows
+ * the session by the channel it opened. Chaining, secure messaging and the
+ * proprietary bit are kept.
+ */
+static unsigned char _sim_apdu_cla_for_channel(unsigned char cla, int card_ch)
+{
+	unsigned char sm = 0;
+
+	if (card_ch < 0 || card_ch >= SIM_APDU_CHANNEL_MAX)
+		return cla;
+
+	// Secure messaging is two bits in the first interindustry class, one in the further one
+	if (cla & 0x40)
+		sm = (cla & 0x20) ? 0x08 : 0x00;
+	else
+		sm = cla & 0x0C;
+
+	if (card_ch < 4)
+		return (cla & 0x80) | (cla & 0x10) | sm | card_ch;
+
+	return (cla & 0x80) | 0x40 | (sm ? 0x20 : 0x00) | (cla & 0x10) | (card_ch - 4);
+}
+
+/* AT command carrying binary data as a quoted hex string, encoded in place */
+static char *_sim_apdu_cmd_new(const char *head, const unsigned char *data, int len)
+{
+	size_t head_len = strlen(head);
+	char *cmd_str = NULL;
+
+	cmd_str = g_malloc(head_len + (2 * len) + 3);
+	memcpy(cmd_str, head, head_len);
+	cmd_str[head_len] = '"';
+	util_byte_to_hex((const char *) data, cmd_str + head_len + 1, len);
+	cmd_str[head_len + 1 + (2 * len)] = '"';
+	cmd_str[head_len + 2 + (2 * len)] = '\0';
+
+	return cmd_str;
+}
+
+/* Decodes a (quoted) hex response APDU, -1 if it does not fit */
+static int _sim_apdu_hex_decode(const char *hex, unsigned char *out, int max)
+{
+	int len = 0;
+
+	if (!hex)
+		return -1;
+
+	if (*hex == '"')
+		hex++;
+
+	while (g_ascii_isxdigit(hex[0]) && g_ascii_isxdigit(hex[1])) {
+		if (len == max)
+			return -1;
+		out[len++] = (g_ascii_xdigit_value(hex[0]) << 4) | g_ascii_xdigit_value(hex[1]);
+		hex += 2;
+	}
+
+	return len;
+}
+
+/*
+ * Answers an APDU request without the modem, sw1 and sw2 only unless data
+ * is given. Requests taken off a channel queue have no pending to release
+ * them, the caller drops that reference.
+ */
+static void _sim_apdu_answer(UserRequest *ur, enum tel_sim_access_result result, const unsigned char *data, int len)
+{
+	struct tresp_sim_transmit_apdu res;
+
+	memset(&res, 0, sizeof(struct tresp_sim_transmit_apdu));
+	res.result = result;
+	if (data && len > 0 && len <= (int) sizeof(res.apdu_resp)) {
+		memcpy(res.apdu_resp, data, len);
+		res.apdu_resp_length = len;
+	}
+	tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_transmit_apdu), &res);
+}
+
+static void _sim_apdu_answer_sw(UserRequest *ur, unsigned char sw1, unsigned char sw2)
+{
+	unsigned char sw[2];
+
+	sw[0] = sw1;
+	sw[1] = sw2;
+	_sim_apdu_answer(ur, SIM_ACCESS_SUCCESS, sw, 2);
+}
+
+static void _sim_apdu_channel_close(struct s_sim_apdu_channel *channel, int ch)
+{
+	gint64 elapsed = g_get_monotonic_time() - channel->open_time;
+
+	dbg("channel[%d] closed, %d APDUs in %d ms (%d APDU/s)", ch, channel->apdu_count, (int) (elapsed / 1000),
+		elapsed > 0 ? (int) (channel->apdu_count * G_GINT64_CONSTANT(1000000) / elapsed) : 0);
+
+	channel->opened = FALSE;
+	channel->session_id = -1;
+	channel->apdu_count = 0;
+}
+
+static void _sim_apdu_send(CoreObject *o, int ch, char *cmd_str, const char *prefix, enum tcore_at_command_type type,
+						   TcorePendingResponseCallback callback, UserRequest *ur)
+{
+	struct s_sim_apdu *apdu = _sim_apdu_ref(o);
+	TcoreATRequest *req = NULL;
+	TcorePending *pending = NULL;
+
+	pending = tcore_pending_new(o, 0);
+	req = tcore_at_request_new(cmd_str, prefix, type);
+
+	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
+
+	tcore_pending_set_request_data(pending, 0, req);
+	tcore_pending_set_response_callback(pending, callback, GINT_TO_POINTER(ch));
+	if (ur)
+		tcore_pending_link_user_request(pending, ur);
+	tcore_pending_set_send_callback(pending, on_confirmation_sim_message_send, NULL);
+
+	apdu->channel[ch].busy = TRUE;
+	_sim_stats_sent(o, SIM_STATS_APDU);
+	tcore_hal_send_request(tcore_object_get_hal(o), pending);
+
+	g_free(cmd_str);
+}
+
+static void on_response_transmit_apdu(TcorePending *p, int data_len, const void *data, void *user_data)
 {
 	const TcoreATResponse *resp = data;
 	UserRequest *ur = NULL;
 	CoreObject *co_sim = NULL;
-	struct s_sim_property *sp = NULL;
+	struct s_sim_apdu *apdu = NULL;
 	GSList *tokens = NULL;
-	const char *line;
-	struct tresp_sim_verify_pins v_pin = {0, };
-	struct tresp_sim_verify_puks v_puk = {0, };
-	struct tresp_sim_change_pins change_pin = {0, };
-	struct tresp_sim_disable_facility dis_facility = {0, };
-	struct tresp_sim_enable_facility en_facility = {0, };
-	int lock_type;
-	int attempts_left = 0;
-	int time_penalty = 0;
+	struct tresp_sim_transmit_apdu res;
+	int ch = GPOINTER_TO_INT(user_data);
+	int len;
 
 	dbg(" Function entry ");
 
 	co_sim = tcore_pending_ref_core_object(p);
-	sp = tcore_sim_ref_userdata(co_sim);
+	apdu = _sim_apdu_ref(co_sim);
 	ur = tcore_pending_ref_user_request(p);
 
-	if (resp->success > 0) {
+	memset(&res, 0, sizeof(struct tresp_sim_transmit_apdu));
+	res.result = SIM_ACCESS_FAILED;
+
+	if (resp->success > 0 && resp->lines) {
 		dbg("RESPONSE OK");
-		if (resp->lines) {
-			line = (const char *) resp->lines->data;
-			tokens = tcore_at_tok_new(line);
-			if (g_slist_length(tokens) != 3) {
-				msg("invalid message");
-				tcore_at_tok_free(tokens);
-				return;
+		// +CSIM: <length>,<response> or +CGLA: <length>,<response>
+		tokens = tcore_at_tok_new((const char *) resp->lines->data);
+		if (g_slist_length(tokens) == 2) {
+			len = _sim_apdu_hex_decode(g_slist_nth_data(tokens, 1), res.apdu_resp, sizeof(res.apdu_resp));
+			if (len >= 2) {
+				res.result = SIM_ACCESS_SUCCESS;
+				res.apdu_resp_length = len;
+				apdu->channel[ch].apdu_count++;
+			} else {
+				msg("invalid response APDU");
 			}
+		} else {
+			msg("invalid message");
 		}
-		lock_type = atoi(g_slist_nth_data(tokens, 0));
-		attempts_left = atoi(g_slist_nth_data(tokens, 1));
-		time_penalty = atoi(g_slist_nth_data(tokens, 2));
-
-		switch (sp->current_sec_op) {
-		case SEC_PIN1_VERIFY:
-		case SEC_PIN2_VERIFY:
-		case SEC_SIM_VERIFY:
-		case SEC_ADM_VERIFY:
-			v_pin.result = SIM_INCORRECT_PASSWORD;
-			v_pin.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
-			v_pin.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_verify_pins), &v_pin);
-			break;
+		tcore_at_tok_free(tokens);
+	} else {
+		dbg("RESPONSE NOK");
+	}
 
-		case SEC_PUK1_VERIFY:
-		case SEC_PUK2_VERIFY:
-			v_puk.result = SIM_INCORRECT_PASSWORD;
-			v_puk.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
-			v_puk.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_verify_puks), &v_puk);
-			break;
+	if (ur)
+		tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_transmit_apdu), &res);
 
-		case SEC_PIN1_CHANGE:
-		case SEC_PIN2_CHANGE:
-			change_pin.result = SIM_INCORRECT_PASSWORD;
-			change_pin.pin_type = _sim_get_current_pin_facility(sp->current_sec_op);
-			change_pin.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_change_pins), &change_pin);
-			break;
+	_sim_stats_received(co_sim, SIM_STATS_APDU, res.apdu_resp_length);
+	apdu->channel[ch].busy = FALSE;
+	_sim_apdu_channel_next(co_sim, ch);
+	dbg(" Function exit");
+}
 
-		case SEC_PIN1_DISABLE:
-		case SEC_PIN2_DISABLE:
-		case SEC_FDN_DISABLE:
-		case SEC_SIM_DISABLE:
-		case SEC_NET_DISABLE:
-		case SEC_NS_DISABLE:
-		case SEC_SP_DISABLE:
-		case SEC_CP_DISABLE:
-			dis_facility.result = SIM_INCORRECT_PASSWORD;
-			dis_facility.type = _sim_get_current_pin_facility(sp->current_sec_op);
-			dis_facility.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_disable_facility), &dis_facility);
-			break;
+static void on_response_apdu_channel_open(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	const TcoreATResponse *resp = data;
+	CoreObject *co_sim = NULL;
+	struct s_sim_apdu_channel *channel = NULL;
+	UserRequest *ur = NULL;
+	const char *line = NULL;
+	int ch = GPOINTER_TO_INT(user_data);
 
-		case SEC_PIN1_ENABLE:
-		case SEC_PIN2_ENABLE:
-		case SEC_FDN_ENABLE:
-		case SEC_SIM_ENABLE:
-		case SEC_NET_ENABLE:
-		case SEC_NS_ENABLE:
-		case SEC_SP_ENABLE:
-		case SEC_CP_ENABLE:
-			en_facility.result = SIM_INCORRECT_PASSWORD;
-			en_facility.type = _sim_get_current_pin_facility(sp->current_sec_op);
-			en_facility.retry_count = attempts_left;
-			tcore_user_request_send_response(ur, _find_resp_command(ur),
-											 sizeof(struct tresp_sim_enable_facility), &en_facility);
-			break;
+	co_sim = tcore_pending_ref_core_object(p);
+	channel = &_sim_apdu_ref(co_sim)->channel[ch];
+	channel->busy = FALSE;
+	_sim_stats_received(co_sim, SIM_STATS_APDU, 0);
 
-		default:
-			dbg("not handled sec op[%d]", sp->current_sec_op);
-			break;
+	// Card removed meanwhile, the session went with it
+	if (!channel->opened)
+		return;
+
+	if (resp->success > 0 && resp->lines) {
+		// <sessionid>, some firmwares prefix it with +CCHO:
+		line = (const char *) resp->lines->data;
+		if (g_str_has_prefix(line, "+CCHO:"))
+			line += strlen("+CCHO:");
+		channel->session_id = atoi(line);
+		channel->open_time = g_get_monotonic_time();
+		dbg("channel[%d] session[%d]", ch, channel->session_id);
+	} else {
+		// The SELECT that asked for the session fails in its place
+		dbg("channel[%d] +CCHO failed", ch);
+		ur = g_queue_pop_head(channel->queue);
+		if (ur) {
+			_sim_apdu_answer(ur, SIM_ACCESS_FAILED, NULL, 0);
+			tcore_user_request_unref(ur);
 		}
-		tcore_at_tok_free(tokens);
 	}
-	dbg(" Function exit");
+
+	// The SELECT goes over the session as well, for the FCI the card returns
+	_sim_apdu_channel_next(co_sim, ch);
 }
 
-static void on_response_update_file(TcorePending *p, int data_len, const void *data, void *user_data)
+static void on_response_apdu_channel_close(TcorePending *p, int data_len, const void *data, void *user_data)
 {
 	const TcoreATResponse *resp = data;
-	UserRequest *ur = NULL;
 	CoreObject *co_sim = NULL;
-	struct tresp_sim_set_callforwarding resp_cf = {0, };
-	struct tresp_sim_set_language resp_language = {0, };
-	struct s_sim_property *sp = NULL;
-	GSList *tokens = NULL;
-	enum tel_sim_access_result result;
-	const char *line;
-	int sw1 = 0;
-	int sw2 = 0;
-
-	dbg(" Function entry ");
+	struct s_sim_apdu_channel *channel = NULL;
+	UserRequest *ur = NULL;
+	int ch = GPOINTER_TO_INT(user_data);
 
 	co_sim = tcore_pending_ref_core_object(p);
+	channel = &_sim_apdu_ref(co_sim)->channel[ch];
 	ur = tcore_pending_ref_user_request(p);
-	sp = (struct s_sim_property *) tcore_user_request_ref_metainfo(ur, NULL);
+	_sim_stats_received(co_sim, SIM_STATS_APDU, 0);
 
 	if (resp->success > 0) {
-		dbg("RESPONSE OK");
-		if (resp->lines) {
-			line = (const char *) resp->lines->data;
-			tokens = tcore_at_tok_new(line);
-			if (g_slist_length(tokens) != 2) {
-				msg("invalid message");
-				tcore_at_tok_free(tokens);
-				return;
+		if (ur)
+			_sim_apdu_answer_sw(ur, 0x90, 0x00);
+	} else {
+		dbg("channel[%d] +CCHC failed, dropping it anyway", ch);
+		if (ur)
+			_sim_apdu_answer(ur, SIM_ACCESS_FAILED, NULL, 0);
+	}
+
+	if (channel->opened)
+		_sim_apdu_channel_close(channel, ch);
+	channel->busy = FALSE;
+	_sim_apdu_channel_next(co_sim, ch);
+}
+
+/*
+ * Sends the APDUs queued on a channel, one at a time so the card sees them
+ * in order; different channels are with the modem at the same time. The
+ * basic channel uses AT+CSIM, a logical channel gets its +CCHO session
+ * from the first SELECT by DF name sent on it and uses AT+CGLA after.
+ */
+static void _sim_apdu_channel_next(CoreObject *o, int ch)
+{
+	struct s_sim_apdu *apdu = _sim_apdu_ref(o);
+	struct s_sim_apdu_channel *channel = NULL;
+	const struct treq_sim_transmit_apdu *req_data = NULL;
+	UserRequest *ur = NULL;
+	unsigned char *command = NULL;
+	char head[32];
+
+	if (!apdu)
+		return;
+
+	channel = &apdu->channel[ch];
+	while (!channel->busy && (ur = g_queue_peek_head(channel->queue)) != NULL) {
+		req_data = tcore_user_request_ref_data(ur, NULL);
+
+		if (ch == 0) {
+			g_queue_pop_head(channel->queue);
+			g_snprintf(head, sizeof(head), "AT+CSIM=%d,", req_data->apdu_length * 2);
+			_sim_apdu_send(o, ch, _sim_apdu_cmd_new(head, req_data->apdu, req_data->apdu_length),
+						   "+CSIM:", TCORE_AT_SINGLELINE, on_response_transmit_apdu, ur);
+			continue;
+		}
+
+		if (!channel->opened) {
+			g_queue_pop_head(channel->queue);
+			_sim_apdu_answer_sw(ur, 0x68, 0x81); // logical channel not supported
+			tcore_user_request_unref(ur);
+			continue;
+		}
+
+		if (req_data->apdu[1] == SIM_APDU_INS_MANAGE_CHANNEL) {
+			g_queue_pop_head(channel->queue);
+			if (channel->session_id < 0) {
+				_sim_apdu_channel_close(channel, ch);
+				_sim_apdu_answer_sw(ur, 0x90, 0x00);
+				tcore_user_request_unref(ur);
+				continue;
 			}
+			g_snprintf(head, sizeof(head), "AT+CCHC=%d", channel->session_id);
+			_sim_apdu_send(o, ch, g_strdup(head), NULL, TCORE_AT_NO_RESULT, on_response_apdu_channel_close, ur);
+			continue;
 		}
-		sw1 = atoi(g_slist_nth_data(tokens, 0));
-		sw2 = atoi(g_slist_nth_data(tokens, 1));
 
-		if ((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91) {
-			result = SIM_ACCESS_SUCCESS;
-		} else {
-			result = _decode_status_word(sw1, sw2);
+		if (channel->session_id < 0) {
+			if (req_data->apdu[1] == SIM_APDU_INS_SELECT && req_data->apdu[2] == 0x04
+				&& req_data->apdu_length >= 5 && req_data->apdu[4] > 0
+				&& req_data->apdu_length >= 5 + (unsigned int) req_data->apdu[4]) {
+				// The request stays queued, the session answers it
+				_sim_apdu_send(o, ch, _sim_apdu_cmd_new("AT+CCHO=", req_data->apdu + 5, req_data->apdu[4]),
+							   NULL, TCORE_AT_NUMERIC, on_response_apdu_channel_open, NULL);
+				continue;
+			}
+			g_queue_pop_head(channel->queue);
+			_sim_apdu_answer_sw(ur, 0x69, 0x85); // conditions of use not satisfied
+			tcore_user_request_unref(ur);
+			continue;
 		}
-	} else {
-		dbg("RESPONSE NOK");
-		result = SIM_ACCESS_FAILED;
+
+		// The modem reports the card channel behind a session as its session id
+		g_queue_pop_head(channel->queue);
+		command = g_memdup(req_data->apdu, req_data->apdu_length);
+		command[0] = _sim_apdu_cla_for_channel(command[0], channel->session_id);
+		g_snprintf(head, sizeof(head), "AT+CGLA=%d,%d,", channel->session_id, req_data->apdu_length * 2);
+		_sim_apdu_send(o, ch, _sim_apdu_cmd_new(head, command, req_data->apdu_length),
+					   "+CGLA:", TCORE_AT_SINGLELINE, on_response_transmit_apdu, ur);
+		g_free(command);
 	}
+}
 
-	switch (sp->file_id) {
-	case SIM_EF_CPHS_CALL_FORWARD_FLAGS:
-	case SIM_EF_USIM_CFIS:
-		tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_set_callforwarding), &resp_cf);
-		break;
+/* MANAGE CHANNEL open, the channel number is handed out here and the session made on SELECT */
+static void _sim_apdu_channel_open(CoreObject *o, UserRequest *ur, unsigned char p2)
+{
+	struct s_sim_apdu *apdu = _sim_apdu_ref(o);
+	unsigned char resp[3];
+	int ch = p2;
 
-	case SIM_EF_ELP:
-	case SIM_EF_LP:
-	case SIM_EF_USIM_LI:
-	case SIM_EF_USIM_PL:
-		tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_set_language), &resp_language);
-		break;
+	if (ch == 0) {
+		for (ch = 1; ch < SIM_APDU_CHANNEL_MAX; ch++) {
+			if (!apdu->channel[ch].opened && g_queue_is_empty(apdu->channel[ch].queue))
+				break;
+		}
+	}
 
-	default:
-		dbg("Invalid File ID - %d", sp->file_id)
-		break;
+	if (ch >= SIM_APDU_CHANNEL_MAX || apdu->channel[ch].opened) {
+		_sim_apdu_answer_sw(ur, 0x6A, 0x81); // function not supported, no channel left
+		tcore_user_request_unref(ur);
+		return;
 	}
-	tcore_at_tok_free(tokens);
-	dbg(" Function exit");
+
+	apdu->channel[ch].opened = TRUE;
+	apdu->channel[ch].session_id = -1;
+	apdu->channel[ch].apdu_count = 0;
+	apdu->channel[ch].open_time = g_get_monotonic_time();
+	dbg("channel[%d] opened", ch);
+
+	if (p2 == 0) {
+		resp[0] = ch;
+		resp[1] = 0x90;
+		resp[2] = 0x00;
+		_sim_apdu_answer(ur, SIM_ACCESS_SUCCESS, resp, 3);
+	} else {
+		_sim_apdu_answer_sw(ur, 0x90, 0x00);
+	}
+
+	// Answered without a pending, see _sim_apdu_answer()
+	tcore_user_request_unref(ur);
 }
 
-static void on_response_transmit_apdu(TcorePending *p, int data_len, const void *data, void *user_data)
+/* Sessions do not outlive the card, whatever is still queued fails */
+static void _sim_apdu_reset(CoreObject *o)
 {
-	const TcoreATResponse *resp = data;
+	struct s_sim_apdu *apdu = _sim_apdu_ref(o);
 	UserRequest *ur = NULL;
-	CoreObject *co_sim = NULL;
-	struct s_sim_property *sp = NULL;
-	GSList *tokens = NULL;
-	struct tresp_sim_transmit_apdu res;
-	const char *line;
-
-	dbg(" Function entry ");
-
-	co_sim = tcore_pending_ref_core_object(p);
-	sp = tcore_sim_ref_userdata(co_sim);
-	ur = tcore_pending_ref_user_request(p);
+	int ch;
 
-	memset(&res, 0, sizeof(struct tresp_sim_transmit_apdu));
+	if (!apdu)
+		return;
 
-	if (resp->success > 0) {
-		dbg("RESPONSE OK");
-		res.result = SIM_ACCESS_SUCCESS;
-		if (resp->lines) {
-			line = (const char *) resp->lines->data;
-			tokens = tcore_at_tok_new(line);
-			if (g_slist_length(tokens) != 2) {
-				msg("invalid message");
-				tcore_at_tok_free(tokens);
-				return;
-			}
+	for (ch = 0; ch < SIM_APDU_CHANNEL_MAX; ch++) {
+		while ((ur = g_queue_pop_head(apdu->channel[ch].queue)) != NULL) {
+			_sim_apdu_answer(ur, SIM_ACCESS_CARD_ERROR, NULL, 0);
+			tcore_user_request_unref(ur);
 		}
-		res.apdu_resp_length = atoi(g_slist_nth_data(tokens, 0));
-		strncpy((char *) res.apdu_resp, (const char *) g_slist_nth_data(tokens, 1), res.apdu_resp_length);
-	} else {
-		dbg("RESPONSE NOK");
-		res.result = SIM_ACCESS_FAILED;
-	}
-	ur = tcore_pending_ref_user_request(p);
-	if (ur) {
-		tcore_user_request_send_response(ur, _find_resp_command(ur), sizeof(struct tresp_sim_transmit_apdu), &res);
+		apdu->channel[ch].opened = (ch == 0);
+		apdu->channel[ch].session_id = -1;
+		apdu->channel[ch].apdu_count = 0;
 	}
-	tcore_at_tok_free(tokens);
-	dbg(" Function exit");
 }
 
 static TReturn s_verify_pins(CoreObject *o, UserRequest *ur)
@@ -2751,52 +4182,39 @@ static TReturn s_get_lock_info(CoreObject *o, UserRequest *ur)
 	TcoreATRequest *req = NULL;
 	TcorePending *pending = NULL;
 	char *cmd_str = NULL;
-	char *lock_type = NULL;
+	const char *lock_type = NULL;
 	const struct treq_sim_get_lock_info *req_data;
-	struct s_sim_property *sp = NULL;
+	struct tresp_sim_get_lock_info res;
+	unsigned int i;
 
 	dbg(" Function entry ");
 
-	hal = tcore_object_get_hal(o);
-	sp = tcore_sim_ref_userdata(o);
-	pending = tcore_pending_new(o, 0);
-	req_data = tcore_user_request_ref_data(ur, NULL);
-
 	if (!o || !ur)
 		return TCORE_RETURN_EINVAL;
 
-	switch (req_data->type) {
-	case SIM_FACILITY_PS:
-		lock_type = "PS";
-		break;
-
-	case SIM_FACILITY_SC:
-		lock_type = "SC";
-		break;
-
-	case SIM_FACILITY_FD:
-		lock_type = "FD";
-		break;
-
-	case SIM_FACILITY_PN:
-		lock_type = "PN";
-		break;
-
-	case SIM_FACILITY_PU:
-		lock_type = "PU";
-		break;
+	hal = tcore_object_get_hal(o);
+	req_data = tcore_user_request_ref_data(ur, NULL);
 
-	case SIM_FACILITY_PP:
-		lock_type = "PP";
-		break;
+	// Counters already reported by the modem need no round trip
+	if (_sim_lock_info_build(o, req_data->type, &res) == TRUE) {
+		dbg("facility[%d] lock status[%d] retry count[%d] from cache", res.type, res.lock_status, res.retry_count);
+		tcore_user_request_send_response(ur, TRESP_SIM_GET_LOCK_INFO, sizeof(struct tresp_sim_get_lock_info), &res);
 
-	case SIM_FACILITY_PC:
-		lock_type = "PC";
-		break;
+		// Drops the reference a pending would have released when freed
+		tcore_user_request_unref(ur);
+		return TCORE_RETURN_SUCCESS;
+	}
 
-	default:
-		break;
+	for (i = 0; i < G_N_ELEMENTS(sim_lock_facility); i++) {
+		if (sim_lock_facility[i].type == req_data->type) {
+			lock_type = sim_lock_facility[i].name;
+			break;
+		}
 	}
+	if (!lock_type)
+		return TCORE_RETURN_EINVAL;
+
+	pending = tcore_pending_new(o, 0);
 	cmd_str = g_strdup_printf("AT+XPINCNT =\"%s\"", lock_type);
 	req = tcore_at_request_new(cmd_str, "+XPINCNT:", TCORE_AT_SINGLELINE);
 
@@ -2908,10 +4326,6 @@ static TReturn s_read_file(CoreObject *o, UserRequest *ur)
 
 static TReturn s_update_file(CoreObject *o, UserRequest *ur)
 {
-	TcoreHal *hal;
-	TcoreATRequest *req;
-	TcorePending *pending = NULL;
-	char *cmd_str = NULL;
 	TReturn api_ret = TCORE_RETURN_SUCCESS;
 	char *encoded_data = NULL;
 	int encoded_len = 0;
@@ -2934,9 +4348,6 @@ static TReturn s_update_file(CoreObject *o, UserRequest *ur)
 
 	dbg(" Function entry ");
 
-	hal = tcore_object_get_hal(o);
-	pending = tcore_pending_new(o, 0);
-
 	if (!o || !ur) {
 		return TCORE_RETURN_EINVAL;
 	}
@@ -3014,27 +4425,22 @@ static TReturn s_update_file(CoreObject *o, UserRequest *ur)
 		api_ret = TCORE_RETURN_EINVAL;
 		break;
 	}
+	if (api_ret != TCORE_RETURN_SUCCESS) {
+		free(tmp);
+		return api_ret;
+	}
+
 	file_meta.file_id = ef;
 	dbg("file_meta.file_id: %d", file_meta.file_id);
 
 	trt = tcore_user_request_set_metainfo(ur, sizeof(struct s_sim_property), &file_meta);
 	dbg("trt[%d]", trt);
 
-	cmd_str = g_strdup_printf("AT+CRSM=%d,%d,%d,%d,%d,\"%s\"", cmd, ef, p1, p2, p3, encoded_data);
-	req = tcore_at_request_new(cmd_str, "+CRSM:", TCORE_AT_SINGLELINE);
-
-	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
-
-	tcore_pending_set_request_data(pending, 0, req);
-	tcore_pending_set_response_callback(pending, on_response_update_file, hal);
-	tcore_pending_link_user_request(pending, ur);
-	tcore_pending_set_send_callback(pending, on_confirmation_sim_message_send, NULL);
+	_sim_update_queue(o, ur, ef, cmd, p1, p2, p3, encoded_data);
 
-	tcore_hal_send_request(hal, pending);
 	if (NULL != encoded_data) {
 		g_free(encoded_data);
 	}
-	free(cmd_str);
 
 	if (tmp) {
 		free(tmp);
@@ -3046,41 +4452,41 @@ static TReturn s_update_file(CoreObject *o, UserRequest *ur)
 
 static TReturn s_transmit_apdu(CoreObject *o, UserRequest *ur)
 {
-	TcoreHal *hal = NULL;
-	TcoreATRequest *req = NULL;
-	TcorePending *pending = NULL;
-	char *cmd_str = NULL;
-	char *apdu = NULL;
-	int result = 0;
+	struct s_sim_apdu *apdu = NULL;
 	const struct treq_sim_transmit_apdu *req_data;
+	int ch;
 
 	dbg(" Function entry ");
 
-	hal = tcore_object_get_hal(o);
-	pending = tcore_pending_new(o, 0);
-	req_data = tcore_user_request_ref_data(ur, NULL);
-
 	if (!o || !ur)
 		return TCORE_RETURN_EINVAL;
 
-	apdu = (char *) malloc((2 * req_data->apdu_length) + 1);
-	memset(apdu, 0x00, (2 * req_data->apdu_length) + 1);
-	result = util_byte_to_hex((const char *) req_data->apdu, apdu, req_data->apdu_length);
+	apdu = _sim_apdu_ref(o);
+	req_data = tcore_user_request_ref_data(ur, NULL);
+	if (!apdu || !req_data || req_data->apdu_length < 4)
+		return TCORE_RETURN_EINVAL;
 
-	cmd_str = g_strdup_printf("AT+CSIM=%d,\"%s\"", req_data->apdu_length * 2, apdu);
+	ch = _sim_apdu_channel_of(req_data->apdu[0]);
+	if (ch < 0 || ch >= SIM_APDU_CHANNEL_MAX)
+		return TCORE_RETURN_EINVAL;
 
-	req = tcore_at_request_new(cmd_str, "+CSIM:", TCORE_AT_SINGLELINE);
+	_sim_stats_request(o, SIM_STATS_APDU, req_data->apdu_length);
 
-	dbg("cmd : %s, prefix(if any) :%s, cmd_len : %d", req->cmd, req->prefix, strlen(req->cmd));
+	if (req_data->apdu[1] == SIM_APDU_INS_MANAGE_CHANNEL) {
+		if (req_data->apdu[2] == 0x00) {
+			_sim_apdu_channel_open(o, ur, req_data->apdu[3]);
+			return TCORE_RETURN_SUCCESS;
+		}
+		// Close goes behind the APDUs already queued on the channel it names
+		if (req_data->apdu[3] != 0x00)
+			ch = req_data->apdu[3];
+		if (ch == 0 || ch >= SIM_APDU_CHANNEL_MAX)
+			return TCORE_RETURN_EINVAL;
+	}
 
-	tcore_pending_set_request_data(pending, 0, req);
-	tcore_pending_set_response_callback(pending, on_response_transmit_apdu, hal);
-	tcore_pending_link_user_request(pending, ur);
-	tcore_pending_set_send_callback(pending, on_confirmation_sim_message_send, NULL);
-	tcore_hal_send_request(hal, pending);
+	g_queue_push_tail(apdu->channel[ch].queue, ur);
+	_sim_apdu_channel_next(o, ch);
 
-	free(cmd_str);
-	free(apdu);
 	dbg(" Function exit");
 	return TCORE_RETURN_SUCCESS;
 }
@@ -3105,7 +4511,12 @@ gboolean s_sim_init(TcorePlugin *p, TcoreHal *h)
 {
 	CoreObject *o;
 	struct s_sim_property *file_meta = NULL;
+	struct tel_sim_ecc_list *ecc = NULL;
+	struct s_sim_ef_cache *cache = NULL;
+	struct s_sim_apdu *apdu = NULL;
+	struct s_sim_stats *stats = NULL;
 	GQueue *work_queue;
+	int ch;
 
 	dbg("entry");
 
@@ -3122,8 +4533,38 @@ gboolean s_sim_init(TcorePlugin *p, TcoreHal *h)
 	tcore_object_link_user_data(o, work_queue);
 
 	file_meta->first_recv_status = SIM_STATUS_UNKNOWN;
+	_sim_lock_reset(file_meta);
+	file_meta->identity_same = -1;
 	tcore_sim_link_userdata(o, file_meta);
 
+	ecc = calloc(sizeof(struct tel_sim_ecc_list), 1);
+	tcore_plugin_link_property(p, "SIMECC", ecc);
+
+	cache = calloc(sizeof(struct s_sim_ef_cache), 1);
+	if (cache) {
+		cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		cache->fcp = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+		cache->updates = g_hash_table_new(g_str_hash, g_str_equal);
+		tcore_plugin_link_property(p, "SIMEFCACHE", cache);
+	}
+
+	apdu = calloc(sizeof(struct s_sim_apdu), 1);
+	if (apdu) {
+		for (ch = 0; ch < SIM_APDU_CHANNEL_MAX; ch++) {
+			apdu->channel[ch].queue = g_queue_new();
+			apdu->channel[ch].opened = (ch == 0);
+			apdu->channel[ch].session_id = -1;
+		}
+		tcore_plugin_link_property(p, "SIMAPDU", apdu);
+	}
+
+	stats = calloc(sizeof(struct s_sim_stats), 1);
+	if (stats) {
+		stats->ef = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+		stats->log_id = g_timeout_add_seconds(SIM_STATS_LOG_INTERVAL, _sim_stats_on_log, o);
+		tcore_plugin_link_property(p, "SIMSTATS", stats);
+	}
+
 	tcore_object_add_callback(o, "+XLOCK", on_event_facility_lock_status, NULL);
 	tcore_object_add_callback(o, "+XSIM", on_event_pin_status, NULL);
 
@@ -3134,8 +4575,50 @@ gboolean s_sim_init(TcorePlugin *p, TcoreHal *h)
 void s_sim_exit(TcorePlugin *p)
 {
 	CoreObject *o;
+	struct tel_sim_ecc_list *ecc = NULL;
+	struct s_sim_ef_cache *cache = NULL;
+	struct s_sim_apdu *apdu = NULL;
+	struct s_sim_stats *stats = NULL;
+	int ch;
 
 	o = tcore_plugin_ref_core_object(p, "sim");
+
+	// Updates still waiting for their window are answered before the cache goes
+	if (o)
+		_sim_update_drop(o);
+
+	ecc = tcore_plugin_ref_property(p, "SIMECC");
+	if (ecc)
+		free(ecc);
+
+	cache = tcore_plugin_ref_property(p, "SIMEFCACHE");
+	if (cache) {
+		if (cache->flush_id) {
+			g_source_remove(cache->flush_id);
+			_sim_ef_cache_write(cache);
+		}
+		g_hash_table_destroy(cache->entries);
+		g_hash_table_destroy(cache->fcp);
+		g_hash_table_destroy(cache->updates);
+		free(cache);
+	}
+
+	apdu = tcore_plugin_ref_property(p, "SIMAPDU");
+	if (apdu) {
+		for (ch = 0; ch < SIM_APDU_CHANNEL_MAX; ch++)
+			g_queue_free(apdu->channel[ch].queue);
+		free(apdu);
+	}
+
+	stats = tcore_plugin_ref_property(p, "SIMSTATS");
+	if (stats) {
+		g_source_remove(stats->log_id);
+		if (o)
+			_sim_stats_on_log(o);
+		g_hash_table_destroy(stats->ef);
+		free(stats);
+	}
+
 	if (!o)
 		return;
 	tcore_sim_free(o);
@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
 
 #include <glib.h>
 
@@ -81,6 +82,17 @@
 #define AT_MEMORY_AVAILABLE             0       /* Memory Available */
 #define AT_MEMORY_FULL                  1       /* Memory Full */
 
+/*=============================================================
+                            EF-SMS Status Byte
+==============================================================*/
+#define SMS_EFSMS_STATUS_FREE                   0x00    /* Free space */
+#define SMS_EFSMS_STATUS_READ                   0x01    /* Received, read */
+#define SMS_EFSMS_STATUS_UNREAD                 0x03    /* Received, to be read */
+#define SMS_EFSMS_STATUS_SENT                   0x05    /* Sent, no status report requested */
+#define SMS_EFSMS_STATUS_UNSENT                 0x07    /* To be sent */
+#define SMS_EFSMS_STATUS_DELIVERY_UNCONFIRMED   0x0D    /* Sent, status report requested but not received */
+#define SMS_EFSMS_STATUS_DELIVERED              0x1D    /* Sent, status report received */
+
 /*=============================================================
         SIM CRSM SW1 and Sw2 Error definitions */
 
@@ -114,9 +126,109 @@
 ==============================================================*/
 #define SMS_SWAPBYTES16(x) (((x) & 0xffff0000) | (((x) & 0x0000ff00) >> 8) | (((x) & 0x000000ff) << 8))
 
+/*=============================================================
+                            CB Configuration
+==============================================================*/
+#define SMS_CB_DISABLED                 0       /* cbEnabled: CBS disabled */
+#define SMS_CB_ENABLED_SOME             1       /* cbEnabled: Only selected message ids */
+#define SMS_CB_ENABLED_ALL              2       /* cbEnabled: All message ids */
+
+#define SMS_CB_MSG_ID_STR_LEN           12      /* "65535-65535," */
+
+/*=============================================================
+                            EF-SMSP Cache
+==============================================================*/
+#define SMS_SMSP_CACHE_RECORD_MAX       10      /* EF-SMSP records kept decoded */
+#define SMS_SIM_IDENTITY_LEN            18      /* IMSI: PLMN (6) + MSIN (10) + NULL */
+
+/*=============================================================
+                            Delivery Report Index
+==============================================================*/
+#define SMS_TP_MR_MAX                   256     /* TP-MR is a single octet */
+#define SMS_TP_ADDR_LEN_MAX             10      /* TP-DA / TP-RA semi-octets, without length and TON */
+#define SMS_DR_EXPIRY_SEC               (3 * 24 * 60 * 60)      /* Reports later than this are not expected */
+#define SMS_DR_EXPIRY_CHECK_SEC         (60 * 60)       /* Sweep interval while reports are awaited */
+
+#define SMS_TP_MTI_MASK                 0x03
+#define SMS_TP_MTI_SUBMIT               0x01
+#define SMS_TP_MTI_STATUS_REPORT        0x02
+#define SMS_TP_SRR                      0x20    /* SMS-SUBMIT: status report requested */
+#define SMS_TP_ST_TEMPORARY_ERROR       0x20    /* TP-ST 0x20..0x3F: SC still trying */
+#define SMS_TP_ST_PERMANENT_ERROR       0x40
+
+/*=============================================================
+                            Plugin Property
+==============================================================*/
+struct s_sms_cb_range {
+	unsigned short from_id;
+	unsigned short to_id;
+};
+
+struct s_sms_cb_config {
+	gboolean b_valid; /**< Configuration below is active in the modem */
+	int cb_enabled; /**< SMS_CB_DISABLED / SMS_CB_ENABLED_SOME / SMS_CB_ENABLED_ALL */
+	int range_count; /**< Number of sorted, non-overlapping ranges */
+	struct s_sms_cb_range ranges[SMS_GSM_SMS_CBMI_LIST_SIZE_MAX];
+};
+
+struct s_sms_efsms_record {
+	gboolean b_status_valid; /**< status reflects the SIM */
+	unsigned char status; /**< EF-SMS status byte */
+};
+
+struct s_sms_smsp_cache {
+	gboolean b_meta_valid; /**< record_count and record_len reflect the SIM */
+	int record_count;
+	int record_len;
+	gboolean b_params_valid[SMS_SMSP_CACHE_RECORD_MAX];
+	struct telephony_sms_Params params[SMS_SMSP_CACHE_RECORD_MAX]; /**< Decoded records, by TAPI index */
+};
+
+struct s_sms_slot_map {
+	gboolean b_valid; /**< Map reflects SIM storage */
+	int total_count; /**< Number of SMS slots on the SIM */
+	int used_count;
+	unsigned char used[(SMS_GSM_SMS_MSG_NUM_MAX + 7) / 8]; /**< Bit per slot, by TAPI index */
+};
+
+struct s_sms_dr_entry {
+	gboolean b_valid;
+	unsigned int seq; /**< Plugin send sequence number of the originating request */
+	time_t sent_at;
+	int addr_len; /**< Octets in addr */
+	unsigned char addr[SMS_TP_ADDR_LEN_MAX]; /**< TP-DA digits, compared against TP-RA */
+};
+
+struct s_sms_property {
+	char sim_identity[SMS_SIM_IDENTITY_LEN]; /**< IMSI of the SIM the caches below belong to */
+	struct s_sms_cb_config cb_config; /**< Last CB configuration accepted by the modem */
+	struct s_sms_smsp_cache smsp; /**< EF-SMSP metadata and records */
+	struct s_sms_slot_map slots; /**< SIM SMS storage occupancy */
+	int pda_mem_status; /**< Last AT+XTESM value accepted by the modem, -1 if unknown */
+	unsigned int dr_seq; /**< Last send sequence number handed out */
+	struct s_sms_dr_entry dr_index[SMS_TP_MR_MAX]; /**< Sent messages awaiting a status report, by TP-MR */
+	guint dr_expiry_id; /**< Sweep timer, 0 when nothing is awaited */
+	gboolean b_efsms_synced; /**< Status of every EF-SMS record is known */
+	struct s_sms_efsms_record efsms[SMS_GSM_SMS_MSG_NUM_MAX]; /**< EF-SMS mirror, by TAPI index */
+};
+
+/* One set_msg_status request, possibly covering several records */
+struct s_sms_status_batch {
+	int outstanding; /**< Records still waiting for the SIM */
+	int result;
+};
+
+struct s_sms_status_update {
+	struct s_sms_status_batch *batch;
+	int index; /**< TAPI index (EF-SMS record number - 1) */
+	unsigned char status; /**< EF-SMS status byte to be written */
+};
+
 void print_glib_list_elem(gpointer data, gpointer user_data);
 
 static void on_response_class2_read_msg(TcorePending *pending, int data_len, const void *data, void *user_data);
+static void on_response_get_stored_msg_cnt(TcorePending *pending, int data_len, const void *data, void *user_data);
+static void _sync_sim_storage(CoreObject *o);
 
 
 gboolean util_byte_to_hex(const char *byte_pdu, char *hex_pdu, int num_bytes);
@@ -167,6 +279,481 @@ static void util_sms_free_memory(void *sms_ptr)
 	dbg("Exit");
 }
 
+static struct s_sms_property *util_sms_ref_property(CoreObject *o)
+{
+	return tcore_plugin_ref_property(tcore_object_ref_plugin(o), "SMSPROPERTY");
+}
+
+/* Builds a canonical CB configuration: selected ranges sorted and merged */
+static void util_sms_normalize_cb_config(const struct treq_sms_set_cb_config *req, struct s_sms_cb_config *cfg)
+{
+	struct s_sms_cb_range range;
+	int i = 0, j = 0, count = 0;
+
+	memset(cfg, 0x00, sizeof(struct s_sms_cb_config));
+	cfg->cb_enabled = req->cbEnabled;
+
+	if (cfg->cb_enabled != SMS_CB_ENABLED_SOME)
+		return;
+
+	for (i = 0; (i < req->msgIdRangeCount) && (i < SMS_GSM_SMS_CBMI_LIST_SIZE_MAX); i++) {
+		if (req->msgIDs[i].net3gpp.selected == FALSE)
+			continue;
+
+		if (req->msgIDs[i].net3gpp.fromMsgId <= req->msgIDs[i].net3gpp.toMsgId) {
+			range.from_id = req->msgIDs[i].net3gpp.fromMsgId;
+			range.to_id = req->msgIDs[i].net3gpp.toMsgId;
+		} else {
+			range.from_id = req->msgIDs[i].net3gpp.toMsgId;
+			range.to_id = req->msgIDs[i].net3gpp.fromMsgId;
+		}
+
+		/* Insertion sort by from_id */
+		for (j = count; (j > 0) && (cfg->ranges[j - 1].from_id > range.from_id); j--)
+			cfg->ranges[j] = cfg->ranges[j - 1];
+		cfg->ranges[j] = range;
+		count++;
+	}
+
+	/* Merge overlapping and adjacent ranges */
+	cfg->range_count = 0;
+	for (i = 0; i < count; i++) {
+		if ((cfg->range_count > 0)
+			&& ((int) cfg->ranges[i].from_id <= (int) cfg->ranges[cfg->range_count - 1].to_id + 1)) {
+			if (cfg->ranges[i].to_id > cfg->ranges[cfg->range_count - 1].to_id)
+				cfg->ranges[cfg->range_count - 1].to_id = cfg->ranges[i].to_id;
+		} else {
+			cfg->ranges[cfg->range_count++] = cfg->ranges[i];
+		}
+	}
+
+	if (cfg->range_count == 0) {
+		dbg("No message id selected. Disabling CBS");
+		cfg->cb_enabled = SMS_CB_DISABLED;
+	}
+}
+
+static gboolean util_sms_cb_config_equal(const struct s_sms_cb_config *a, const struct s_sms_cb_config *b)
+{
+	if (a->cb_enabled != b->cb_enabled || a->range_count != b->range_count)
+		return FALSE;
+
+	return (memcmp(a->ranges, b->ranges, a->range_count * sizeof(struct s_sms_cb_range)) == 0);
+}
+
+/* AT+CSCB=[<mode>[,<mids>]] with <mids> as "from-to" ranges, e.g. "0,50-60,4352" */
+static gchar *util_sms_encode_cb_config(const struct s_sms_cb_config *cfg)
+{
+	GString *cmd = NULL;
+	int i = 0;
+
+	if (cfg->cb_enabled == SMS_CB_ENABLED_ALL)
+		return g_strdup("AT+CSCB=1");   /* No message id rejected */
+	else if (cfg->cb_enabled != SMS_CB_ENABLED_SOME)
+		return g_strdup("AT+CSCB=0");   /* No message id accepted */
+
+	cmd = g_string_sized_new(strlen("AT+CSCB=0,\"\"") + (cfg->range_count * SMS_CB_MSG_ID_STR_LEN) + 1);
+	g_string_append(cmd, "AT+CSCB=0,\"");
+
+	for (i = 0; i < cfg->range_count; i++) {
+		if (i > 0)
+			g_string_append_c(cmd, ',');
+
+		if (cfg->ranges[i].from_id == cfg->ranges[i].to_id)
+			g_string_append_printf(cmd, "%u", cfg->ranges[i].from_id);
+		else
+			g_string_append_printf(cmd, "%u-%u", cfg->ranges[i].from_id, cfg->ranges[i].to_id);
+	}
+	g_string_append_c(cmd, '"');
+
+	return g_string_free(cmd, FALSE);
+}
+
+static unsigned char util_sms_encode_efsms_status(enum telephony_sms_MsgStatus msg_status)
+{
+	switch (msg_status) {
+	case SMS_STATUS_READ:
+		return SMS_EFSMS_STATUS_READ;
+
+	case SMS_STATUS_UNREAD:
+		return SMS_EFSMS_STATUS_UNREAD;
+
+	case SMS_STATUS_UNSENT:
+		return SMS_EFSMS_STATUS_UNSENT;
+
+	case SMS_STATUS_SENT:
+		return SMS_EFSMS_STATUS_SENT;
+
+	case SMS_STATUS_DELIVERED:
+		return SMS_EFSMS_STATUS_DELIVERED;
+
+	case SMS_STATUS_DELIVERY_UNCONFIRMED:
+		return SMS_EFSMS_STATUS_DELIVERY_UNCONFIRMED;
+
+	case SMS_STATUS_MESSAGE_REPLACED:
+	case SMS_STATUS_RESERVED:
+	default:
+		return SMS_EFSMS_STATUS_UNREAD;
+	}
+}
+
+static unsigned char util_sms_at_stat_to_efsms_status(int at_stat)
+{
+	switch (at_stat) {
+	case AT_REC_READ:
+		return SMS_EFSMS_STATUS_READ;
+
+	case AT_STO_UNSENT:
+		return SMS_EFSMS_STATUS_UNSENT;
+
+	case AT_STO_SENT:
+		return SMS_EFSMS_STATUS_SENT;
+
+	case AT_REC_UNREAD:
+	default:
+		return SMS_EFSMS_STATUS_UNREAD;
+	}
+}
+
+static struct s_sms_efsms_record *util_sms_ref_efsms(CoreObject *o, int index)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+
+	if (NULL == sp || index < 0 || index >= SMS_GSM_SMS_MSG_NUM_MAX)
+		return NULL;
+
+	return &sp->efsms[index];
+}
+
+/* Only the status byte is mirrored, the rest of a record is always read from the SIM */
+static void util_sms_efsms_set_status(CoreObject *o, int index, unsigned char status)
+{
+	struct s_sms_efsms_record *rec = util_sms_ref_efsms(o, index);
+
+	if (NULL == rec)
+		return;
+
+	rec->b_status_valid = TRUE;
+	rec->status = status;
+}
+
+/* Marks a record as free space after deletion, index -1 frees every record */
+static void util_sms_efsms_free(CoreObject *o, int index)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+	struct s_sms_efsms_record *rec = NULL;
+	int i = 0;
+
+	if (NULL == sp)
+		return;
+
+	if (index == -1) {
+		memset(sp->efsms, 0x00, sizeof(sp->efsms));
+		for (i = 0; i < SMS_GSM_SMS_MSG_NUM_MAX; i++)
+			sp->efsms[i].b_status_valid = TRUE;
+		sp->b_efsms_synced = TRUE;
+		return;
+	}
+
+	rec = util_sms_ref_efsms(o, index);
+	if (rec) {
+		memset(rec, 0x00, sizeof(struct s_sms_efsms_record));
+		rec->b_status_valid = TRUE;
+	}
+}
+
+static void util_sms_slot_set(CoreObject *o, int index, gboolean used)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+	struct s_sms_slot_map *map = NULL;
+	unsigned char mask = 0;
+
+	if (NULL == sp || FALSE == sp->slots.b_valid)
+		return;
+
+	map = &sp->slots;
+	if (index < 0 || index >= map->total_count) {
+		dbg("index [%d] out of storage, resync needed", index);
+		map->b_valid = FALSE;
+		return;
+	}
+
+	mask = 1 << (index % 8);
+	if (used && !(map->used[index / 8] & mask)) {
+		map->used[index / 8] |= mask;
+		map->used_count++;
+	} else if (!used && (map->used[index / 8] & mask)) {
+		map->used[index / 8] &= ~mask;
+		map->used_count--;
+	}
+
+	dbg("slot [%d] %s, used: [%d/%d]", index, used ? "used" : "free", map->used_count, map->total_count);
+}
+
+static gboolean util_sms_slot_is_used(const struct s_sms_slot_map *map, int index)
+{
+	return (map->used[index / 8] & (1 << (index % 8))) ? TRUE : FALSE;
+}
+
+/* Restarts the map with every slot free */
+static void util_sms_slot_reset(CoreObject *o, int total_count)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+
+	if (NULL == sp)
+		return;
+
+	if (total_count > SMS_GSM_SMS_MSG_NUM_MAX)
+		total_count = SMS_GSM_SMS_MSG_NUM_MAX;
+
+	memset(&sp->slots, 0x00, sizeof(struct s_sms_slot_map));
+	sp->slots.total_count = total_count;
+	sp->slots.b_valid = (total_count > 0) ? TRUE : FALSE;
+}
+
+/* Marks a slot free after deletion, index -1 frees every slot */
+static void util_sms_slot_clear(CoreObject *o, int index)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+
+	if (NULL == sp || FALSE == sp->slots.b_valid)
+		return;
+
+	if (index == -1)
+		util_sms_slot_reset(o, sp->slots.total_count);
+	else
+		util_sms_slot_set(o, index, FALSE);
+}
+
+/* Resynchronises the mirror from an AT+CMGL=4 listing, records not listed are free */
+static void util_sms_efsms_sync(CoreObject *o, int total_count, const int *at_index, const int *at_stat, int count)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+	struct s_sms_efsms_record *rec = NULL;
+	gboolean listed[SMS_GSM_SMS_MSG_NUM_MAX];
+	unsigned char status = 0;
+	int i = 0, index = 0;
+
+	if (NULL == sp)
+		return;
+
+	if (total_count > SMS_GSM_SMS_MSG_NUM_MAX)
+		total_count = SMS_GSM_SMS_MSG_NUM_MAX;
+
+	memset(listed, 0x00, sizeof(listed));
+	util_sms_slot_reset(o, total_count);
+
+	for (i = 0; i < count; i++) {
+		index = at_index[i] - 1; // IMC index is one ahead of TAPI
+		rec = util_sms_ref_efsms(o, index);
+		if (NULL == rec)
+			continue;
+
+		listed[index] = TRUE;
+		util_sms_slot_set(o, index, TRUE);
+		status = util_sms_at_stat_to_efsms_status(at_stat[i]);
+
+		// +CMGL does not tell delivery report states apart, keep the finer one we know
+		if (rec->b_status_valid && (rec->status & 0x07) == (status & 0x07))
+			continue;
+
+		util_sms_efsms_set_status(o, index, status);
+	}
+
+	for (i = 0; i < total_count; i++) {
+		if (FALSE == listed[i])
+			util_sms_efsms_free(o, i);
+	}
+
+	sp->b_efsms_synced = TRUE;
+}
+
+/* Completes one record of a set_msg_status request, the response goes out with the last one */
+static void util_sms_status_update_done(CoreObject *o, UserRequest *ur, struct s_sms_status_update *update, gboolean success)
+{
+	struct s_sms_status_batch *batch = update->batch;
+	struct tresp_sms_set_msg_status respMsgStatus = {0, };
+
+	dbg("index: [%d], status: [0x%02x], success: [%d]", update->index, update->status, success);
+
+	if (success)
+		util_sms_efsms_set_status(o, update->index, update->status);
+	else
+		batch->result = SMS_DEVICE_FAILURE;
+
+	g_free(update);
+
+	batch->outstanding--;
+	if (batch->outstanding > 0)
+		return;
+
+	respMsgStatus.result = batch->result;
+	g_free(batch);
+
+	if (ur)
+		tcore_user_request_send_response(ur, TRESP_SMS_SET_MSG_STATUS, sizeof(struct tresp_sms_set_msg_status), &respMsgStatus);
+}
+
+/* Extracts TP-DA of an SMS-SUBMIT asking for a status report, FALSE when no report will come */
+static gboolean util_sms_dr_prepare(const unsigned char *tpdu, int tpdu_len, struct s_sms_dr_entry *entry)
+{
+	int addr_len = 0;
+
+	if (tpdu_len < 4
+		|| (tpdu[0] & SMS_TP_MTI_MASK) != SMS_TP_MTI_SUBMIT
+		|| !(tpdu[0] & SMS_TP_SRR))
+		return FALSE;
+
+	// [FO][MR][DA length in digits][TON/NPI][DA ...]
+	addr_len = (tpdu[2] + 1) / 2;
+	if (addr_len > SMS_TP_ADDR_LEN_MAX || 4 + addr_len > tpdu_len)
+		return FALSE;
+
+	memset(entry, 0x00, sizeof(struct s_sms_dr_entry));
+	entry->addr_len = addr_len;
+	memcpy(entry->addr, &tpdu[4], addr_len);
+
+	return TRUE;
+}
+
+/* Drops report waits past SMS_DR_EXPIRY_SEC, stops once nothing is awaited */
+static gboolean util_sms_dr_on_expiry(gpointer user_data)
+{
+	struct s_sms_property *sp = util_sms_ref_property(user_data);
+	time_t now = time(NULL);
+	int i = 0, awaited = 0;
+
+	if (NULL == sp)
+		return FALSE;
+
+	for (i = 0; i < SMS_TP_MR_MAX; i++) {
+		if (FALSE == sp->dr_index[i].b_valid)
+			continue;
+
+		if ((now - sp->dr_index[i].sent_at) > SMS_DR_EXPIRY_SEC) {
+			dbg("TP-MR [%d] expired, #%u", i, sp->dr_index[i].seq);
+			sp->dr_index[i].b_valid = FALSE;
+			continue;
+		}
+		awaited++;
+	}
+
+	if (awaited == 0) {
+		sp->dr_expiry_id = 0;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Records a sent message under its TP-MR, entry NULL when it asked for no status report */
+static void util_sms_dr_add(CoreObject *o, int msg_ref, const struct s_sms_dr_entry *entry)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+	struct s_sms_dr_entry *slot = NULL;
+
+	if (NULL == sp || msg_ref < 0 || msg_ref >= SMS_TP_MR_MAX)
+		return;
+
+	slot = &sp->dr_index[msg_ref];
+	if (slot->b_valid) {
+		dbg("TP-MR [%d] reused, dropping report wait for #%u", msg_ref, slot->seq);
+		slot->b_valid = FALSE;
+	}
+
+	if (NULL == entry)
+		return;
+
+	memcpy(slot, entry, sizeof(struct s_sms_dr_entry));
+	slot->b_valid = TRUE;
+	slot->seq = ++sp->dr_seq;
+	slot->sent_at = time(NULL);
+
+	if (sp->dr_expiry_id == 0)
+		sp->dr_expiry_id = g_timeout_add_seconds(SMS_DR_EXPIRY_CHECK_SEC, util_sms_dr_on_expiry, o);
+
+	dbg("Waiting status report: TP-MR [%d], #%u", msg_ref, slot->seq);
+}
+
+/* Matches an SMS-STATUS-REPORT TPDU against the messages sent, in constant time */
+static void util_sms_dr_match(CoreObject *o, const unsigned char *tpdu, int tpdu_len)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+	struct s_sms_dr_entry *slot = NULL;
+	int msg_ref = 0, addr_len = 0, st_offset = 0;
+	unsigned char st = 0;
+	time_t now = time(NULL);
+
+	if (NULL == sp || tpdu_len < 4 || (tpdu[0] & SMS_TP_MTI_MASK) != SMS_TP_MTI_STATUS_REPORT)
+		return;
+
+	// [FO][MR][RA length in digits][TON/NPI][RA ...][SCTS 7][DT 7][ST]
+	msg_ref = tpdu[1];
+	addr_len = (tpdu[2] + 1) / 2;
+	st_offset = 4 + addr_len + 7 + 7;
+	if (st_offset >= tpdu_len) {
+		dbg("Truncated status report");
+		return;
+	}
+	st = tpdu[st_offset];
+
+	slot = &sp->dr_index[msg_ref];
+	if (slot->b_valid && (now - slot->sent_at) > SMS_DR_EXPIRY_SEC) {
+		dbg("TP-MR [%d] expired, #%u", msg_ref, slot->seq);
+		slot->b_valid = FALSE;
+	}
+
+	if (FALSE == slot->b_valid
+		|| slot->addr_len != addr_len
+		|| memcmp(slot->addr, &tpdu[4], addr_len) != 0) {
+		dbg("No sent message for TP-MR [%d], TP-ST [0x%02x]", msg_ref, st);
+		return;
+	}
+
+	dbg("Status report for #%u: TP-MR [%d], TP-ST [0x%02x], after [%ld] sec", slot->seq, msg_ref, st, (long) (now - slot->sent_at));
+
+	// SC keeps trying on temporary errors, more reports follow
+	if (st < SMS_TP_ST_TEMPORARY_ERROR || st >= SMS_TP_ST_PERMANENT_ERROR)
+		slot->b_valid = FALSE;
+}
+
+/* Forgets everything read from EF-SMSP, index -1 drops the file metadata as well */
+static void util_sms_smsp_invalidate(CoreObject *o, int index)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+
+	if (NULL == sp)
+		return;
+
+	if (index == -1) {
+		memset(&sp->smsp, 0x00, sizeof(struct s_sms_smsp_cache));
+		return;
+	}
+
+	if (index >= 0 && index < SMS_SMSP_CACHE_RECORD_MAX)
+		sp->smsp.b_params_valid[index] = FALSE;
+}
+
+/* Drops all SIM backed state, the SIM went away, was refreshed or swapped */
+static void util_sms_sim_invalidate(CoreObject *o)
+{
+	struct s_sms_property *sp = util_sms_ref_property(o);
+
+	if (NULL == sp)
+		return;
+
+	dbg("Invalidating SIM caches");
+
+	util_sms_smsp_invalidate(o, -1);
+
+	memset(sp->efsms, 0x00, sizeof(sp->efsms));
+	sp->b_efsms_synced = FALSE;
+
+	memset(&sp->slots, 0x00, sizeof(struct s_sms_slot_map));
+
+	// AT+XTESM has to be sent again for the new card
+	sp->pda_mem_status = -1;
+}
 
 static int util_sms_decode_smsParameters(unsigned char *incoming, unsigned int length, struct telephony_sms_Params *params)
 {
@@ -332,6 +919,97 @@ static int util_sms_decode_smsParameters(unsigned char *incoming, unsigned int l
 /*=============================================================
                             Notifications
 ==============================================================*/
+static enum tcore_hook_return on_hook_sim_status(Server *s, CoreObject *source, enum tcore_notification_command command,
+											   unsigned int data_len, void *data, void *user_data)
+{
+	const struct tnoti_sim_status *sim = data;
+	CoreObject *o = user_data;
+	struct s_sms_property *sp = util_sms_ref_property(o);
+	struct tel_sim_imsi *imsi = NULL;
+	char identity[SMS_SIM_IDENTITY_LEN] = {0, };
+
+	if (NULL == sp)
+		return TCORE_HOOK_RETURN_CONTINUE;
+
+	dbg("SIM status: [%d]", sim->sim_status);
+
+	// The modem drops its CB configuration when the SIM is (re)initialised
+	sp->cb_config.b_valid = FALSE;
+
+	if (sim->sim_status != SIM_STATUS_INIT_COMPLETED) {
+		// Card removed, locked or re-initialised (e.g. SAT REFRESH)
+		util_sms_sim_invalidate(o);
+		return TCORE_HOOK_RETURN_CONTINUE;
+	}
+
+	imsi = tcore_sim_get_imsi(source);
+	if (imsi) {
+		snprintf(identity, sizeof(identity), "%s%s", imsi->plmn, imsi->msin);
+		free(imsi);
+	}
+
+	if (sp->sim_identity[0] != '\0' && strcmp(identity, sp->sim_identity) != 0) {
+		dbg("SIM identity changed");
+		util_sms_sim_invalidate(o);
+	}
+	memcpy(sp->sim_identity, identity, SMS_SIM_IDENTITY_LEN);
+
+	// Storage read at SMS-ready is kept; rebuild only what was dropped above
+	if (FALSE == sp->slots.b_valid && tcore_sms_get_ready_status(o))
+		_sync_sim_storage(o);
+
+	return TCORE_HOOK_RETURN_CONTINUE;
+}
+
+/* A modem coming up again runs with its default configuration */
+static enum tcore_hook_return on_hook_modem_power(Server *s, CoreObject *source, enum tcore_notification_command command,
+												unsigned int data_len, void *data, void *user_data)
+{
+	const struct tnoti_modem_power *power = data;
+	struct s_sms_property *sp = util_sms_ref_property(user_data);
+
+	dbg("Modem power state: [%d]", power->state);
+
+	if (sp)
+		sp->cb_config.b_valid = FALSE;
+
+	return TCORE_HOOK_RETURN_CONTINUE;
+}
+
+/* Rebuilds slot map and EF-SMS status from AT+CPMS / AT+CMGL, no user request involved */
+static void _sync_sim_storage(CoreObject *o)
+{
+	gchar *cmd_str = NULL;
+	TcoreATRequest *atreq = NULL;
+	TcorePending *pending = NULL;
+
+	dbg("Entry");
+
+	cmd_str = g_strdup_printf("AT+CPMS=\"SM\"");
+	pending = tcore_pending_new(o, 0);
+	atreq = tcore_at_request_new((const char *) cmd_str, "+CPMS", TCORE_AT_SINGLELINE);
+
+	if (NULL == cmd_str || NULL == atreq || NULL == pending) {
+		err("Out of memory. Unable to proceed");
+
+		// free memory we own
+		g_free(cmd_str);
+		util_sms_free_memory(atreq);
+		util_sms_free_memory(pending);
+		return;
+	}
+
+	tcore_pending_set_request_data(pending, 0, atreq);
+	tcore_pending_set_response_callback(pending, on_response_get_stored_msg_cnt, NULL);
+	tcore_pending_link_user_request(pending, NULL);
+	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
+	tcore_hal_send_request(tcore_object_get_hal(o), pending);
+
+	g_free(cmd_str);
+
+	dbg("Exit");
+}
+
 static gboolean on_event_sms_ready_status(CoreObject *o, const void *event_info, void *user_data)
 {
 	struct tnoti_sms_ready_status readyStatusInfo = {0, };
@@ -371,6 +1049,8 @@ static gboolean on_event_sms_ready_status(CoreObject *o, const void *event_info,
 		dbg("SMS Ready status = [%s]", readyStatusInfo.status ? "TRUE" : "FALSE");
 		rtn = tcore_server_send_notification(tcore_plugin_ref_server(tcore_object_ref_plugin(o)), o, TNOTI_SMS_DEVICE_READY, sizeof(struct tnoti_sms_ready_status), &readyStatusInfo);
 		dbg(" Return value [%d]", rtn);
+
+		_sync_sim_storage(o);
 	} else {
 		readyStatusInfo.status = SMS_DEVICE_NOT_READY;
 	}
@@ -386,8 +1066,8 @@ static gboolean on_event_class2_sms_incom_msg(CoreObject *obj, const void *event
 	// +CMTI: <mem>,<index>
 
 	GSList *tokens = NULL, *lines = NULL;
-	char *line = NULL, *cmd_str = NULL;
-	int index = 0, mem_type = 0;
+	char *line = NULL, *cmd_str = NULL, *mem = NULL;
+	int index = 0;
 	TcoreHal *hal = NULL;
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
@@ -405,9 +1085,15 @@ static gboolean on_event_class2_sms_incom_msg(CoreObject *obj, const void *event
 	}
 
 	tokens = tcore_at_tok_new(line); /* Split Line 1 into tokens */
-	mem_type = atoi(g_slist_nth_data(tokens, 0));       // Type of Memory stored
+	if (g_slist_nth_data(tokens, 0))
+		mem = util_removeQuotes(g_slist_nth_data(tokens, 0)); // Type of Memory stored
 	index = atoi((char *) g_slist_nth_data(tokens, 1));
 
+	// Only the SIM storage is tracked in the slot map
+	if (g_strcmp0(mem, "SM") == 0)
+		util_sms_slot_set(obj, index - 1, TRUE); // IMC index is one ahead of TAPI
+	free(mem);
+
 	hal = tcore_object_get_hal(obj);
 	if (NULL == hal) {
 		err("NULL input. Unable to proceed");
@@ -525,6 +1211,9 @@ static gboolean on_event_sms_incom_msg(CoreObject *o, const void *event_info, vo
 	util_hex_dump("      ", sca_length, gsmMsgInfo.msgInfo.sca);
 	util_hex_dump("      ", gsmMsgInfo.msgInfo.msgLength, gsmMsgInfo.msgInfo.tpduData);
 
+	if (no_of_tokens == 1) // +CDS
+		util_sms_dr_match(o, gsmMsgInfo.msgInfo.tpduData, gsmMsgInfo.msgInfo.msgLength);
+
 	rtn = tcore_server_send_notification(tcore_plugin_ref_server(tcore_object_ref_plugin(o)), o, TNOTI_SMS_INCOM_MSG, sizeof(struct tnoti_sms_umts_msg), &gsmMsgInfo);
 
 	if (tokens)
@@ -661,10 +1350,12 @@ static void on_response_sms_delete_msg(TcorePending *p, int data_len, const void
 		dbg("Response OK");
 		delMsgInfo.index = index;
 		delMsgInfo.result = SMS_SENDSMS_SUCCESS;
+		util_sms_efsms_free(tcore_pending_ref_core_object(p), index);
+		util_sms_slot_clear(tcore_pending_ref_core_object(p), index);
 	} else {
 		dbg("Response NOK");
 		delMsgInfo.index = index;
-		delMsgInfo.result = SMS_DEVICE_FAILURE;
+		delMsgInfo.result = util_at_error_sms_result(atResp->final_response);
 	}
 
 	rtn = tcore_user_request_send_response(ur, TRESP_SMS_DELETE_MSG, sizeof(struct tresp_sms_delete_msg), &delMsgInfo);
@@ -681,6 +1372,7 @@ static void on_response_sms_save_msg(TcorePending *p, int data_len, const void *
 	char *line = NULL;
 	char *pResp = NULL;
 	int rtn = -1;
+	unsigned char status = GPOINTER_TO_UINT(user_data); /* EF-SMS status byte as written */
 
 	ur = tcore_pending_ref_user_request(p);
 	if (atResp->success) {
@@ -693,6 +1385,8 @@ static void on_response_sms_save_msg(TcorePending *p, int data_len, const void *
 				dbg("0: %s", pResp);
 				saveMsgInfo.index = (atoi(pResp) - 1); /* IMC index starts from 1 */
 				saveMsgInfo.result = SMS_SENDSMS_SUCCESS;
+				util_sms_slot_set(tcore_pending_ref_core_object(p), saveMsgInfo.index, TRUE);
+				util_sms_efsms_set_status(tcore_pending_ref_core_object(p), saveMsgInfo.index, status);
 			} else {
 				dbg("No Tokens");
 				saveMsgInfo.index = -1;
@@ -703,7 +1397,7 @@ static void on_response_sms_save_msg(TcorePending *p, int data_len, const void *
 	} else {
 		dbg("Response NOK");
 		saveMsgInfo.index = -1;
-		saveMsgInfo.result = SMS_DEVICE_FAILURE;
+		saveMsgInfo.result = util_at_error_sms_result(atResp->final_response);
 	}
 
 	rtn = tcore_user_request_send_response(ur, TRESP_SMS_SAVE_MSG, sizeof(struct tresp_sms_save_msg), &saveMsgInfo);
@@ -716,6 +1410,7 @@ static void on_response_send_umts_msg(TcorePending *pending, int data_len, const
 	const TcoreATResponse *at_response = data;
 	struct tresp_sms_send_umts_msg resp_umts;
 	UserRequest *user_req = NULL;
+	struct s_sms_dr_entry *dr_entry = user_data; /* Set when a status report was requested */
 
 	int msg_ref = 0;
 	GSList *tokens = NULL;
@@ -727,6 +1422,7 @@ static void on_response_send_umts_msg(TcorePending *pending, int data_len, const
 
 	if (NULL == user_req) {
 		err("No user request");
+		g_free(dr_entry);
 
 		dbg("Exit");
 		return;
@@ -749,6 +1445,8 @@ static void on_response_send_umts_msg(TcorePending *pending, int data_len, const
 				dbg("Message Reference: [%d]", msg_ref);
 
 				resp_umts.result = SMS_SENDSMS_SUCCESS;
+
+				util_sms_dr_add(tcore_pending_ref_core_object(pending), msg_ref, dr_entry);
 			} else {
 				dbg("No Message Reference received");
 			}
@@ -758,8 +1456,11 @@ static void on_response_send_umts_msg(TcorePending *pending, int data_len, const
 		}
 	} else { // failure
 		dbg("Response NOK");
+		resp_umts.result = util_at_error_sms_result(at_response->final_response);
 	}
 
+	g_free(dr_entry);
+
 	tcore_user_request_send_response(user_req, TRESP_SMS_SEND_UMTS_MSG, sizeof(resp_umts), &resp_umts);
 
 	dbg("Exit");
@@ -977,6 +1678,12 @@ static void on_response_read_msg(TcorePending *pending, int data_len, const void
 						resp_read_msg.result = SMS_INVALID_PARAMETER_FORMAT;
 					}
 				}
+
+				if (SMS_SUCCESS == resp_read_msg.result) {
+					// +CMGR of an unread message leaves it read on the SIM
+					util_sms_efsms_set_status(tcore_pending_ref_core_object(pending), index,
+						(msg_status == AT_REC_UNREAD) ? SMS_EFSMS_STATUS_READ : util_sms_at_stat_to_efsms_status(msg_status));
+				}
 				free(byte_pdu);
 			} else {
 				dbg("NULL PDU");
@@ -1003,7 +1710,8 @@ static void on_response_get_msg_indices(TcorePending *pending, int data_len, con
 
 	GSList *tokens = NULL;
 	char *gslist_line = NULL, *line_token = NULL;
-	int gslist_line_count = 0, ctr_loop = 0;
+	int gslist_line_count = 0, ctr_loop = 0, listed_count = 0;
+	int listed_stat[SMS_GSM_SMS_MSG_NUM_MAX];
 
 	dbg("Entry");
 
@@ -1038,6 +1746,12 @@ static void on_response_get_msg_indices(TcorePending *pending, int data_len, con
 					if (NULL != line_token) {
 						resp_stored_msg_cnt.storedMsgCnt.indexList[ctr_loop] = atoi(line_token);
 						resp_stored_msg_cnt.result = SMS_SENDSMS_SUCCESS;
+
+						line_token = g_slist_nth_data(tokens, 1); // Second Token: Message Status
+						if (NULL != line_token && listed_count == ctr_loop) {
+							listed_stat[listed_count] = atoi(line_token);
+							listed_count++;
+						}
 					} else {
 						dbg("line_token of gslist_line [%d] is NULL", ctr_loop);
 						continue;
@@ -1054,6 +1768,11 @@ static void on_response_get_msg_indices(TcorePending *pending, int data_len, con
 				resp_stored_msg_cnt.result = SMS_SENDSMS_SUCCESS;
 			}
 		}
+
+		// Only a complete listing tells which records are free
+		if (SMS_SENDSMS_SUCCESS == resp_stored_msg_cnt.result && listed_count == gslist_line_count)
+			util_sms_efsms_sync(tcore_pending_ref_core_object(pending), resp_stored_msg_cnt_prev->storedMsgCnt.totalCount,
+				resp_stored_msg_cnt.storedMsgCnt.indexList, listed_stat, listed_count);
 	} else {
 		dbg("Respnose NOK");
 	}
@@ -1248,9 +1967,12 @@ static void on_response_set_sca(TcorePending *pending, int data_len, const void
 	if (atResp->success > 0) {
 		dbg("RESPONSE OK");
 		respSetSca.result = SMS_SUCCESS;
+
+		// +CSCA updates the service centre address kept in EF-SMSP
+		util_sms_smsp_invalidate(tcore_pending_ref_core_object(pending), -1);
 	} else {
 		dbg("RESPONSE NOK");
-		respSetSca.result = SMS_DEVICE_FAILURE;
+		respSetSca.result = util_at_error_sms_result(atResp->final_response);
 	}
 
 	tcore_user_request_send_response(ur, TRESP_SMS_SET_SCA, sizeof(struct tresp_sms_set_sca), &respSetSca);
@@ -1362,21 +2084,31 @@ static void on_response_set_cb_config(TcorePending *pending, int data_len, const
 
 	UserRequest *ur;
 	const TcoreATResponse *resp = data;
-	int response = 0;
 	const char *line = NULL;
 	GSList *tokens = NULL;
+	struct s_sms_cb_config *requested = user_data;
+	struct s_sms_property *sp = NULL;
 
 	struct tresp_sms_set_cb_config respSetCbConfig = {0, };
 
 	memset(&respSetCbConfig, 0, sizeof(struct tresp_sms_set_cb_config));
 
 	ur = tcore_pending_ref_user_request(pending);
+	sp = util_sms_ref_property(tcore_pending_ref_core_object(pending));
 	respSetCbConfig.result = SMS_SENDSMS_SUCCESS;
 
 	if (resp->success > 0) {
 		dbg("RESPONSE OK");
+		if (sp && requested) {
+			memcpy(&sp->cb_config, requested, sizeof(struct s_sms_cb_config));
+			sp->cb_config.b_valid = TRUE;
+		}
 	} else {
 		dbg("RESPONSE NOK");
+		/* Modem state is unknown now, next request must be sent */
+		if (sp)
+			sp->cb_config.b_valid = FALSE;
+
 		line = (const char *) resp->final_response;
 		tokens = tcore_at_tok_new(line);
 
@@ -1384,17 +2116,15 @@ static void on_response_set_cb_config(TcorePending *pending, int data_len, const
 			dbg("err cause not specified or string corrupted");
 			respSetCbConfig.result = SMS_DEVICE_FAILURE;
 		} else {
-			response = atoi(g_slist_nth_data(tokens, 0));
-			/* TODO: CMEE error mapping is required. */
-			respSetCbConfig.result = SMS_DEVICE_FAILURE;
+			respSetCbConfig.result = util_at_error_sms_result(line);
 		}
 	}
-	if (!ur) {
-		dbg("no user_request");
-		return;
-	}
+	g_free(requested);
 
-	tcore_user_request_send_response(ur, TRESP_SMS_SET_CB_CONFIG, sizeof(struct tresp_sms_set_cb_config), &respSetCbConfig);
+	if (ur)
+		tcore_user_request_send_response(ur, TRESP_SMS_SET_CB_CONFIG, sizeof(struct tresp_sms_set_cb_config), &respSetCbConfig);
+	else
+		dbg("no user_request");
 
 	if (tokens)
 		tcore_at_tok_free(tokens);
@@ -1407,15 +2137,22 @@ static void on_response_set_mem_status(TcorePending *p, int data_len, const void
 	UserRequest *ur;
 	struct tresp_sms_set_mem_status respSetMemStatus = {0, };
 	const TcoreATResponse *resp = data;
+	struct s_sms_property *sp = NULL;
 
 	memset(&respSetMemStatus, 0, sizeof(struct tresp_sms_set_mem_status));
 
+	sp = util_sms_ref_property(tcore_pending_ref_core_object(p));
+
 	if (resp->success > 0) {
 		dbg("RESPONSE OK");
 		respSetMemStatus.result = SMS_SENDSMS_SUCCESS;
+		if (sp)
+			sp->pda_mem_status = (int) (uintptr_t) user_data;
 	} else {
 		dbg("RESPONSE NOK");
-		respSetMemStatus.result = SMS_DEVICE_FAILURE;
+		respSetMemStatus.result = util_at_error_sms_result(resp->final_response);
+		if (sp)
+			sp->pda_mem_status = -1;
 	}
 
 	ur = tcore_pending_ref_user_request(p);
@@ -1432,18 +2169,16 @@ static void on_response_set_mem_status(TcorePending *p, int data_len, const void
 static void on_response_set_msg_status(TcorePending *pending, int data_len, const void *data, void *user_data)
 {
 	UserRequest *ur;
-	struct tresp_sms_set_msg_status respMsgStatus = {0, };
 	const TcoreATResponse *atResp = data;
-	int response = 0, sw1 = 0, sw2 = 0;
+	struct s_sms_status_update *update = user_data;
+	gboolean success = FALSE;
+	int sw1 = 0, sw2 = 0;
 	const char *line = NULL;
 	char *pResp = NULL;
 	GSList *tokens = NULL;
 
 	dbg("Entry");
 
-	memset(&respMsgStatus, 0, sizeof(struct tresp_sms_set_msg_status));
-	respMsgStatus.result = SMS_DEVICE_FAILURE;
-
 	ur = tcore_pending_ref_user_request(pending);
 
 	if (atResp->success > 0) {
@@ -1462,17 +2197,11 @@ static void on_response_set_msg_status(TcorePending *pending, int data_len, cons
 			if (pResp != NULL) {
 				sw2 = atoi(pResp);
 				if ((sw1 == AT_SW1_SUCCESS) && (sw2 == 0)) {
-					respMsgStatus.result = SMS_SENDSMS_SUCCESS;
+					success = TRUE;
 				}
 			} else {
 				dbg("sw2 is NULL");
 			}
-			pResp = g_slist_nth_data(tokens, 3);
-
-			if (pResp != NULL) {
-				response = atoi(pResp);
-				dbg("response is %s", response);
-			}
 		} else {
 			dbg("No lines");
 		}
@@ -1480,7 +2209,7 @@ static void on_response_set_msg_status(TcorePending *pending, int data_len, cons
 		dbg("RESPONSE NOK");
 	}
 
-	tcore_user_request_send_response(ur, TRESP_SMS_SET_MSG_STATUS, sizeof(struct tresp_sms_set_msg_status), &respMsgStatus);
+	util_sms_status_update_done(tcore_pending_ref_core_object(pending), ur, update, success);
 
 	if (tokens)
 		tcore_at_tok_free(tokens);
@@ -1501,6 +2230,8 @@ static void on_response_get_sms_params(TcorePending *pending, int data_len, cons
 	char *hexData = NULL;
 	char *recordData = NULL;
 	int i = 0;
+	int index = (int) (uintptr_t) user_data;
+	struct s_sms_property *sp = NULL;
 
 	memset(&respGetParams, 0, sizeof(struct tresp_sms_get_params));
 	respGetParams.result = SMS_DEVICE_FAILURE;
@@ -1545,6 +2276,12 @@ static void on_response_get_sms_params(TcorePending *pending, int data_len, cons
 				for (i = 0; i < (int) respGetParams.paramsInfo.tpSvcCntrAddr.dialNumLen; i++)
 					dbg("SCAddr = %d [%02x]", i, respGetParams.paramsInfo.tpSvcCntrAddr.diallingNum[i]);
 
+				sp = util_sms_ref_property(tcore_pending_ref_core_object(pending));
+				if (sp && index >= 0 && index < SMS_SMSP_CACHE_RECORD_MAX) {
+					memcpy(&sp->smsp.params[index], &respGetParams.paramsInfo, sizeof(struct telephony_sms_Params));
+					sp->smsp.b_params_valid[index] = TRUE;
+				}
+
 				free(recordData);
 				free(hexData);
 			} else {
@@ -1607,6 +2344,9 @@ static void on_response_set_sms_params(TcorePending *pending, int data_len, cons
 		dbg("RESPONSE NOK");
 	}
 
+	// The record changed on the SIM, read it again next time
+	util_sms_smsp_invalidate(tcore_pending_ref_core_object(pending), (int) (uintptr_t) user_data);
+
 	tcore_user_request_send_response(ur, TRESP_SMS_SET_PARAMS, sizeof(struct tresp_sms_set_params), &respSetParams);
 
 	if (tokens)
@@ -1622,11 +2362,11 @@ static void on_response_get_paramcnt(TcorePending *p, int data_len, const void *
 	struct tresp_sms_get_paramcnt respGetParamCnt = {0, };
 	const TcoreATResponse *atResp = data;
 	char *line = NULL, *pResp = NULL;
-	int sw1 = 0, sw2 = 0, *smsp_record_len = NULL;
+	int sw1 = 0, sw2 = 0;
 	int sim_type = 0;
 	GSList *tokens = NULL;
 	CoreObject *co_sim = NULL;  // need this to get the sim type GSM/USIM
-	TcorePlugin *plugin = NULL;
+	struct s_sms_property *sp = NULL;
 
 	dbg("Entry");
 
@@ -1659,369 +2399,32 @@ static void on_response_get_paramcnt(TcorePending *p, int data_len, const void *
 			}
 			pResp = g_slist_nth_data(tokens, 2);
 			if (pResp != NULL) {
-				char *hexData = NULL;
-				char *recordData = NULL;
-				hexData = util_removeQuotes(pResp);
-
 				/*1. SIM access success case*/
 				if ((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91) {
-					unsigned char tag_len = 0; /*	1 or 2 bytes ??? */
-					int record_len = 0;
-					char num_of_records = 0;
-					unsigned char file_id_len = 0;
-					unsigned short file_id = 0;
-					unsigned short file_size = 0;
-					unsigned short file_type = 0;
-					unsigned short arr_file_id = 0;
-					int arr_file_id_rec_num = 0;
-
-					/*	handling only last 3 bits */
-					unsigned char file_type_tag = 0x07;
-					unsigned char *ptr_data;
-
-					recordData = util_hexStringToBytes(hexData);
-					util_hex_dump("    ", strlen(hexData) / 2, recordData);
-
-					ptr_data = (unsigned char *) recordData;
+					struct util_sim_fcp fcp;
 
 					co_sim = tcore_plugin_ref_core_object(tcore_pending_ref_plugin(p), "sim");
 					sim_type = tcore_sim_get_type(co_sim);
 					dbg("sim type is %d", sim_type);
 
-					if (sim_type == SIM_TYPE_USIM) {
-						/*
-						 ETSI TS 102 221 v7.9.0
-						    - Response Data
-						     '62'	FCP template tag
-						     - Response for an EF
-						     '82'	M	File Descriptor
-						     '83'	M	File Identifier
-						    'A5'	O	Proprietary information
-						     '8A'	M	Life Cycle Status Integer
-						     '8B', '8C' or 'AB'	C1	Security attributes
-						    '80'	M	File size
-						     '81'	O	Total file size
-						     '88'	O	Short File Identifier (SFI)
-						*/
-
-						/* rsim.res_len  has complete data length received  */
-
-						/* FCP template tag - File Control Parameters tag*/
-						if (*ptr_data == 0x62) {
-							/* parse complete FCP tag*/
-							/* increment to next byte */
-							ptr_data++;
-							tag_len = *ptr_data++;
-							/* FCP file descriptor - file type, accessibility, DF, ADF etc*/
-							if (*ptr_data == 0x82) {
-								/* increment to next byte */
-								ptr_data++;
-								/*2 or 5 value*/
-								ptr_data++;
-								/*	unsigned char file_desc_len = *ptr_data++;*/
-								/*	dbg("file descriptor length: [%d]", file_desc_len);*/
-								/* TBD:  currently capture only file type : ignore sharable, non sharable, working, internal etc*/
-								/* consider only last 3 bits*/
-								file_type_tag = file_type_tag & (*ptr_data);
-
-								switch (file_type_tag) {
-									/* increment to next byte */
-									ptr_data++;
-
-								case 0x1:
-									dbg("Getting FileType: [Transparent file type]");
-									/* increment to next byte */
-									ptr_data++;
-									file_type = 0x01;   // SIM_FTYPE_TRANSPARENT
-									/*	data coding byte - value 21 */
-									ptr_data++;
-									break;
-
-								case 0x2:
-									dbg("Getting FileType: [Linear fixed file type]");
-									/* increment to next byte */
-									ptr_data++;
-									/*	data coding byte - value 21 */
-									ptr_data++;
-									/*	2bytes */
-									memcpy(&record_len, ptr_data, 2);
-									/* swap bytes */
-									record_len = SMS_SWAPBYTES16(record_len);
-									ptr_data = ptr_data + 2;
-									num_of_records = *ptr_data++;
-									/* Data lossy conversation from enum (int) to unsigned char */
-									file_type = 0x02;   // SIM_FTYPE_LINEAR_FIXED
-									break;
-
-								case 0x6:
-									dbg(" Cyclic fixed file type");
-									/* increment to next byte */
-									ptr_data++;
-									/*	data coding byte - value 21 */
-									ptr_data++;
-									/*	2bytes */
-									memcpy(&record_len, ptr_data, 2);
-									/* swap bytes  */
-									record_len = SMS_SWAPBYTES16(record_len);
-									ptr_data = ptr_data + 2;
-									num_of_records = *ptr_data++;
-									file_type = 0x04;   // SIM_FTYPE_CYCLIC
-									break;
-
-								default:
-									dbg("not handled file type [0x%x]", *ptr_data);
-									break;
-								}
-							} else {
-								dbg("INVALID FCP received - DEbug!");
-								tcore_at_tok_free(tokens);
-								return;
-							}
-
-							/*File identifier - file id?? */ // 0x84,0x85,0x86 etc are currently ignored and not handled
-							if (*ptr_data == 0x83) {
-								/* increment to next byte */
-								ptr_data++;
-								file_id_len = *ptr_data++;
-								memcpy(&file_id, ptr_data, file_id_len);
-								/* swap bytes	 */
-								file_id = SMS_SWAPBYTES16(file_id);
-								ptr_data = ptr_data + 2;
-								dbg("Getting FileID=[0x%x]", file_id);
-							} else {
-								dbg("INVALID FCP received - DEbug!");
-								free(hexData);
-								free(recordData);
-								tcore_at_tok_free(tokens);
-								return;
-							}
-
-							/*	proprietary information  */
-							if (*ptr_data == 0xA5) {
-								unsigned short prop_len;
-								/* increment to next byte */
-								ptr_data++;
-								/* length */
-								prop_len = *ptr_data;
-								/* skip data */
-								ptr_data = ptr_data + prop_len + 1;
-							} else {
-								dbg("INVALID FCP received - DEbug!");
-							}
-
-							/* life cycle status integer [8A][length:0x01][status]*/
-							/*
-							 status info b8~b1
-							 00000000 : No information given
-							 00000001 : creation state
-							 00000011 : initialization state
-							 000001-1 : operation state -activated
-							 000001-0 : operation state -deactivated
-							 000011-- : Termination state
-							 b8~b5 !=0, b4~b1=X : Proprietary
-							 Any other value : RFU
-							 */
-							if (*ptr_data == 0x8A) {
-								/* increment to next byte */
-								ptr_data++;
-								/* length - value 1 */
-								ptr_data++;
-
-								switch (*ptr_data) {
-								case 0x04:
-								case 0x06:
-									dbg("<IPC_RX> operation state -deactivated");
-									ptr_data++;
-									break;
-
-								case 0x05:
-								case 0x07:
-									dbg("<IPC_RX> operation state -activated");
-									ptr_data++;
-									break;
-
-								default:
-									dbg("<IPC_RX> DEBUG! LIFE CYCLE STATUS =[0x%x]", *ptr_data);
-									ptr_data++;
-									break;
-								}
-							}
-
-							/* related to security attributes : currently not handled*/
-							if (*ptr_data == 0x86 || *ptr_data == 0x8B || *ptr_data == 0x8C || *ptr_data == 0xAB) {
-								/* increment to next byte */
-								ptr_data++;
-								/* if tag length is 3 */
-								if (*ptr_data == 0x03) {
-									/* increment to next byte */
-									ptr_data++;
-									/* EFARR file id */
-									memcpy(&arr_file_id, ptr_data, 2);
-									/* swap byes */
-									arr_file_id = SMS_SWAPBYTES16(arr_file_id);
-									ptr_data = ptr_data + 2;
-									arr_file_id_rec_num = *ptr_data++;
-								} else {
-									/* if tag length is not 3 */
-									/* ignoring bytes	*/
-									// ptr_data = ptr_data + 4;
-									dbg("Useless security attributes, so jump to next tag");
-									ptr_data = ptr_data + (*ptr_data + 1);
-								}
-							} else {
-								dbg("INVALID FCP received[0x%x] - DEbug!", *ptr_data);
-								free(hexData);
-								free(recordData);
-								tcore_at_tok_free(tokens);
-								return;
-							}
-
-							dbg("Current ptr_data value is [%x]", *ptr_data);
-
-							/* file size excluding structural info*/
-							if (*ptr_data == 0x80) {
-								/* for EF file size is body of file and for Linear or cyclic it is
-								 * number of recXsizeof(one record)
-								 */
-								/* increment to next byte */
-								ptr_data++;
-								/* length is 1 byte - value is 2 bytes or more */
-								ptr_data++;
-								memcpy(&file_size, ptr_data, 2);
-								/* swap bytes */
-								file_size = SMS_SWAPBYTES16(file_size);
-								ptr_data = ptr_data + 2;
-							} else {
-								dbg("INVALID FCP received - DEbug!");
-								free(hexData);
-								free(recordData);
-								tcore_at_tok_free(tokens);
-								return;
-							}
-
-							/* total file size including structural info*/
-							if (*ptr_data == 0x81) {
-								int len;
-								/* increment to next byte */
-								ptr_data++;
-								/* length */
-								len = *ptr_data;
-								/* ignored bytes */
-								ptr_data = ptr_data + 3;
-							} else {
-								dbg("INVALID FCP received - DEbug!");
-								/* 0x81 is optional tag?? check out! so do not return -1 from here! */
-								/* return -1; */
-							}
-							/*short file identifier ignored*/
-							if (*ptr_data == 0x88) {
-								dbg("0x88: Do Nothing");
-								/*DO NOTHING*/
-							}
-						} else {
-							dbg("INVALID FCP received - DEbug!");
-							free(hexData);
-							free(recordData);
-							tcore_at_tok_free(tokens);
-							return;
-						}
-					} else if (sim_type == SIM_TYPE_GSM) {
-						unsigned char gsm_specific_file_data_len = 0;
-						/*	ignore RFU byte1 and byte2 */
-						ptr_data++;
-						ptr_data++;
-						/*	file size */
-						// file_size = p_info->response_len;
-						memcpy(&file_size, ptr_data, 2);
-						/* swap bytes */
-						file_size = SMS_SWAPBYTES16(file_size);
-						/*	parsed file size */
-						ptr_data = ptr_data + 2;
-						/*  file id  */
-						memcpy(&file_id, ptr_data, 2);
-						file_id = SMS_SWAPBYTES16(file_id);
-						dbg(" FILE id --> [%x]", file_id);
-						ptr_data = ptr_data + 2;
-						/* save file type - transparent, linear fixed or cyclic */
-						file_type_tag = (*(ptr_data + 7));
-
-						switch (*ptr_data) {
-						case 0x0:
-							/* RFU file type */
-							dbg(" RFU file type- not handled - Debug!");
-							break;
-
-						case 0x1:
-							/* MF file type */
-							dbg(" MF file type - not handled - Debug!");
-							break;
-
-						case 0x2:
-							/* DF file type */
-							dbg(" DF file type - not handled - Debug!");
-							break;
-
-						case 0x4:
-							/* EF file type */
-							dbg(" EF file type [%d] ", file_type_tag);
-							/*	increment to next byte */
-							ptr_data++;
-
-							if (file_type_tag == 0x00 || file_type_tag == 0x01) {
-								/* increament to next byte as this byte is RFU */
-								ptr_data++;
-								file_type =
-									(file_type_tag == 0x00) ? 0x01 : 0x02;         // SIM_FTYPE_TRANSPARENT:SIM_FTYPE_LINEAR_FIXED;
-							} else {
-								/* increment to next byte */
-								ptr_data++;
-								/*	For a cyclic EF all bits except bit 7 are RFU; b7=1 indicates that */
-								/* the INCREASE command is allowed on the selected cyclic file. */
-								file_type = 0x04;       // SIM_FTYPE_CYCLIC;
-							}
-							/* bytes 9 to 11 give SIM file access conditions */
-							ptr_data++;
-							/* byte 10 has one nibble that is RF U and another for INCREASE which is not used currently */
-							ptr_data++;
-							/* byte 11 is invalidate and rehabilate nibbles */
-							ptr_data++;
-							/* byte 12 - file status */
-							ptr_data++;
-							/* byte 13 - GSM specific data */
-							gsm_specific_file_data_len = *ptr_data;
-							ptr_data++;
-							/*	byte 14 - structure of EF - transparent or linear or cyclic , already saved above */
-							ptr_data++;
-							/* byte 15 - length of record for linear and cyclic , for transparent it is set to 0x00. */
-							record_len = *ptr_data;
-							dbg("record length[%d], file size[%d]", record_len, file_size);
-
-							if (record_len != 0)
-								num_of_records = (file_size / record_len);
-
-							dbg("Number of records [%d]", num_of_records);
-							break;
-
-						default:
-							dbg(" not handled file type");
-							break;
-						}
+					if (util_sim_fcp_decode(pResp, sim_type == SIM_TYPE_USIM, &fcp) == FALSE) {
+						err("invalid FCP for EF-SMSP");
+						respGetParamCnt.result = SMS_DEVICE_FAILURE;
 					} else {
-						dbg(" Card Type - UNKNOWN  [%d]", sim_type);
+						dbg("EF[0x%x] size[%d] Type[%d] NumOfRecords[%d] RecordLen[%d]", fcp.file_id, fcp.file_size,
+							fcp.structure, fcp.record_count, fcp.record_len);
+
+						respGetParamCnt.recordCount = fcp.record_count;
+						respGetParamCnt.result = SMS_SUCCESS;
+
+						// Keep EF-SMSP metadata, later requests are answered without GET RESPONSE
+						sp = util_sms_ref_property(tcore_pending_ref_core_object(p));
+						if (sp) {
+							sp->smsp.record_count = fcp.record_count;
+							sp->smsp.record_len = fcp.record_len;
+							sp->smsp.b_meta_valid = TRUE;
+						}
 					}
-
-					dbg("EF[0x%x] size[%ld] Type[0x%x] NumOfRecords[%ld] RecordLen[%ld]", file_id, file_size, file_type, num_of_records, record_len);
-
-					respGetParamCnt.recordCount = num_of_records;
-					respGetParamCnt.result = SMS_SUCCESS;
-
-					// TO Store smsp record length in the property
-					plugin = tcore_pending_ref_plugin(p);
-					smsp_record_len = tcore_plugin_ref_property(plugin, "SMSPRECORDLEN");
-					memcpy(smsp_record_len, &record_len, sizeof(int));
-
-					free(recordData);
-					free(hexData);
 				} else {
 					/*2. SIM access fail case*/
 					dbg("SIM access fail");
@@ -2046,129 +2449,131 @@ static void on_response_get_paramcnt(TcorePending *p, int data_len, const void *
 	return;
 }
 
-static void _response_get_efsms_data(TcorePending *p, int data_len, const void *data, void *user_data)
+/* Writes back a record just read from the SIM with only the status byte changed */
+static TReturn _set_efsms_status(CoreObject *o, UserRequest *ur, struct s_sms_status_update *update, char *record)
 {
-	UserRequest *ur = NULL;
-	UserRequest *dup_ur = NULL;
-	struct tresp_sms_set_msg_status resp_msg_status = {0, };
-	const struct treq_sms_set_msg_status *req_msg_status = NULL;
-
-	const TcoreATResponse *resp = data;
 	char *encoded_data = NULL;
-	char msg_status = 0;
-	char *pResp = NULL;
-	GSList *tokens = NULL;
-	const char *line = NULL;
-	int sw1 = 0;
-	int sw2 = 0;
-
-	TcoreHal *hal = NULL;
+	gchar *cmd_str = NULL;
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
-	gchar *cmd_str = NULL;
 
-	ur = tcore_pending_ref_user_request(p);
+	record[0] = update->status;
 
-	req_msg_status = tcore_user_request_ref_data(ur, NULL);
+	encoded_data = g_try_malloc0(AT_EF_SMS_RECORD_LEN * 2 + 1);
+	if (encoded_data)
+		util_byte_to_hex(record, encoded_data, AT_EF_SMS_RECORD_LEN);
 
-	resp_msg_status.result = SMS_DEVICE_FAILURE;
+	// Update EF-SMS with just status byte overwritten, rest 175 bytes are same as stored on the SIM
+	cmd_str = g_strdup_printf("AT+CRSM=220,28476,%d,4,%d,\"%s\"", (update->index + 1), AT_EF_SMS_RECORD_LEN, encoded_data);
+	atreq = tcore_at_request_new((const char *) cmd_str, "+CRSM", TCORE_AT_SINGLELINE);
+	pending = tcore_pending_new(o, 0);
+	if (NULL == encoded_data || NULL == cmd_str || NULL == atreq || NULL == pending) {
+		err("Out of memory. Unable to proceed");
+		dbg("cmd_str: [%p], atreq: [%p], pending: [%p]", cmd_str, atreq, pending);
 
-	hal = tcore_object_get_hal(tcore_pending_ref_core_object(pending));
-	dbg("msgStatus: [%x], index [%x]", req_msg_status->msgStatus, req_msg_status->index);
+		// free memory we own
+		g_free(cmd_str);
+		g_free(encoded_data);
+		util_sms_free_memory(atreq);
+		util_sms_free_memory(pending);
 
-	if (resp->success <= 0) {
-		goto OUT;
+		return TCORE_RETURN_ENOMEM;
 	}
 
-	{
-		dbg("RESPONSE OK");
-		if (resp->lines) {
-			line = (const char *) resp->lines->data;
-			tokens = tcore_at_tok_new(line);
-			if (g_slist_length(tokens) != 3) {
-				msg("invalid message");
-				goto OUT;
-			}
-		}
-		sw1 = atoi(g_slist_nth_data(tokens, 0));
-		sw2 = atoi(g_slist_nth_data(tokens, 1));
-		pResp = g_slist_nth_data(tokens, 2);
-
-		if ((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91) {
-			switch (req_msg_status->msgStatus) {
-			case SMS_STATUS_READ:
-				msg_status = 0x01;
-				break;
+	util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
-			case SMS_STATUS_UNREAD:
-				msg_status = 0x03;
-				break;
+	tcore_pending_set_request_data(pending, 0, atreq);
+	tcore_pending_set_response_callback(pending, on_response_set_msg_status, (void *) update);
+	tcore_pending_link_user_request(pending, ur);
+	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
+	tcore_hal_send_request(tcore_object_get_hal(o), pending);
 
-			case SMS_STATUS_UNSENT:
-				msg_status = 0x07;
-				break;
+	g_free(cmd_str);
+	g_free(encoded_data);
 
-			case SMS_STATUS_SENT:
-				msg_status = 0x05;
-				break;
+	return TCORE_RETURN_SUCCESS;
+}
 
-			case SMS_STATUS_DELIVERED:
-				msg_status = 0x1D;
-				break;
+static void _response_get_efsms_data(TcorePending *p, int data_len, const void *data, void *user_data)
+{
+	UserRequest *ur = NULL;
+	UserRequest *dup_ur = NULL;
+	struct s_sms_status_update *update = user_data;
+	CoreObject *o = NULL;
+	TReturn ret = TCORE_RETURN_SUCCESS;
 
-			case SMS_STATUS_DELIVERY_UNCONFIRMED:
-				msg_status = 0xD;
-				break;
+	const TcoreATResponse *resp = data;
+	char *encoded_data = NULL;
+	char *byte_data = NULL;
+	char *pResp = NULL;
+	GSList *tokens = NULL;
+	const char *line = NULL;
+	int sw1 = 0;
+	int sw2 = 0;
 
-			case SMS_STATUS_MESSAGE_REPLACED:
-			case SMS_STATUS_RESERVED:
-			default:
-				msg_status = 0x03;
-				break;
-			}
+	ur = tcore_pending_ref_user_request(p);
+	o = tcore_pending_ref_core_object(p);
 
-			encoded_data = util_removeQuotes(pResp);
+	dbg("msgStatus: [%x], index [%x]", update->status, update->index);
 
-			// overwrite Status byte information
-			util_byte_to_hex((const char *) &msg_status, (char *) encoded_data, 1);
+	if (resp->success <= 0 || NULL == resp->lines) {
+		goto OUT;
+	}
 
-			// Update EF-SMS with just status byte overwritten, rest 175 bytes are same as received in read information
-			cmd_str = g_strdup_printf("AT+CRSM=220,28476,%d, 4, %d, \"%s\"", (req_msg_status->index + 1), AT_EF_SMS_RECORD_LEN, encoded_data);
-			atreq = tcore_at_request_new((const char *) cmd_str, "+CRSM", TCORE_AT_SINGLELINE);
-			pending = tcore_pending_new(tcore_pending_ref_core_object(pending), 0);
-			if (NULL == cmd_str || NULL == atreq || NULL == pending) {
-				err("Out of memory. Unable to proceed");
-				dbg("cmd_str: [%p], atreq: [%p], pending: [%p]", cmd_str, atreq, pending);
+	dbg("RESPONSE OK");
+	line = (const char *) resp->lines->data;
+	tokens = tcore_at_tok_new(line);
+	if (g_slist_length(tokens) != 3) {
+		msg("invalid message");
+		goto OUT;
+	}
 
-				// free memory we own
-				g_free(cmd_str);
-				free(encoded_data);
-				util_sms_free_memory(atreq);
-				util_sms_free_memory(pending);
+	sw1 = atoi(g_slist_nth_data(tokens, 0));
+	sw2 = atoi(g_slist_nth_data(tokens, 1));
+	pResp = g_slist_nth_data(tokens, 2);
 
-				goto OUT;
-			}
+	if (!((sw1 == 0x90 && sw2 == 0x00) || sw1 == 0x91)) {
+		goto OUT;
+	}
 
-			util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
+	encoded_data = util_removeQuotes(pResp);
+	if (NULL == encoded_data || strlen(encoded_data) != AT_EF_SMS_RECORD_LEN * 2) {
+		err("Unexpected EF-SMS record");
+		free(encoded_data);
+		goto OUT;
+	}
 
-			dup_ur = tcore_user_request_ref(ur);
+	byte_data = util_hexStringToBytes(encoded_data);
+	free(encoded_data);
+	if (NULL == byte_data) {
+		goto OUT;
+	}
 
-			tcore_pending_set_request_data(pending, 0, atreq);
-			tcore_pending_set_response_callback(pending, on_response_set_msg_status, NULL);
-			tcore_pending_link_user_request(pending, dup_ur);
-			tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
-			tcore_hal_send_request(hal, pending);
+	tcore_at_tok_free(tokens);
 
-			g_free(cmd_str);
-			free(encoded_data);
-		}
+	util_sms_efsms_set_status(o, update->index, (unsigned char) byte_data[0]);
+	if ((unsigned char) byte_data[0] == update->status) {
+		dbg("Status already set on the SIM");
+		free(byte_data);
+		util_sms_status_update_done(o, ur, update, TRUE);
+		return;
 	}
 
+	dup_ur = tcore_user_request_ref(ur);
+	ret = _set_efsms_status(o, dup_ur, update, byte_data);
+	free(byte_data);
+	if (TCORE_RETURN_SUCCESS == ret)
+		return;
+
+	tcore_user_request_unref(dup_ur);
+	util_sms_status_update_done(o, ur, update, FALSE);
+	return;
+
 OUT:
 	if (tokens)
 		tcore_at_tok_free(tokens);
 
-	tcore_user_request_send_response(ur, TRESP_SMS_SET_MSG_STATUS, sizeof(struct tresp_sms_set_msg_status), &msg_status);
+	util_sms_status_update_done(o, ur, update, FALSE);
 
 	dbg("Exit");
 
@@ -2188,6 +2593,7 @@ static TReturn send_umts_msg(CoreObject *obj, UserRequest *ur)
 	char buf[2 * (SMS_SMSP_ADDRESS_LEN + SMS_SMDATA_SIZE_MAX) + 1] = {0};
 	int ScLength = 0;
 	int pdu_len = 0;
+	struct s_sms_dr_entry *dr_entry = NULL;
 
 	dbg("Entry");
 
@@ -2233,6 +2639,13 @@ static TReturn send_umts_msg(CoreObject *obj, UserRequest *ur)
 		dbg("pdu_len: [%d]", pdu_len);
 		util_hex_dump("    ", sizeof(buf), (void *) buf);
 
+		// Remember where a status report should come back to, indexed by TP-MR once known
+		dr_entry = g_try_new0(struct s_sms_dr_entry, 1);
+		if (dr_entry && FALSE == util_sms_dr_prepare(sendUmtsMsg->msgDataPackage.tpduData, sendUmtsMsg->msgDataPackage.msgLength, dr_entry)) {
+			g_free(dr_entry);
+			dr_entry = NULL;
+		}
+
 		// AT+CMGS=<length><CR>PDU is given<ctrl-Z/ESC>
 		cmd_str = g_strdup_printf("AT+CMGS=%d%s%s\x1A", sendUmtsMsg->msgDataPackage.msgLength, "\r", buf);
 		atreq = tcore_at_request_new((const char *) cmd_str, "+CMGS", TCORE_AT_SINGLELINE);
@@ -2244,6 +2657,7 @@ static TReturn send_umts_msg(CoreObject *obj, UserRequest *ur)
 
 			// free memory we own
 			g_free(cmd_str);
+			g_free(dr_entry);
 			util_sms_free_memory(atreq);
 			util_sms_free_memory(pending);
 
@@ -2254,7 +2668,7 @@ static TReturn send_umts_msg(CoreObject *obj, UserRequest *ur)
 		util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 		tcore_pending_set_request_data(pending, 0, atreq);
-		tcore_pending_set_response_callback(pending, on_response_send_umts_msg, NULL);
+		tcore_pending_set_response_callback(pending, on_response_send_umts_msg, (void *) dr_entry); // freed in response
 		tcore_pending_link_user_request(pending, ur);
 		tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
 		tcore_hal_send_request(hal, pending);
@@ -2420,7 +2834,8 @@ static TReturn save_msg(CoreObject *obj, UserRequest *ur)
 		util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 		tcore_pending_set_request_data(pending, 0, atreq);
-		tcore_pending_set_response_callback(pending, on_response_sms_save_msg, NULL);
+		tcore_pending_set_response_callback(pending, on_response_sms_save_msg,
+											GUINT_TO_POINTER(util_sms_at_stat_to_efsms_status(stat)));
 		tcore_pending_link_user_request(pending, ur);
 		tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
 		tcore_hal_send_request(hal, pending);
@@ -2500,6 +2915,8 @@ static TReturn get_storedMsgCnt(CoreObject *obj, UserRequest *ur)
 	TcoreHal *hal = NULL;
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
+	struct s_sms_property *sp = NULL;
+	int i = 0, used = 0;
 
 	dbg("Entry");
 
@@ -2511,6 +2928,26 @@ static TReturn get_storedMsgCnt(CoreObject *obj, UserRequest *ur)
 		return TCORE_RETURN_EINVAL;
 	}
 
+	sp = util_sms_ref_property(obj);
+	if (sp && sp->slots.b_valid) {
+		struct tresp_sms_get_storedMsgCnt respStoredMsgCnt;
+
+		memset(&respStoredMsgCnt, 0x00, sizeof(respStoredMsgCnt));
+		respStoredMsgCnt.storedMsgCnt.totalCount = sp->slots.total_count;
+		respStoredMsgCnt.storedMsgCnt.usedCount = sp->slots.used_count;
+		for (i = 0; i < sp->slots.total_count; i++) {
+			if (util_sms_slot_is_used(&sp->slots, i))
+				respStoredMsgCnt.storedMsgCnt.indexList[used++] = i + 1; // reported as +CMGL index, see on_response_get_msg_indices
+		}
+		respStoredMsgCnt.result = SMS_SENDSMS_SUCCESS;
+
+		dbg("total: [%d], used: [%d] from slot map", sp->slots.total_count, sp->slots.used_count);
+		tcore_user_request_send_response(ur, TRESP_SMS_GET_STORED_MSG_COUNT, sizeof(struct tresp_sms_get_storedMsgCnt), &respStoredMsgCnt);
+
+		dbg("Exit");
+		return TCORE_RETURN_SUCCESS;
+	}
+
 	cmd_str = g_strdup_printf("AT+CPMS=\"SM\"");
 	pending = tcore_pending_new(obj, 0);
 	atreq = tcore_at_request_new((const char *) cmd_str, "+CPMS", TCORE_AT_SINGLELINE);
@@ -2698,15 +3135,13 @@ static TReturn get_cb_config(CoreObject *obj, UserRequest *ur)
 static TReturn set_cb_config(CoreObject *obj, UserRequest *ur)
 {
 	gchar *cmd_str = NULL;
-	gchar *mids_str = NULL;
-	GString *mids_GString = NULL;
 
 	TcoreHal *hal = NULL;
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
 	const struct treq_sms_set_cb_config *setCbConfig = NULL;
-	int ctr1 = 0, ctr2 = 0;
-	unsigned short appendMsgId = 0;
+	struct s_sms_cb_config *requested = NULL;
+	struct s_sms_property *sp = NULL;
 
 	dbg("Entry");
 
@@ -2723,42 +3158,31 @@ static TReturn set_cb_config(CoreObject *obj, UserRequest *ur)
 	dbg("bCBEnabled: %d,  msgIdMaxCount: %x, msgIdCount: %d", setCbConfig->cbEnabled, setCbConfig->msgIdMaxCount, setCbConfig->msgIdRangeCount);
 	// util_hex_dump("    ", SMS_GSM_SMS_CBMI_LIST_SIZE_MAX, (void *)setCbConfig->msgIDs);
 
-	if (setCbConfig->cbEnabled == 2) { // Enable all CBS
-		cmd_str = g_strdup_printf("AT+CSCB=1");
-	} else if (setCbConfig->cbEnabled == 0) { // AT+CSCB=0: Disable CBS
-		cmd_str = g_strdup_printf("AT+CSCB=0");
-	} else {
-		mids_GString = g_string_new("AT+CSCB=0,\"");
-
-		for (ctr1 = 0; ctr1 < setCbConfig->msgIdRangeCount; ctr1++) {
-			if (setCbConfig->msgIDs[ctr1].net3gpp.selected == FALSE)
-				continue;
+	requested = g_try_new0(struct s_sms_cb_config, 1);
+	if (NULL == requested) {
+		err("Out of memory. Unable to proceed");
 
-			if (SMS_GSM_SMS_CBMI_LIST_SIZE_MAX <= (setCbConfig->msgIDs[ctr1].net3gpp.toMsgId - setCbConfig->msgIDs[ctr1].net3gpp.fromMsgId)) {
-				mids_GString = g_string_new("AT+CSCB=1");
-				break;
-			}
+		dbg("Exit");
+		return TCORE_RETURN_ENOMEM;
+	}
+	util_sms_normalize_cb_config(setCbConfig, requested);
 
-			appendMsgId = setCbConfig->msgIDs[ctr1].net3gpp.fromMsgId;
+	sp = util_sms_ref_property(obj);
+	if (sp && sp->cb_config.b_valid && util_sms_cb_config_equal(&sp->cb_config, requested)) {
+		struct tresp_sms_set_cb_config respSetCbConfig = {0, };
 
-			for (ctr2 = 0; (ctr2 <= ((setCbConfig->msgIDs[ctr1].net3gpp.toMsgId) - (setCbConfig->msgIDs[ctr1].net3gpp.fromMsgId))); ctr2++) {
-				dbg("%x", appendMsgId);
-				mids_GString = g_string_append(mids_GString, g_strdup_printf("%d", appendMsgId));
+		dbg("Requested CB configuration is already active. Nothing to send");
+		g_free(requested);
 
-				if (ctr2 == ((setCbConfig->msgIDs[ctr1].net3gpp.toMsgId) - (setCbConfig->msgIDs[ctr1].net3gpp.fromMsgId))) {
-					mids_GString = g_string_append(mids_GString, "\""); // Mids string termination
-				} else {
-					mids_GString = g_string_append(mids_GString, ",");
-				}
+		respSetCbConfig.result = SMS_SENDSMS_SUCCESS;
+		tcore_user_request_send_response(ur, TRESP_SMS_SET_CB_CONFIG, sizeof(struct tresp_sms_set_cb_config), &respSetCbConfig);
 
-				appendMsgId++;
-			}
-		}
-		mids_str = g_string_free(mids_GString, FALSE);
-		cmd_str = g_strdup_printf("%s", mids_str);
-		g_free(mids_str);
+		dbg("Exit");
+		return TCORE_RETURN_SUCCESS;
 	}
 
+	cmd_str = util_sms_encode_cb_config(requested);
+
 	pending = tcore_pending_new(obj, 0);
 	atreq = tcore_at_request_new((const char *) cmd_str, NULL, TCORE_AT_NO_RESULT);
 	if (NULL == cmd_str || NULL == atreq || NULL == pending) {
@@ -2767,6 +3191,7 @@ static TReturn set_cb_config(CoreObject *obj, UserRequest *ur)
 
 		// free memory we own
 		g_free(cmd_str);
+		g_free(requested);
 		util_sms_free_memory(atreq);
 		util_sms_free_memory(pending);
 
@@ -2777,7 +3202,7 @@ static TReturn set_cb_config(CoreObject *obj, UserRequest *ur)
 	util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 	tcore_pending_set_request_data(pending, 0, atreq);
-	tcore_pending_set_response_callback(pending, on_response_set_cb_config, NULL);
+	tcore_pending_set_response_callback(pending, on_response_set_cb_config, (void *) requested); // freed in response
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
 	tcore_hal_send_request(hal, pending);
@@ -2795,6 +3220,7 @@ static TReturn set_mem_status(CoreObject *obj, UserRequest *ur)
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
 	const struct treq_sms_set_mem_status *setMemStatus = NULL;
+	struct s_sms_property *sp = NULL;
 	int memoryStatus = 0;
 
 	dbg("Entry");
@@ -2834,6 +3260,19 @@ static TReturn set_mem_status(CoreObject *obj, UserRequest *ur)
 		return TCORE_RETURN_EINVAL;
 	}
 
+	sp = util_sms_ref_property(obj);
+	if (sp && sp->pda_mem_status == memoryStatus) {
+		struct tresp_sms_set_mem_status respSetMemStatus = {0, };
+
+		dbg("Memory status already set in the modem");
+
+		respSetMemStatus.result = SMS_SENDSMS_SUCCESS;
+		tcore_user_request_send_response(ur, TRESP_SMS_SET_MEM_STATUS, sizeof(struct tresp_sms_set_mem_status), &respSetMemStatus);
+
+		dbg("Exit");
+		return TCORE_RETURN_SUCCESS;
+	}
+
 	cmd_str = g_strdup_printf("AT+XTESM=%d", memoryStatus);
 	pending = tcore_pending_new(obj, 0);
 	atreq = tcore_at_request_new((const char *) cmd_str, NULL, TCORE_AT_NO_RESULT);
@@ -2854,7 +3293,7 @@ static TReturn set_mem_status(CoreObject *obj, UserRequest *ur)
 	util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 	tcore_pending_set_request_data(pending, 0, atreq);
-	tcore_pending_set_response_callback(pending, on_response_set_mem_status, NULL);
+	tcore_pending_set_response_callback(pending, on_response_set_mem_status, (void *) (uintptr_t) memoryStatus);
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
 	tcore_hal_send_request(hal, pending);
@@ -2881,19 +3320,23 @@ static TReturn set_delivery_report(CoreObject *obj, UserRequest *ur)
 	return TCORE_RETURN_SUCCESS;
 }
 
-static TReturn set_msg_status(CoreObject *obj, UserRequest *ur)
+/* Starts the status update of one record by reading it, the write-back follows in _response_get_efsms_data */
+static TReturn _start_efsms_status_update(CoreObject *obj, UserRequest *ur, struct s_sms_status_batch *batch, int index, unsigned char status)
 {
 	gchar *cmd_str = NULL;
-	TcoreHal *hal = NULL;
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
-	const struct treq_sms_set_msg_status *msg_status = NULL;
+	struct s_sms_status_update *update = NULL;
 
-	dbg("Entry");
+	update = g_try_new0(struct s_sms_status_update, 1);
+	if (NULL == update)
+		return TCORE_RETURN_ENOMEM;
 
-	msg_status = tcore_user_request_ref_data(ur, NULL);
+	update->batch = batch;
+	update->index = index;
+	update->status = status;
 
-	cmd_str = g_strdup_printf("AT+CRSM=178,28476,%d,4,%d", (msg_status->index + 1), AT_EF_SMS_RECORD_LEN);
+	cmd_str = g_strdup_printf("AT+CRSM=178,28476,%d,4,%d", (index + 1), AT_EF_SMS_RECORD_LEN);
 	atreq = tcore_at_request_new((const char *) cmd_str, "+CRSM", TCORE_AT_SINGLELINE);
 	pending = tcore_pending_new(obj, 0);
 	if (NULL == cmd_str || NULL == atreq || NULL == pending) {
@@ -2902,23 +3345,126 @@ static TReturn set_msg_status(CoreObject *obj, UserRequest *ur)
 
 		// free memory we own
 		g_free(cmd_str);
+		g_free(update);
 		util_sms_free_memory(atreq);
 		util_sms_free_memory(pending);
 
-		dbg("Exit");
 		return TCORE_RETURN_ENOMEM;
 	}
 
 	util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 	tcore_pending_set_request_data(pending, 0, atreq);
-	tcore_pending_set_response_callback(pending, _response_get_efsms_data, NULL);
+	tcore_pending_set_response_callback(pending, _response_get_efsms_data, (void *) update);
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
-	tcore_hal_send_request(hal, pending);
+	tcore_hal_send_request(tcore_object_get_hal(obj), pending);
+	batch->outstanding++;
 
 	g_free(cmd_str);
 
+	return TCORE_RETURN_SUCCESS;
+}
+
+/*
+ * index -1 applies msgStatus (read / unread) to every received message whose
+ * mirrored status differs. All record writes are queued back to back and a
+ * single response is sent once the last one completes.
+ */
+static TReturn set_msg_status(CoreObject *obj, UserRequest *ur)
+{
+	const struct treq_sms_set_msg_status *msg_status = NULL;
+	struct s_sms_property *sp = NULL;
+	struct s_sms_efsms_record *rec = NULL;
+	struct s_sms_status_batch *batch = NULL;
+	struct tresp_sms_set_msg_status respMsgStatus = {0, };
+	UserRequest *dup_ur = NULL;
+	unsigned char status = 0;
+	TReturn ret = TCORE_RETURN_SUCCESS;
+	int i = 0;
+
+	dbg("Entry");
+
+	msg_status = tcore_user_request_ref_data(ur, NULL);
+	sp = util_sms_ref_property(obj);
+	if (NULL == msg_status || NULL == sp || NULL == tcore_object_get_hal(obj)) {
+		err("NULL input. Unable to proceed");
+
+		dbg("Exit");
+		return TCORE_RETURN_EINVAL;
+	}
+
+	dbg("msgStatus: [%d], index: [%d]", msg_status->msgStatus, msg_status->index);
+	status = util_sms_encode_efsms_status(msg_status->msgStatus);
+
+	if (msg_status->index == -1) {
+		if ((status != SMS_EFSMS_STATUS_READ && status != SMS_EFSMS_STATUS_UNREAD) || FALSE == sp->b_efsms_synced) {
+			err("Batch update needs read/unread status and a synchronised EF-SMS");
+
+			dbg("Exit");
+			return TCORE_RETURN_EINVAL;
+		}
+	} else {
+		rec = util_sms_ref_efsms(obj, msg_status->index);
+		if (NULL == rec) {
+			err("Invalid index");
+
+			dbg("Exit");
+			return TCORE_RETURN_EINVAL;
+		}
+	}
+
+	batch = g_try_new0(struct s_sms_status_batch, 1);
+	if (NULL == batch) {
+		err("Out of memory. Unable to proceed");
+
+		dbg("Exit");
+		return TCORE_RETURN_ENOMEM;
+	}
+	batch->result = SMS_SENDSMS_SUCCESS;
+
+	if (rec) {
+		if (rec->b_status_valid && rec->status == status) {
+			dbg("Status already set on the SIM");
+		} else {
+			ret = _start_efsms_status_update(obj, ur, batch, msg_status->index, status);
+		}
+	} else {
+		for (i = 0; i < SMS_GSM_SMS_MSG_NUM_MAX; i++) {
+			rec = &sp->efsms[i];
+			if (FALSE == rec->b_status_valid || rec->status == status
+				|| (rec->status != SMS_EFSMS_STATUS_READ && rec->status != SMS_EFSMS_STATUS_UNREAD))
+				continue;
+
+			dup_ur = (batch->outstanding == 0) ? ur : tcore_user_request_ref(ur);
+			ret = _start_efsms_status_update(obj, dup_ur, batch, i, status);
+			if (TCORE_RETURN_SUCCESS != ret) {
+				if (dup_ur != ur)
+					tcore_user_request_unref(dup_ur);
+				break;
+			}
+		}
+	}
+
+	if (batch->outstanding > 0) {
+		// Records already queued will report the failure
+		if (TCORE_RETURN_SUCCESS != ret)
+			batch->result = SMS_DEVICE_FAILURE;
+
+		dbg("Exit");
+		return TCORE_RETURN_SUCCESS;
+	}
+
+	g_free(batch);
+
+	if (TCORE_RETURN_SUCCESS != ret) {
+		dbg("Exit");
+		return ret;
+	}
+
+	respMsgStatus.result = SMS_SENDSMS_SUCCESS;
+	tcore_user_request_send_response(ur, TRESP_SMS_SET_MSG_STATUS, sizeof(struct tresp_sms_set_msg_status), &respMsgStatus);
+
 	dbg("Exit");
 	return TCORE_RETURN_SUCCESS;
 }
@@ -2930,7 +3476,8 @@ static TReturn get_sms_params(CoreObject *obj, UserRequest *ur)
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
 	const struct treq_sms_get_params *getSmsParams = NULL;
-	int record_len = 0, *smsp_record_len = NULL;
+	struct s_sms_property *sp = NULL;
+	int record_len = 0;
 
 	dbg("Entry");
 
@@ -2944,9 +3491,25 @@ static TReturn get_sms_params(CoreObject *obj, UserRequest *ur)
 		return TCORE_RETURN_EINVAL;
 	}
 
-	smsp_record_len = tcore_plugin_ref_property(tcore_object_ref_plugin(obj), "SMSPRECORDLEN");
-	record_len = *smsp_record_len;
-	dbg("record len from property %d", record_len);
+	sp = util_sms_ref_property(obj);
+	if (sp && getSmsParams->index >= 0 && getSmsParams->index < SMS_SMSP_CACHE_RECORD_MAX
+		&& sp->smsp.b_params_valid[getSmsParams->index]) {
+		struct tresp_sms_get_params respGetParams;
+
+		dbg("index: [%d] served from cache", getSmsParams->index);
+
+		memset(&respGetParams, 0, sizeof(struct tresp_sms_get_params));
+		memcpy(&respGetParams.paramsInfo, &sp->smsp.params[getSmsParams->index], sizeof(struct telephony_sms_Params));
+		respGetParams.result = SMS_SENDSMS_SUCCESS;
+		tcore_user_request_send_response(ur, TRESP_SMS_GET_PARAMS, sizeof(struct tresp_sms_get_params), &respGetParams);
+
+		dbg("Exit");
+		return TCORE_RETURN_SUCCESS;
+	}
+
+	if (sp)
+		record_len = sp->smsp.record_len;
+	dbg("record len from cache %d", record_len);
 
 	// AT+CRSM=command>[,<fileid>[,<P1>,<P2>,<P3>[,<data>[,<pathid>]]]]
 	cmd_str = g_strdup_printf("AT+CRSM=178,28482,%d,4,%d", (getSmsParams->index + 1), record_len);
@@ -2971,7 +3534,7 @@ static TReturn get_sms_params(CoreObject *obj, UserRequest *ur)
 	util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 	tcore_pending_set_request_data(pending, 0, atreq);
-	tcore_pending_set_response_callback(pending, on_response_get_sms_params, NULL);
+	tcore_pending_set_response_callback(pending, on_response_get_sms_params, (void *) (uintptr_t) getSmsParams->index);
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
 	tcore_hal_send_request(hal, pending);
@@ -3044,7 +3607,7 @@ static TReturn set_sms_params(CoreObject *obj, UserRequest *ur)
 	util_hex_dump("    ", strlen(cmd_str), (void *) cmd_str);
 
 	tcore_pending_set_request_data(pending, 0, atreq);
-	tcore_pending_set_response_callback(pending, on_response_set_sms_params, NULL);
+	tcore_pending_set_response_callback(pending, on_response_set_sms_params, (void *) (uintptr_t) setSmsParams->params.recordIndex);
 	tcore_pending_link_user_request(pending, ur);
 	tcore_pending_set_send_callback(pending, on_confirmation_sms_message_send, NULL);
 	tcore_hal_send_request(hal, pending);
@@ -3062,6 +3625,7 @@ static TReturn get_paramcnt(CoreObject *obj, UserRequest *ur)
 	TcoreHal *hal = NULL;
 	TcoreATRequest *atreq = NULL;
 	TcorePending *pending = NULL;
+	struct s_sms_property *sp = NULL;
 
 	dbg("Entry");
 
@@ -3073,6 +3637,20 @@ static TReturn get_paramcnt(CoreObject *obj, UserRequest *ur)
 		return TCORE_RETURN_EINVAL;
 	}
 
+	sp = util_sms_ref_property(obj);
+	if (sp && sp->smsp.b_meta_valid) {
+		struct tresp_sms_get_paramcnt respGetParamCnt = {0, };
+
+		dbg("recordCount: [%d] served from cache", sp->smsp.record_count);
+
+		respGetParamCnt.recordCount = sp->smsp.record_count;
+		respGetParamCnt.result = SMS_SUCCESS;
+		tcore_user_request_send_response(ur, TRESP_SMS_GET_PARAMCNT, sizeof(struct tresp_sms_get_paramcnt), &respGetParamCnt);
+
+		dbg("Exit");
+		return TCORE_RETURN_SUCCESS;
+	}
+
 	// AT+CRSM=command>[,<fileid>[,<P1>,<P2>,<P3>[,<data>[,<pathid>]]]]
 	cmd_str = g_strdup_printf("AT+CRSM=192,28482");
 	atreq = tcore_at_request_new((const char *) cmd_str, "+CRSM", TCORE_AT_SINGLELINE);
@@ -3130,7 +3708,7 @@ gboolean s_sms_init(TcorePlugin *plugin, TcoreHal *hal)
 	CoreObject *obj = NULL;
 	struct property_sms_info *data = NULL;
 	GQueue *work_queue = NULL;
-	int *smsp_record_len = NULL;
+	struct s_sms_property *sp = NULL;
 
 	dbg("Entry");
 	dbg("plugin: [%p]", plugin);
@@ -3165,9 +3743,15 @@ gboolean s_sms_init(TcorePlugin *plugin, TcoreHal *hal)
 
 	tcore_plugin_link_property(plugin, "SMS", data);
 
-	// storing smsp record length
-	smsp_record_len = calloc(sizeof(int), 1);
-	tcore_plugin_link_property(plugin, "SMSPRECORDLEN", smsp_record_len);
+	// plugin side SMS state (caches)
+	sp = calloc(sizeof(struct s_sms_property), 1);
+	if (sp)
+		sp->pda_mem_status = -1;
+	tcore_plugin_link_property(plugin, "SMSPROPERTY", sp);
+
+	// SIM backed caches follow the SIM state
+	tcore_server_add_notification_hook(tcore_plugin_ref_server(plugin), TNOTI_SIM_STATUS, on_hook_sim_status, obj);
+	tcore_server_add_notification_hook(tcore_plugin_ref_server(plugin), TNOTI_MODEM_POWER, on_hook_modem_power, obj);
 
 	dbg("Exit");
 	return TRUE;
@@ -3177,6 +3761,7 @@ void s_sms_exit(TcorePlugin *plugin)
 {
 	CoreObject *obj = NULL;
 	struct property_sms_info *data = NULL;
+	struct s_sms_property *sp = NULL;
 
 	dbg("Entry");
 	dbg("plugin: [%p]", plugin);
@@ -3186,11 +3771,18 @@ void s_sms_exit(TcorePlugin *plugin)
 		err("NULL core object. Nothing to do.");
 		return;
 	}
+	tcore_server_remove_notification_hook(tcore_plugin_ref_server(plugin), on_hook_sim_status);
+	tcore_server_remove_notification_hook(tcore_plugin_ref_server(plugin), on_hook_modem_power);
 	tcore_sms_free(obj);
 
 	data = tcore_plugin_ref_property(plugin, "SMS");
 	util_sms_free_memory(data);
 
+	sp = tcore_plugin_ref_property(plugin, "SMSPROPERTY");
+	if (sp && sp->dr_expiry_id)
+		g_source_remove(sp->dr_expiry_id);
+	util_sms_free_memory(sp);
+
 	dbg("Exit");
 	return;
 }
@@ -596,7 +596,6 @@ static void on_response_ss_barring_set(TcorePending *p, int data_len, const void
 	UserRequest *ur_dup = 0;
 	GSList *tokens = NULL;
 	const char *line;
-	int err;
 	const TcoreATResponse *response;
 
 	dbg("function enter");
@@ -619,9 +618,7 @@ static void on_response_ss_barring_set(TcorePending *p, int data_len, const void
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -658,7 +655,6 @@ static void on_response_ss_barring_change_pwd(TcorePending *p, int data_len, con
 	struct ss_confirm_info *info = 0;
 	UserRequest *ur;
 	struct tresp_ss_general resp;
-	int err;
 	GSList *tokens = NULL;
 	const char *line;
 
@@ -679,9 +675,7 @@ static void on_response_ss_barring_change_pwd(TcorePending *p, int data_len, con
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -704,7 +698,6 @@ static void on_response_ss_forwarding_set(TcorePending *p, int data_len, const v
 	struct tresp_ss_general resp;
 	GSList *tokens = NULL;
 	const char *line;
-	int err;
 	const TcoreATResponse *response;
 
 	dbg("function enter");
@@ -728,9 +721,7 @@ static void on_response_ss_forwarding_set(TcorePending *p, int data_len, const v
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// / TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 
 		tcore_at_tok_free(tokens);
@@ -772,7 +763,6 @@ static void on_response_ss_waiting_set(TcorePending *p, int data_len, const void
 	struct tresp_ss_general resp;
 	GSList *tokens = NULL;
 	const char *line;
-	int err;
 	const TcoreATResponse *response;
 
 	dbg("function enter");
@@ -795,9 +785,7 @@ static void on_response_ss_waiting_set(TcorePending *p, int data_len, const void
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// / TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -827,7 +815,6 @@ static void on_confirmation_ss_ussd(TcorePending *p, int data_len, const void *d
 	UserRequest *ur = NULL, *ussd_ur = NULL;
 	GSList *tokens = NULL;
 	const char *line;
-	int err;
 	UssdSession *ussd_s = NULL;
 	enum tcore_ss_ussd_type type = TCORE_SS_USSD_TYPE_MAX;
 	const TcoreATResponse *response;
@@ -863,9 +850,7 @@ static void on_confirmation_ss_ussd(TcorePending *p, int data_len, const void *d
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -901,7 +886,7 @@ static void on_confirmation_ss_ussd(TcorePending *p, int data_len, const void *d
 static void on_response_ss_barring_get(TcorePending *p, int data_len, const void *data, void *user_data)
 {
 	UserRequest *ur = 0;
-	int status = 0, classx = 0, err = 0;
+	int status = 0, classx = 0;
 	GSList *respdata;
 	struct ss_confirm_info *info = 0;
 	struct tresp_ss_barring resp;
@@ -1055,9 +1040,7 @@ error:
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -1080,7 +1063,7 @@ error:
 static void on_response_ss_forwarding_get(TcorePending *p, int data_len, const void *data, void *user_data)
 {
 	UserRequest *ur = 0;
-	int classx = 0, err = 0, time = 0;
+	int classx = 0, time = 0;
 	char *num;
 	struct ss_confirm_info *info = 0;
 	struct tresp_ss_forwarding resp;
@@ -1221,9 +1204,7 @@ error:
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			/* TODO: CMEE error mapping is required. */
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -1245,7 +1226,7 @@ static void on_response_ss_waiting_get(TcorePending *p, int data_len, const void
 {
 	UserRequest *ur = 0;
 	GSList *respdata, *tokens = NULL;
-	int classx = 0, err = 0;
+	int classx = 0;
 	struct ss_confirm_info *info = 0;
 	struct tresp_ss_waiting resp;
 	int countRecords = 0, countValidRecords = 0;
@@ -1360,9 +1341,7 @@ error:
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}
@@ -1387,7 +1366,6 @@ static void on_response_ss_cli_get(TcorePending *p, int data_len, const void *da
 	struct tresp_ss_cli resp;
 	enum telephony_ss_cli_type *p_type = NULL;
 	char *line = NULL, *status;
-	int err = FALSE;
 	int cli_adj, stat;
 	GSList *tokens = NULL;
 	const TcoreATResponse *response;
@@ -1466,9 +1444,7 @@ static void on_response_ss_cli_get(TcorePending *p, int data_len, const void *da
 			dbg("err cause not specified or string corrupted");
 			resp.err = TCORE_RETURN_3GPP_ERROR;
 		} else {
-			err = atoi(g_slist_nth_data(tokens, 0));
-			// TODO: CMEE error mapping is required.
-			resp.err = TCORE_RETURN_3GPP_ERROR;
+			resp.err = util_at_error_result(line);
 		}
 		tcore_at_tok_free(tokens);
 	}